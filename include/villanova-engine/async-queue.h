@@ -34,6 +34,16 @@ typedef struct _VAsyncQueuePriv VAsyncQueuePriv;
 
 
 
+/**
+ * VDestroyFunc:
+ * @data: void* casted data being removed.
+ *
+ * Callback prototype used to release data drained from a queue.
+ */
+typedef void VDestroyFunc (void *data);
+
+
+
 /**
  * VAsyncQueue:
  * @length: the amount of nodes in the queue.
@@ -64,5 +74,36 @@ void  v_async_queue_enqueue_wait (VAsyncQueue *queue, void *data);
 void *v_async_queue_dequeue_wait (VAsyncQueue *queue);
 
 
+bool  v_async_queue_enqueue_timed (VAsyncQueue *queue, void *data, double timeout);
+void *v_async_queue_dequeue_timed (VAsyncQueue *queue, double timeout);
+
+
+
+unsigned int v_async_queue_enqueue_many (VAsyncQueue *queue,
+                                         void **data,
+                                         unsigned int count);
+
+unsigned int v_async_queue_dequeue_many (VAsyncQueue *queue,
+                                         void **data,
+                                         unsigned int max);
+
+
+void v_async_queue_enqueue_many_wait (VAsyncQueue *queue,
+                                      void **data,
+                                      unsigned int count);
+
+unsigned int v_async_queue_dequeue_many_wait (VAsyncQueue *queue,
+                                              void **data,
+                                              unsigned int max);
+
+unsigned int v_async_queue_dequeue_many_timed (VAsyncQueue *queue,
+                                               void **data,
+                                               unsigned int max,
+                                               double timeout);
+
+
+unsigned int v_async_queue_drain (VAsyncQueue *queue, VDestroyFunc *func);
+
+
 
 #endif /* V_ASYNC_QUEUE_H_ */
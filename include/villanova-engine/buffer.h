@@ -93,7 +93,8 @@ VBuffer *v_buffer_new  (uint8_t    *buffer,
 
 
 void v_buffer_free (VBuffer *buffer);
-void v_buffer_skip (VBuffer *buffer, int length);
+void v_buffer_skip  (VBuffer *buffer, int length);
+void v_buffer_reset (VBuffer *buffer);
 
 
 /* buffer reading functions */
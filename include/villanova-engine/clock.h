@@ -30,14 +30,17 @@
 #include <villanova-engine/frame.h>
 
 
-typedef struct _VClock     VClock;
-typedef struct _VClockPriv VClockPriv;
+typedef struct _VClock      VClock;
+typedef struct _VClockPriv  VClockPriv;
+typedef struct _VClockStats VClockStats;
 
 
 /**
  * VClock:
  *
- * Internal timer for frame synchronisation.
+ * Internal timer for frame synchronisation. Presentation timestamps are
+ * mapped onto the monotonic clock, starting from the first one seen, and
+ * the mapping follows the audio device when it reports its position.
  */
 struct _VClock
 {
@@ -47,11 +50,52 @@ struct _VClock
 
 
 
+/**
+ * VClockStats:
+ * @presented: the amount of pictures presented.
+ * @late: pictures presented over a millisecond after their deadline.
+ * @early: pictures presented over a millisecond before their deadline.
+ * @mean_error: the mean distance from the deadline, in microseconds.
+ * @max_late: the furthest past a deadline, in microseconds.
+ * @max_early: the furthest ahead of a deadline, in microseconds.
+ * @audio_error: how far behind the timeline the audio device was at the
+ * last v_clock_set_audio(), in microseconds.
+ *
+ * How accurately pictures were presented by a #VClock.
+ */
+struct _VClockStats
+{
+	unsigned int presented;
+	unsigned int late;
+	unsigned int early;
+	
+	double mean_error;
+	double max_late;
+	double max_early;
+	
+	double audio_error;
+};
+
+
+
 VClock *v_clock_new  (VError *error);
 void    v_clock_free (VClock *clock);
 
 
+void v_clock_reset (VClock *clock);
+
+
 double v_clock_get_timeout (VClock *clock, VFrameRaw *frame);
+double v_clock_get_delay   (VClock *clock, int64_t pts);
+double v_clock_present     (VClock *clock, int64_t pts);
+
+void v_clock_set_audio (VClock *clock, int64_t pts, double delay);
+
+
+void v_clock_get_stats (VClock *clock, VClockStats *stats);
+
+
+int64_t v_clock_pts_diff (int64_t a, int64_t b);
 
 
 
@@ -0,0 +1,80 @@
+/***************************************************************************
+ *            codec-parallel.h
+ *
+ *  Oct 19, 2026 6:38:24 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_CODEC_PARALLEL_H_
+#define V_CODEC_PARALLEL_H_
+
+
+#include <villanova-engine/error.h>
+#include <villanova-engine/frame.h>
+#include <villanova-engine/codec-types.h>
+
+
+
+typedef struct _VCodecParallel     VCodecParallel;
+typedef struct _VCodecParallelPriv VCodecParallelPriv;
+
+
+
+/**
+ * VCodecParallel:
+ * @id: the codec id.
+ * @threads: the amount of decoders running concurrently.
+ *
+ * Decodes a video stream on several #VCodec instances at once by splitting
+ * it into segments at GOP boundaries. Segments starting with an open GOP are
+ * primed with the preceding GOP, which is decoded again and then discarded,
+ * so that every picture references the correct frames. Decoded frames are
+ * returned in display order.
+ *
+ * This is meant for offline jobs where throughput matters more than latency,
+ * since a whole segment must be decoded before any of its frames are
+ * available.
+ */
+struct _VCodecParallel
+{
+	VCodecID id;
+	int threads;
+	
+	/*< private >*/
+	VCodecParallelPriv *priv;
+};
+
+
+
+
+VCodecParallel *v_codec_parallel_new  (VCodecID id, int threads, VError *error);
+void            v_codec_parallel_free (VCodecParallel *parallel);
+
+
+void v_codec_parallel_push   (VCodecParallel *parallel, VFrameRaw *frame);
+void v_codec_parallel_finish (VCodecParallel *parallel);
+
+
+VFrameVideo *v_codec_parallel_pop      (VCodecParallel *parallel);
+VFrameVideo *v_codec_parallel_try_pop  (VCodecParallel *parallel);
+
+
+
+#endif /* V_CODEC_PARALLEL_H_ */
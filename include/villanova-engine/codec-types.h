@@ -26,6 +26,9 @@
 #define V_CODEC_TYPES_H_
 
 
+#include <stdbool.h>
+
+
 #define V_FOURCC(a,b,c,d) ((a << 24) | (b << 16) | (c << 8) | d)
 
 
@@ -59,6 +62,11 @@ enum _VSampleFormat
  * VPixelFormat:
  * @V_PIXEL_FORMAT_UNKNOWN: unsupported pixel format.
  * @V_PIXEL_FORMAT_YUV420: YCbCr 4:2:0.
+ * @V_PIXEL_FORMAT_RGB32: packed native endian ARGB.
+ * @V_PIXEL_FORMAT_PAL8: 8 bit palette indices with a 256 entry RGB32 palette.
+ * @V_PIXEL_FORMAT_NV12: YCbCr 4:2:0 with interleaved chroma.
+ * @V_PIXEL_FORMAT_YUY2: packed YCbCr 4:2:2 ordered Y0 U Y1 V.
+ * @V_PIXEL_FORMAT_UYVY: packed YCbCr 4:2:2 ordered U Y0 V Y1.
  *
  * The pixel format of the video codec.
  */
@@ -66,7 +74,11 @@ enum _VPixelFormat
 {
 	V_PIXEL_FORMAT_UNKNOWN,
 	V_PIXEL_FORMAT_YUV420,
-	V_PIXEL_FORMAT_RGB32
+	V_PIXEL_FORMAT_RGB32,
+	V_PIXEL_FORMAT_PAL8,
+	V_PIXEL_FORMAT_NV12,
+	V_PIXEL_FORMAT_YUY2,
+	V_PIXEL_FORMAT_UYVY
 };
 
 
@@ -126,6 +138,14 @@ VCodecType v_codec_id_type (VCodecID id);
 char *v_codec_id_string (VCodecID id);
 
 
+bool v_pixel_format_get_plane (VPixelFormat format,
+                               int plane,
+                               int width,
+                               int height,
+                               int *bytes,
+                               int *lines);
+
+
 
 
 #endif /* V_CODEC_TYPES_H_ */
@@ -38,12 +38,46 @@
 
 typedef struct _VCodec VCodec;
 typedef struct _VCodecProperties VCodecProperties;
+typedef enum   _VCodecMode VCodecMode;
+typedef enum   _VCodecError VCodecError;
+
+
+
+/**
+ * VCodecError:
+ * @V_CODEC_ERROR_UNSUPPORTED: the codec does not support the operation.
+ *
+ * Possible error codes when decoding.
+ */
+enum _VCodecError
+{
+	V_CODEC_ERROR_UNSUPPORTED
+};
+
+
+
+
+/**
+ * VCodecMode:
+ * @V_CODEC_MODE_FULL: decode every frame.
+ * @V_CODEC_MODE_KEYFRAMES: only decode key frames. All other frames are
+ * discarded while parsing so their payloads are never copied or decoded.
+ *
+ * The decoding mode of the codec.
+ */
+enum _VCodecMode
+{
+	V_CODEC_MODE_FULL,
+	V_CODEC_MODE_KEYFRAMES
+};
 
 
 /**
  * VCodec:
  * @type: the type of codec.
  * @id: the codec id.
+ * @mode: the #VCodecMode used when parsing and decoding.
+ * @lowres: the decode scale factor as a power of two reduction.
  *
  * Contains the relevant components to decode a media stream.
  */
@@ -51,12 +85,24 @@ struct _VCodec
 {
 	VCodecType type;
 	VCodecID id;
+	VCodecMode mode;
+	int lowres;
 	
 	
 	/*< interface methods >*/
 	void    (* parse)  (VCodec *codec, VPacket *packet, VQueue *frames);
 	VFrame *(* decode) (VCodec *codec, VFrame *frame, VError *error);
 	
+	int (* decode_batch) (VCodec     *codec,
+	                      VFrameRaw **frames,
+	                      int         count,
+	                      VFrame    **output,
+	                      VError     *error);
+	
+	void (* flush) (VCodec *codec);
+	void (* free)  (VCodec *codec);
+	bool (* set_lowres) (VCodec *codec, int lowres);
+	
 	
 	VCodecProperties *(* properties) (VCodec *codec);
 };
@@ -64,6 +110,18 @@ struct _VCodec
 
 
 
+/**
+ * VCodecProperties:
+ * @channels: the amount of audio channels.
+ * @sample_rate: the audio sample rate.
+ * @sample_format: the audio #VSampleFormat.
+ * @width: the width of decoded pictures, after any lowres reduction.
+ * @height: the height of decoded pictures, after any lowres reduction.
+ * @pixel_format: the #VPixelFormat of decoded pictures.
+ * @lowres: the decode scale factor in use.
+ *
+ * Stream properties detected by a codec.
+ */
 struct _VCodecProperties
 {
 	int channels;
@@ -73,6 +131,8 @@ struct _VCodecProperties
 	int width;
 	int height;
 	VPixelFormat pixel_format;
+	
+	int lowres;
 };
 
 
@@ -84,6 +144,17 @@ void    v_codec_free (VCodec *codec);
 
 void    v_codec_parse  (VCodec *codec, VPacket *packet, VQueue *frames);
 VFrame *v_codec_decode (VCodec *codec, VFrame *frame, VError *error);
+void    v_codec_flush  (VCodec *codec);
+
+int v_codec_decode_batch (VCodec     *codec,
+                          VFrameRaw **frames,
+                          int         count,
+                          VFrame    **output,
+                          VError     *error);
+
+
+void v_codec_set_mode   (VCodec *codec, VCodecMode mode);
+bool v_codec_set_lowres (VCodec *codec, int lowres);
 
 
 
@@ -29,12 +29,36 @@
 #include <villanova-engine/error.h>
 #include <villanova-engine/frame.h>
 #include <villanova-engine/codec-types.h>
+#include <villanova-engine/convert.h>
 
 
 
 typedef struct _VColorspace     VColorspace;
 typedef struct _VColorspacePriv VColorspacePriv;
 
+typedef struct _VColorspaceCache     VColorspaceCache;
+typedef struct _VColorspaceCachePriv VColorspaceCachePriv;
+
+typedef enum _VScalePreset VScalePreset;
+
+
+
+/**
+ * VScalePreset:
+ * @V_SCALE_PRESET_FAST_BILINEAR: quickest scaling, for previews.
+ * @V_SCALE_PRESET_AREA: averages the covered source pixels, suited to large
+ * reductions such as thumbnails.
+ * @V_SCALE_PRESET_BICUBIC: sharpest scaling, the default.
+ *
+ * The quality and speed trade off used when scaling pictures.
+ */
+enum _VScalePreset
+{
+	V_SCALE_PRESET_FAST_BILINEAR,
+	V_SCALE_PRESET_AREA,
+	V_SCALE_PRESET_BICUBIC
+};
+
 
 
 /**
@@ -51,20 +75,77 @@ struct _VColorspace
 
 
 
+/**
+ * VColorspaceCache:
+ *
+ * Keeps recently used colorspaces around so that repeated conversions with
+ * the same formats and size reuse the same conversion context.
+ */
+struct _VColorspaceCache
+{
+	/*< private >*/
+	VColorspaceCachePriv *priv;
+};
+
+
+
+
 VColorspace *v_colorspace_new (VPixelFormat src,
                                VPixelFormat dest,
                                int width,
                                int height,
                                VError *error);
 
+VColorspace *v_colorspace_new_scaled (VPixelFormat src,
+                                      VPixelFormat dest,
+                                      int width,
+                                      int height,
+                                      int dest_width,
+                                      int dest_height,
+                                      VScalePreset preset,
+                                      VError *error);
+
 
 
 void v_colorspace_free (VColorspace *colorspace);
 
 
+void v_colorspace_set_matrix  (VColorspace *colorspace, VColorMatrix matrix);
+void v_colorspace_set_threads (VColorspace *colorspace, int threads);
+
+
 
 VFrame *v_colorspace_convert (VColorspace *colorspace, VFrame *frame);
 
+void v_colorspace_convert_into (VColorspace *colorspace,
+                                VFrame *frame,
+                                uint8_t *dest[4],
+                                int dest_linesize[4]);
+
+
+
+
+VColorspaceCache *v_colorspace_cache_new  (unsigned int size);
+void              v_colorspace_cache_free (VColorspaceCache *cache);
+
+
+VColorspace *v_colorspace_cache_get (VColorspaceCache *cache,
+                                     VPixelFormat src,
+                                     VPixelFormat dest,
+                                     int width,
+                                     int height,
+                                     VError *error);
+
+VColorspace *v_colorspace_cache_get_scaled (VColorspaceCache *cache,
+                                            VPixelFormat src,
+                                            VPixelFormat dest,
+                                            int width,
+                                            int height,
+                                            int dest_width,
+                                            int dest_height,
+                                            VScalePreset preset,
+                                            VError *error);
+
 
 
 #endif /* V_COLORSPACE_H_ */
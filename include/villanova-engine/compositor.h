@@ -0,0 +1,73 @@
+/***************************************************************************
+ *            compositor.h
+ *
+ *  Oct 19, 2026 6:50:59 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_COMPOSITOR_H_
+#define V_COMPOSITOR_H_
+
+
+#include <villanova-engine/frame.h>
+#include <villanova-engine/convert.h>
+
+
+typedef struct _VCompositor     VCompositor;
+typedef struct _VCompositorPriv VCompositorPriv;
+
+
+
+/**
+ * VCompositor:
+ *
+ * Alpha blends a subpicture over YUV video frames, either planar, NV12 or
+ * packed 4:2:2. Only the area covered by the subpicture is touched, so the
+ * cost follows the subpicture size.
+ */
+struct _VCompositor
+{
+	/*< private >*/
+	VCompositorPriv *priv;
+};
+
+
+
+
+VCompositor *v_compositor_new  (void);
+void         v_compositor_free (VCompositor *compositor);
+
+
+void v_compositor_set_matrix     (VCompositor *compositor, VColorMatrix matrix);
+void v_compositor_set_subpicture (VCompositor *compositor, VFrameSubtitle *subpic);
+
+bool v_compositor_set_kernel (const char *name);
+
+
+void v_compositor_blend (VCompositor *compositor,
+                         VPixelFormat format,
+                         uint8_t *data[4],
+                         int linesize[4],
+                         int width,
+                         int height);
+
+
+
+#endif /* V_COMPOSITOR_H_ */
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *            convert.h
+ *
+ *  Oct 19, 2026 6:46:44 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_CONVERT_H_
+#define V_CONVERT_H_
+
+
+#include <villanova-engine/codec-types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+typedef enum _VColorMatrix VColorMatrix;
+
+
+
+/**
+ * VColorMatrix:
+ * @V_COLOR_MATRIX_BT601: ITU-R BT.601, used by standard definition video.
+ * @V_COLOR_MATRIX_BT709: ITU-R BT.709, used by high definition video.
+ *
+ * The matrix used to convert between YUV and RGB. Both use the limited
+ * 16-235 luma range.
+ */
+enum _VColorMatrix
+{
+	V_COLOR_MATRIX_BT601,
+	V_COLOR_MATRIX_BT709
+};
+
+
+
+
+void v_convert_yuv420_to_rgb32 (uint8_t *src[4],
+                                int src_linesize[4],
+                                uint8_t *dest[4],
+                                int dest_linesize[4],
+                                int width,
+                                int height,
+                                VColorMatrix matrix);
+
+void v_convert_rgb32_to_yuv420 (uint8_t *src[4],
+                                int src_linesize[4],
+                                uint8_t *dest[4],
+                                int dest_linesize[4],
+                                int width,
+                                int height,
+                                VColorMatrix matrix);
+
+
+void v_convert_yuv420_to_nv12 (uint8_t *src[4],
+                               int src_linesize[4],
+                               uint8_t *dest[4],
+                               int dest_linesize[4],
+                               int width,
+                               int height);
+
+void v_convert_yuv420_to_yuy2 (uint8_t *src[4],
+                               int src_linesize[4],
+                               uint8_t *dest[4],
+                               int dest_linesize[4],
+                               int width,
+                               int height);
+
+void v_convert_yuv420_to_uyvy (uint8_t *src[4],
+                               int src_linesize[4],
+                               uint8_t *dest[4],
+                               int dest_linesize[4],
+                               int width,
+                               int height);
+
+
+bool v_convert_supported (VPixelFormat src, VPixelFormat dest);
+
+bool v_convert_picture (VPixelFormat src_format,
+                        uint8_t *src[4],
+                        int src_linesize[4],
+                        VPixelFormat dest_format,
+                        uint8_t *dest[4],
+                        int dest_linesize[4],
+                        int width,
+                        int height,
+                        VColorMatrix matrix);
+
+
+void v_convert_pixel_rgb32_to_yuv (uint32_t pixel,
+                                   uint8_t *y,
+                                   uint8_t *u,
+                                   uint8_t *v,
+                                   VColorMatrix matrix);
+
+
+const char *v_convert_kernel_string (void);
+bool        v_convert_set_kernel    (const char *name);
+
+
+
+#endif /* V_CONVERT_H_ */
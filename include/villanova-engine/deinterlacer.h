@@ -0,0 +1,97 @@
+/***************************************************************************
+ *            deinterlacer.h
+ *
+ *  Oct 19, 2026 6:53:00 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_DEINTERLACER_H_
+#define V_DEINTERLACER_H_
+
+
+#include <villanova-engine/codec-types.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+typedef enum   _VDeinterlaceMode VDeinterlaceMode;
+
+typedef struct _VDeinterlacer     VDeinterlacer;
+typedef struct _VDeinterlacerPriv VDeinterlacerPriv;
+
+
+
+/**
+ * VDeinterlaceMode:
+ * @V_DEINTERLACE_MODE_NONE: leave interlaced pictures untouched.
+ * @V_DEINTERLACE_MODE_BOB: rebuild the second field from the first one.
+ * @V_DEINTERLACE_MODE_BLEND: blend both fields with a vertical filter.
+ * @V_DEINTERLACE_MODE_ADAPTIVE: keep both fields where the picture is still
+ * and rebuild the second field where it moves.
+ *
+ * How interlaced pictures are turned into progressive ones.
+ */
+enum _VDeinterlaceMode
+{
+	V_DEINTERLACE_MODE_NONE,
+	V_DEINTERLACE_MODE_BOB,
+	V_DEINTERLACE_MODE_BLEND,
+	V_DEINTERLACE_MODE_ADAPTIVE
+};
+
+
+
+
+/**
+ * VDeinterlacer:
+ * @mode: the #VDeinterlaceMode in use.
+ *
+ * Deinterlaces pictures in place.
+ */
+struct _VDeinterlacer
+{
+	VDeinterlaceMode mode;
+	
+	/*< private >*/
+	VDeinterlacerPriv *priv;
+};
+
+
+
+
+VDeinterlacer *v_deinterlacer_new  (VDeinterlaceMode mode);
+void           v_deinterlacer_free (VDeinterlacer *deinterlacer);
+
+
+void v_deinterlacer_set_mode (VDeinterlacer *deinterlacer, VDeinterlaceMode mode);
+void v_deinterlacer_reset    (VDeinterlacer *deinterlacer);
+
+
+void v_deinterlacer_process (VDeinterlacer *deinterlacer,
+                             VPixelFormat format,
+                             uint8_t *data[4],
+                             int linesize[4],
+                             int width,
+                             int height,
+                             bool top_field_first);
+
+
+
+#endif /* V_DEINTERLACER_H_ */
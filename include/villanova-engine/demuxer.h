@@ -59,6 +59,8 @@ enum _VDemuxerError
  * VDemuxer:
  * @buffer: a #VBuffer to read from.
  * @read_packet: interface prototype to read a packet from the input buffer.
+ * @resync: interface prototype to find the next packet boundary after the
+ * buffer moved to an arbitrary position.
  *
  * Demuxes raw data from an input buffer. All demuxer modules must inherit from
  * #VDemuxer and should override the interface prototypes it needs. At the very
@@ -73,6 +75,8 @@ struct _VDemuxer
 	/*< interface methods >*/
 	VPacket *(* read_packet) (VDemuxer *demuxer, VError *error);
 	bool (* open) (VDemuxer *demuxer, VError *error);
+	
+	void (* resync) (VDemuxer *demuxer);
 };
 
 
@@ -118,6 +122,8 @@ VPacket  *v_demuxer_read_packet  (VDemuxer *demuxer, VError *error);
 
 bool v_demuxer_open (VDemuxer *demuxer, VError *error);
 
+void v_demuxer_resync (VDemuxer *demuxer);
+
 
 
 #endif /* V_DEMUXER_H_ */
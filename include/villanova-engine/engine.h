@@ -30,11 +30,34 @@
 #include <villanova-engine/error.h>
 #include <villanova-engine/input.h>
 #include <villanova-engine/output.h>
+#include <villanova-engine/deinterlacer.h>
+#include <villanova-engine/pipeline.h>
 
 
 
-typedef struct _VEngine     VEngine;
-typedef struct _VEnginePriv VEnginePriv;
+typedef struct _VEngine      VEngine;
+typedef struct _VEnginePriv  VEnginePriv;
+typedef struct _VEngineStats VEngineStats;
+typedef struct _VEngineStageStats VEngineStageStats;
+
+
+/* how soon after a seek the first picture should be shown, in seconds */
+#define V_ENGINE_SEEK_TARGET 0.1
+
+/* the demuxer, audio, video, deinterlace, display and subpicture stages */
+#define V_ENGINE_STAGES 6
+
+
+/**
+ * VEngineEosFunc:
+ * @engine: the #VEngine.
+ * @userdata: void* casted user data.
+ *
+ * Callback prototype for the end of stream, once the last frame has been
+ * processed.
+ */
+typedef void VEngineEosFunc (VEngine *engine, void *userdata);
+
 
 
 /**
@@ -56,6 +79,56 @@ struct _VEngine
 
 
 
+/**
+ * VEngineStageStats:
+ * @name: the name of the stage.
+ * @node: the work done by the stage.
+ * @input: the queue feeding the stage, all zero for the demuxer.
+ *
+ * How a stage of the #VEngine pipeline has performed.
+ */
+struct _VEngineStageStats
+{
+	const char *name;
+	
+	VNodeStats node;
+	VLinkStats input;
+};
+
+
+
+/**
+ * VEngineStats:
+ * @seeks: the seeks that went on to show a picture.
+ * @slow_seeks: seeks whose first picture came after %V_ENGINE_SEEK_TARGET.
+ * @seek_latency: the time from the last seek to its first picture, in seconds.
+ * @mean_seek_latency: the mean time from a seek to its first picture.
+ * @max_seek_latency: the longest time from a seek to its first picture.
+ * @pictures: the pictures shown since the title started playing.
+ * @elapsed: the seconds since the title started playing.
+ * @frame_rate: the pictures shown per second over @elapsed.
+ * @stages: the work done by each pipeline stage, and their queues.
+ *
+ * How the playback of a #VEngine has performed.
+ */
+struct _VEngineStats
+{
+	unsigned int seeks;
+	unsigned int slow_seeks;
+	
+	double seek_latency;
+	double mean_seek_latency;
+	double max_seek_latency;
+	
+	unsigned long pictures;
+	double elapsed;
+	double frame_rate;
+	
+	VEngineStageStats stages[V_ENGINE_STAGES];
+};
+
+
+
 void     v_engine_init (void);
 VEngine *v_engine_new  (void);
 void     v_engine_free (VEngine *engine);
@@ -70,6 +143,21 @@ bool v_engine_open  (VEngine    *engine,
 bool v_engine_play  (VEngine *engine, VError *error);
 void v_engine_pause (VEngine *engine);
 void v_engine_stop  (VEngine *engine);
+bool v_engine_seek  (VEngine *engine, double position, VError *error);
+
+
+void v_engine_set_video_mode   (VEngine *engine, VCodecMode mode);
+void v_engine_set_video_lowres (VEngine *engine, int lowres);
+
+void v_engine_set_deinterlace_mode (VEngine *engine, VDeinterlaceMode mode);
+
+void v_engine_set_paced       (VEngine *engine, bool paced);
+void v_engine_set_queue_depth (VEngine *engine, unsigned int min, unsigned int max);
+
+
+void v_engine_register_eos (VEngine *engine, VEngineEosFunc *func, void *userdata);
+
+void v_engine_get_stats (VEngine *engine, VEngineStats *stats);
 
 
 
@@ -42,6 +42,7 @@ typedef enum   _VErrorDomain VErrorDomain;
  * @V_ERROR_DOMAIN_ENGINE: the high level #VEngine domain.
  * @V_ERROR_DOMAIN_INPUT: the #VInput domain.
  * @V_ERROR_DOMAIN_DEMUXER: the #VDemuxer domain.
+ * @V_ERROR_DOMAIN_CODEC: the #VCodec domain.
  *
  * Domains that an error can originate from.
  */
@@ -52,7 +53,8 @@ enum _VErrorDomain
 	V_ERROR_DOMAIN_MODULES,
 	V_ERROR_DOMAIN_ENGINE,
 	V_ERROR_DOMAIN_INPUT,
-	V_ERROR_DOMAIN_DEMUXER
+	V_ERROR_DOMAIN_DEMUXER,
+	V_ERROR_DOMAIN_CODEC
 };
 
 
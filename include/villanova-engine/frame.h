@@ -26,7 +26,9 @@
 #define V_FRAME_H_
 
 
+#include <villanova-engine/codec-types.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 
 /* convenience casting macros */
@@ -37,6 +39,10 @@
 #define V_FRAME_SUBTITLE(o) ((VFrameSubtitle *) o)
 
 
+/* the timestamp of a frame without one */
+#define V_NO_PTS INT64_MIN
+
+
 
 typedef enum _VFrameType VFrameType;
 
@@ -47,6 +53,9 @@ typedef struct _VFrameAudio VFrameAudio;
 typedef struct _VFrameVideo VFrameVideo;
 typedef struct _VFrameSubtitle VFrameSubtitle;
 
+typedef struct _VFramePool     VFramePool;
+typedef struct _VFramePoolPriv VFramePoolPriv;
+
 
 
 /**
@@ -71,12 +80,14 @@ enum _VFrameType
 /**
  * VFrame:
  * @type: the type of the frame.
+ * @ref_count: the amount of references held on the frame.
  *
  * The generic structure for all frames.
  */
 struct _VFrame
 {
 	VFrameType type;
+	int ref_count;
 };
 
 
@@ -88,6 +99,7 @@ struct _VFrame
  * @data: raw frame data.
  * @pts: presentation timestamp.
  * @dts: decoding timestamp.
+ * @key_frame: whether the frame can be decoded without any other frames.
  *
  * A complete frame belonging to the stream specified by @stream_id.
  */
@@ -102,6 +114,8 @@ struct _VFrameRaw
 	
 	int64_t pts;
 	int64_t dts;
+	
+	bool key_frame;
 };
 
 
@@ -126,7 +140,17 @@ struct _VFrameAudio
 /**
  * VFrameVideo:
  * @length: the size of the frame data.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @pixel_format: the #VPixelFormat of @data.
+ * @pts: presentation timestamp, in display order.
+ * @interlaced: whether the picture holds two interlaced fields.
+ * @top_field_first: whether the top field is displayed first.
+ * @linesize: the size of a line for each plane.
  * @data: decoded frame data.
+ * @buffer: the memory owned by the frame backing @data, or %NULL if the
+ * planes are borrowed from a decoder.
+ * @pool: the #VFramePool the frame is recycled into, or %NULL.
  *
  * A decoded video frame.
  */
@@ -135,18 +159,41 @@ struct _VFrameVideo
 	VFrame parent;
 	
 	int length;
+	
+	int width;
+	int height;
+	VPixelFormat pixel_format;
+	
+	int64_t pts;
+	
+	bool interlaced;
+	bool top_field_first;
+	
 	int linesize[4];
 	uint8_t *data[4];
+	
+	uint8_t *buffer;
+	
+	VFramePool *pool;
+	
+	/*< private >*/
+	int pool_index;
 };
 
 
 
 /**
  * VFrameSubtitle:
- * @length: the size of the frame data.
- * @data: decoded frame data.
+ * @x: the horizontal position of the subpicture.
+ * @y: the vertical position of the subpicture.
+ * @w: the subpicture width.
+ * @h: the subpicture height.
+ * @pixel_format: the pixel format of the subpicture planes.
+ * @linesize: the size of each plane line.
+ * @data: decoded subpicture planes.
+ * @buffer: memory owned by the frame, %NULL if the planes are borrowed.
  *
- * A decoded video frame.
+ * A decoded subtitle frame.
  */
 struct _VFrameSubtitle
 {
@@ -154,9 +201,12 @@ struct _VFrameSubtitle
 	
 	int x, y;
 	int w, h;
+	VPixelFormat pixel_format;
 	
 	int linesize[4];
 	uint8_t *data[4];
+	
+	uint8_t *buffer;
 };
 
 
@@ -166,10 +216,46 @@ struct _VFrameSubtitle
 VFrameRaw   *v_frame_raw_new   (int size);
 VFrameAudio *v_frame_audio_new (int size);
 VFrameVideo *v_frame_video_new (void);
+VFrameVideo *v_frame_video_copy (VFrameVideo *frame);
 VFrameSubtitle *v_frame_subtitle_new (void);
+VFrameSubtitle *v_frame_subtitle_copy (VFrameSubtitle *frame);
+
+
+VFrame *v_frame_ref  (VFrame *frame);
+void    v_frame_free (VFrame *frame);
+
+
+
+
+/**
+ * VFramePool:
+ * @pixel_format: the #VPixelFormat of the pooled frames.
+ * @width: the picture width of the pooled frames.
+ * @height: the picture height of the pooled frames.
+ * @size: the size of the planes of each frame, including padding.
+ *
+ * Recycles video frames of one picture layout so that their planes are
+ * only allocated once.
+ */
+struct _VFramePool
+{
+	VPixelFormat pixel_format;
+	int width;
+	int height;
+	int size;
+	
+	/*< private >*/
+	VFramePoolPriv *priv;
+};
+
+
+
 
+VFramePool  *v_frame_pool_new  (VPixelFormat pixel_format, int width, int height);
+void         v_frame_pool_free (VFramePool *pool);
 
-void v_frame_free (VFrame *frame);
+VFrameVideo *v_frame_pool_get  (VFramePool *pool);
+VFrameVideo *v_frame_pool_copy (VFramePool *pool, VFrameVideo *frame);
 
 
 
@@ -71,6 +71,9 @@ typedef void VEosFunc (VInput *input, void *userdata);
  * @eos: indicates whether end of stream has been reached.
  * @open: interface prototype to open a stream.
  * @close: interface prototype to close a stream.
+ * @seek: interface prototype to move to a byte offset, if the source
+ * supports it.
+ * @get_size: interface prototype to get the size in bytes, if known.
  *
  * Handles reading from a media source. All input modules must inherit from
  * #VInput and should override the interface prototypes it needs. At the very
@@ -89,6 +92,9 @@ struct _VInput
 	VBuffer *(* open)  (VInput *input, VError *error);
 	void     (* close) (VInput *input);
 	
+	bool    (* seek)     (VInput *input, int64_t offset);
+	int64_t (* get_size) (VInput *input);
+	
 	
 	/*< private >*/
 	VInputPriv *priv;
@@ -107,6 +113,8 @@ void v_input_close (VInput *input);
 
 VFrameRaw *v_input_read_frame (VInput *input, VError *error);
 
+bool v_input_seek (VInput *input, double position, int64_t *pts, VError *error);
+
 
 
 
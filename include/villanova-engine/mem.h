@@ -48,6 +48,8 @@ void *v_malloc  (size_t length);
 void *v_mallocz (size_t length);
 void *v_realloc (void *ptr, size_t length);
 
+void *v_malloc_aligned (size_t alignment, size_t length);
+
 void v_free (void *ptr);
 
 
@@ -66,8 +66,20 @@ struct _VOutput
 	void (* write) (VOutput *output, VFrame *frame);
 	void (* open)  (VOutput *output, VStream *stream);
 	void (* close) (VOutput *output);
+	void (* free)  (VOutput *output);
 	
 	void (* write_sub) (VOutput *output, VFrame *frame);
+	
+	int (* write_partial) (VOutput *output, VFrame *frame, int offset);
+	
+	bool (* get_buffer) (VOutput *output, uint8_t *data[4], int linesize[4]);
+	void (* present)    (VOutput *output);
+	
+	const VPixelFormat *(* get_formats) (VOutput *output);
+	bool                (* set_format)  (VOutput *output, VPixelFormat format);
+	
+	bool (* get_delay) (VOutput *output, double *delay);
+	void (* flush)     (VOutput *output);
 };
 
 
@@ -84,6 +96,19 @@ void v_output_close (VOutput *output);
 
 void v_output_write_sub (VOutput *output, VFrame *frame);
 
+int v_output_write_partial (VOutput *output, VFrame *frame, int offset);
+
+
+bool v_output_get_buffer (VOutput *output, uint8_t *data[4], int linesize[4]);
+void v_output_present    (VOutput *output);
+
+
+VPixelFormat v_output_negotiate_format (VOutput *output, VPixelFormat source);
+
+
+bool v_output_get_delay (VOutput *output, double *delay);
+void v_output_flush     (VOutput *output);
+
 
 char *v_output_type_string (VOutputType output_type);
 
@@ -0,0 +1,216 @@
+/***************************************************************************
+ *            pipeline.h
+ *
+ *  Oct 19, 2026 7:19:18 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_PIPELINE_H_
+#define V_PIPELINE_H_
+
+
+#include <stdbool.h>
+#include <villanova-engine/frame.h>
+
+
+typedef struct _VPipeline     VPipeline;
+typedef struct _VPipelinePriv VPipelinePriv;
+
+typedef struct _VNode     VNode;
+typedef struct _VNodePriv VNodePriv;
+
+typedef struct _VNodeStats VNodeStats;
+typedef struct _VLinkStats VLinkStats;
+
+
+
+/* the occupancy buckets of a #VLinkStats */
+#define V_LINK_HISTOGRAM 8
+
+
+
+/**
+ * VSourceFunc:
+ * @node: the source #VNode.
+ * @data: void* casted user data.
+ *
+ * Callback prototype for a node producing frames, such as a demuxer. Each
+ * call should emit at most a few frames with v_node_emit() or
+ * v_node_emit_to().
+ *
+ * Returns: %false once the source has nothing left to produce.
+ */
+typedef bool VSourceFunc (VNode *node, void *data);
+
+
+/**
+ * VNodeFunc:
+ * @node: the #VNode.
+ * @frames: the frames taken off one of the node inputs.
+ * @count: the amount of frames in @frames, never more than the node batch.
+ * @data: void* casted user data.
+ *
+ * Callback prototype for a node processing frames. The node owns @frames
+ * and must either free them or emit them to its outputs. A node woken up
+ * after v_node_wait() is called with a @count of 0.
+ */
+typedef void VNodeFunc (VNode *node, VFrame **frames, unsigned int count, void *data);
+
+
+/**
+ * VPipelineFunc:
+ * @pipeline: the #VPipeline.
+ * @data: void* casted user data.
+ *
+ * Callback prototype for pipeline events, such as reaching the end of
+ * stream.
+ */
+typedef void VPipelineFunc (VPipeline *pipeline, void *data);
+
+
+
+
+/**
+ * VNode:
+ * @name: the name of the node.
+ * @hint: the worker the node prefers to run on.
+ * @batch: the most frames handed to the node per call.
+ *
+ * A stage in a #VPipeline. Nodes run as tasks on the default thread pool,
+ * never on two threads at a time, and are connected by bounded queues.
+ */
+struct _VNode
+{
+	const char *name;
+	
+	int hint;
+	unsigned int batch;
+	
+	
+	/*< private >*/
+	VNodePriv *priv;
+};
+
+
+
+/**
+ * VNodeStats:
+ * @calls: the amount of times the node function was called.
+ * @frames_in: the amount of frames the node took off its inputs.
+ * @frames_out: the amount of frames the node emitted.
+ * @busy: the seconds spent in the node function.
+ *
+ * The work done by a #VNode, used to find the stage limiting a pipeline.
+ */
+struct _VNodeStats
+{
+	unsigned long calls;
+	unsigned long frames_in;
+	unsigned long frames_out;
+	
+	double busy;
+};
+
+
+
+/**
+ * VLinkStats:
+ * @depth: the current depth of the queue.
+ * @frames: the amount of frames passed through the queue.
+ * @stalls: the amount of times the queue was full, blocking the producer.
+ * @histogram: the occupancy each frame found on arrival, bucketed by the
+ *   fraction of the depth at the time from empty to full.
+ * @producer_blocked: the seconds the producer waited for room.
+ * @consumer_blocked: the seconds the consumer waited for frames.
+ *
+ * The backpressure on a queue between two nodes. A producer blocked for
+ * long points at a slow consumer, and the other way around.
+ */
+struct _VLinkStats
+{
+	unsigned int depth;
+	
+	unsigned long frames;
+	unsigned long stalls;
+	unsigned long histogram[V_LINK_HISTOGRAM];
+	
+	double producer_blocked;
+	double consumer_blocked;
+};
+
+
+
+/**
+ * VPipeline:
+ *
+ * A graph of nodes passing frames to each other.
+ */
+struct _VPipeline
+{
+	/*< private >*/
+	VPipelinePriv *priv;
+};
+
+
+
+
+VPipeline *v_pipeline_new  (void);
+void       v_pipeline_free (VPipeline *pipeline);
+
+
+VNode *v_pipeline_add_source (VPipeline   *pipeline,
+                              const char  *name,
+                              VSourceFunc *func,
+                              void        *data);
+
+VNode *v_pipeline_add_node (VPipeline  *pipeline,
+                            const char *name,
+                            VNodeFunc  *func,
+                            void       *data);
+
+VNode *v_pipeline_get_node (VPipeline *pipeline, const char *name);
+
+
+void v_pipeline_start (VPipeline *pipeline);
+void v_pipeline_pause (VPipeline *pipeline);
+void v_pipeline_flush (VPipeline *pipeline);
+
+void v_pipeline_set_eos_func (VPipeline *pipeline, VPipelineFunc *func, void *data);
+
+
+
+void v_node_link      (VNode *src, VNode *dest, unsigned int depth);
+bool v_node_set_depth (VNode *src, VNode *dest, unsigned int min, unsigned int max);
+
+bool v_node_get_link_stats (VNode *src, VNode *dest, VLinkStats *stats);
+
+void v_node_set_hint  (VNode *node, int hint);
+void v_node_set_batch (VNode *node, unsigned int batch);
+void v_node_get_stats (VNode *node, VNodeStats *stats);
+
+
+void v_node_wait (VNode *node, double delay);
+
+void v_node_emit    (VNode *node, VFrame *frame);
+void v_node_emit_to (VNode *node, VNode *dest, VFrame *frame);
+
+
+
+#endif /* V_PIPELINE_H_ */
@@ -0,0 +1,78 @@
+/***************************************************************************
+ *            ring.h
+ *
+ *  Oct 19, 2026 7:01:06 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_RING_H_
+#define V_RING_H_
+
+
+#include <stdbool.h>
+
+
+typedef struct _VRing     VRing;
+typedef struct _VRingPriv VRingPriv;
+
+
+
+/**
+ * VRing:
+ * @size: the amount of entries the ring holds.
+ *
+ * A lock-free queue with exactly one producer thread and one consumer
+ * thread. Threads only sleep when the ring is empty or full.
+ */
+struct _VRing
+{
+	unsigned int size;
+	
+	/*< private >*/
+	VRingPriv *priv;
+};
+
+
+
+
+VRing *v_ring_new  (unsigned int size);
+void   v_ring_free (VRing *ring);
+
+
+void v_ring_set_size (VRing *ring, unsigned int size);
+
+
+unsigned int v_ring_length (VRing *ring);
+
+
+bool  v_ring_push (VRing *ring, void *data);
+void *v_ring_pop  (VRing *ring);
+
+
+void  v_ring_push_wait (VRing *ring, void *data);
+void *v_ring_pop_wait  (VRing *ring);
+
+
+unsigned int v_ring_pop_many      (VRing *ring, void **data, unsigned int max);
+unsigned int v_ring_pop_many_wait (VRing *ring, void **data, unsigned int max);
+
+
+
+#endif /* V_RING_H_ */
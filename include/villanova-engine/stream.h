@@ -38,6 +38,7 @@ typedef struct _VStream VStream;
  * VStream:
  * @id: a unique stream id determined by the media format.
  * @codec: a #VCodec capable of decoding the stream's frames.
+ * @lowres: the decode scale factor of the video stream.
  *
  * Contains details of a specific media stream and all the components required
  * to parse and decode it.
@@ -58,6 +59,7 @@ struct _VStream
 	int width;
 	int height;
 	VPixelFormat pixel_format;
+	int lowres;
 };
 
 
@@ -66,6 +68,10 @@ VStream *v_stream_new  (int id, VCodecID codec_id, VError *error);
 void     v_stream_free (VStream *stream);
 
 
+void v_stream_update     (VStream *stream);
+bool v_stream_set_lowres (VStream *stream, int lowres);
+
+
 
 #endif /* V_STREAM_H_ */
  
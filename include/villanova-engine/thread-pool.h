@@ -0,0 +1,78 @@
+/***************************************************************************
+ *            thread-pool.h
+ *
+ *  Oct 19, 2026 6:38:24 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+#ifndef V_THREAD_POOL_H_
+#define V_THREAD_POOL_H_
+
+
+typedef struct _VThreadPool     VThreadPool;
+typedef struct _VThreadPoolPriv VThreadPoolPriv;
+
+
+
+/**
+ * VTaskFunc:
+ * @data: void* casted task data.
+ *
+ * Callback prototype for a task run by a #VThreadPool.
+ */
+typedef void VTaskFunc (void *data);
+
+
+
+
+/**
+ * VThreadPool:
+ * @threads: the amount of worker threads.
+ *
+ * A fixed set of worker threads running queued tasks, stealing work from
+ * each other to stay busy.
+ */
+struct _VThreadPool
+{
+	int threads;
+	
+	/*< private >*/
+	VThreadPoolPriv *priv;
+};
+
+
+
+
+VThreadPool *v_thread_pool_new  (int threads);
+void         v_thread_pool_free (VThreadPool *pool);
+
+
+void v_thread_pool_push    (VThreadPool *pool, VTaskFunc *func, void *data);
+void v_thread_pool_push_to (VThreadPool *pool, int hint, VTaskFunc *func, void *data);
+
+
+VThreadPool *v_thread_pool_get_default (void);
+
+
+int v_thread_pool_cpu_count (void);
+
+
+
+#endif /* V_THREAD_POOL_H_ */
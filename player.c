@@ -25,13 +25,77 @@
 
 
 #include <stdio.h>
-#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
 
 #include <villanova-engine/error.h>
 #include <villanova-engine/engine.h>
 
 
 
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cond  = PTHREAD_COND_INITIALIZER;
+static int finished = 0;
+
+
+
+static void
+print_report (VEngine *engine)
+{
+	VEngineStats stats;
+	unsigned int i, j;
+	
+	
+	v_engine_get_stats (engine, &stats);
+	
+	printf ("-----------------------\n");
+	
+	printf ("EOS - %lu pictures in %.2f s (%.1f frames/s)\n",
+			stats.pictures, stats.elapsed, stats.frame_rate);
+	
+	for (i = 0; i < V_ENGINE_STAGES; i++)
+	{
+		VEngineStageStats *stage = &stats.stages[i];
+		
+		printf ("%-10s frames in=%lu, out=%lu, busy=%.2f s (%.1f%%)\n",
+				stage->name, stage->node.frames_in, stage->node.frames_out,
+				stage->node.busy,
+				stats.elapsed > 0 ? stage->node.busy * 100 / stats.elapsed : 0);
+	}
+	
+	
+	/* the queues show which side waited on the other */
+	for (i = 1; i < V_ENGINE_STAGES; i++)
+	{
+		VLinkStats *link = &stats.stages[i].input;
+		
+		printf ("%-10s queue depth=%u, stalls=%lu, producer blocked=%.2f s, "
+				"consumer blocked=%.2f s, occupancy=",
+				stats.stages[i].name, link->depth, link->stalls,
+				link->producer_blocked, link->consumer_blocked);
+		
+		for (j = 0; j < V_LINK_HISTOGRAM; j++)
+			printf ("%s%lu", j ? "/" : "", link->histogram[j]);
+		
+		printf ("\n");
+	}
+}
+
+
+
+static void
+eos (VEngine *engine, void *userdata)
+{
+	pthread_mutex_lock (&mutex);
+	
+	finished = 1;
+	pthread_cond_signal (&cond);
+	
+	pthread_mutex_unlock (&mutex);
+}
+
+
+
 
 int
 main (int argc, char **argv)
@@ -42,11 +106,17 @@ main (int argc, char **argv)
 
 	VError *err = v_error_new ();
 	VEngine *engine = v_engine_new ();
+	
+	v_engine_register_eos (engine, eos, NULL);
 
 
 	
 	const char *protocol = argv[1];
 	const char *uri = argv[2];
+	
+	/* process the media as fast as possible */
+	if (argc > 3 && strcmp (argv[3], "--unpaced") == 0)
+		v_engine_set_paced (engine, false);
 
 	printf ("Opening Media: %s://%s\n", protocol, uri);
 
@@ -78,7 +148,15 @@ main (int argc, char **argv)
 
 
 
-    sleep (3);
+	/* wait until the whole media was played */
+	pthread_mutex_lock (&mutex);
+	
+	while (!finished)
+		pthread_cond_wait (&cond, &mutex);
+	
+	pthread_mutex_unlock (&mutex);
+	
+	print_report (engine);
 
 
 	printf ("Closing Engine...\n");
@@ -27,6 +27,7 @@
 #include "queue.h"
 #include "mem.h"
 #include <pthread.h>
+#include <time.h>
 
 
 
@@ -61,10 +62,19 @@ v_async_queue_new (unsigned int size)
 	VAsyncQueuePriv *priv = v_new (VAsyncQueuePriv);
 	
 	
+	pthread_condattr_t attr;
+	
+	
+	/* timed waits are measured on the monotonic clock */
+	pthread_condattr_init (&attr);
+	pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+	
 	/* default values */
 	pthread_mutex_init (&priv->mutex, NULL);
-	pthread_cond_init  (&priv->read,  NULL);
-	pthread_cond_init  (&priv->write, NULL);
+	pthread_cond_init  (&priv->read,  &attr);
+	pthread_cond_init  (&priv->write, &attr);
+	
+	pthread_condattr_destroy (&attr);
 	
 	priv->queue = v_queue_new (size);
 	ret->priv = priv;
@@ -102,6 +112,7 @@ v_async_queue_free (VAsyncQueue *queue)
 	
 	
 	v_queue_free (priv->queue);
+	v_free (priv);
 	v_free (queue);
 }
 
@@ -128,6 +139,10 @@ v_async_queue_enqueue (VAsyncQueue *queue, void *data)
 	/* queue the data */
 	bool ret = v_queue_enqueue (priv->queue, data);
 	
+	/* wake up a waiting reader */
+	if (ret)
+		pthread_cond_signal (&priv->read);
+	
 	
 	/* unlock the queue */
 	pthread_mutex_unlock (&priv->mutex);
@@ -159,6 +174,10 @@ v_async_queue_dequeue (VAsyncQueue *queue)
 	/* get the data */
 	void *data = v_queue_dequeue (priv->queue);
 	
+	/* wake up a waiting writer */
+	if (data != NULL)
+		pthread_cond_signal (&priv->write);
+	
 	
 	/* unlock the queue */
 	pthread_mutex_unlock (&priv->mutex);
@@ -283,3 +302,382 @@ v_async_queue_dequeue_wait (VAsyncQueue *queue)
 }
 
 
+
+
+/*
+ * get_deadline:
+ * @timeout: the timeout in seconds.
+ * @deadline: return location for the absolute time.
+ *
+ * Converts a relative timeout into a deadline for pthread_cond_timedwait().
+ */
+static void
+get_deadline (double timeout, struct timespec *deadline)
+{
+	clock_gettime (CLOCK_MONOTONIC, deadline);
+	
+	if (timeout < 0)
+		timeout = 0;
+	
+	deadline->tv_sec  += (time_t) timeout;
+	deadline->tv_nsec += (long) ((timeout - (time_t) timeout) * 1000000000.0);
+	
+	if (deadline->tv_nsec >= 1000000000)
+	{
+		deadline->tv_sec  += 1;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+
+
+
+/*
+ * put_many:
+ * @priv: a locked #VAsyncQueuePriv.
+ * @data: the data to add.
+ * @count: the amount of data.
+ *
+ * Adds as much of @data as fits, waking readers once.
+ *
+ * Returns: the amount added.
+ */
+static unsigned int
+put_many (VAsyncQueuePriv *priv, void **data, unsigned int count)
+{
+	unsigned int i;
+	
+	for (i = 0; i < count; i++)
+		if (!v_queue_enqueue (priv->queue, data[i]))
+			break;
+	
+	
+	if (i == 1)
+		pthread_cond_signal (&priv->read);
+	
+	else if (i > 1)
+		pthread_cond_broadcast (&priv->read);
+	
+	
+	return i;
+}
+
+
+
+
+/*
+ * take_many:
+ * @priv: a locked #VAsyncQueuePriv.
+ * @data: return location for the data.
+ * @max: the most data to take.
+ *
+ * Takes up to @max entries, waking writers once.
+ *
+ * Returns: the amount taken.
+ */
+static unsigned int
+take_many (VAsyncQueuePriv *priv, void **data, unsigned int max)
+{
+	unsigned int i;
+	
+	for (i = 0; i < max; i++)
+		if ((data[i] = v_queue_dequeue (priv->queue)) == NULL)
+			break;
+	
+	
+	if (i == 1)
+		pthread_cond_signal (&priv->write);
+	
+	else if (i > 1)
+		pthread_cond_broadcast (&priv->write);
+	
+	
+	return i;
+}
+
+
+
+
+/**
+ * v_async_queue_enqueue_timed:
+ * @queue: a #VAsyncQueue.
+ * @data: the data to add.
+ * @timeout: the most seconds to wait for space.
+ *
+ * Adds @data to the end of @queue, waiting up to @timeout for space.
+ *
+ * Returns: %true if added, %false if the queue stayed full.
+ */
+bool
+v_async_queue_enqueue_timed (VAsyncQueue *queue, void *data, double timeout)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	struct timespec deadline;
+	bool ret;
+	
+	
+	get_deadline (timeout, &deadline);
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	
+	while ((ret = v_queue_enqueue (priv->queue, data)) == false)
+	{
+		if (pthread_cond_timedwait (&priv->write, &priv->mutex, &deadline) != 0)
+		{
+			/* one last try in case space was made as we timed out */
+			ret = v_queue_enqueue (priv->queue, data);
+			break;
+		}
+	}
+	
+	if (ret)
+		pthread_cond_signal (&priv->read);
+	
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_async_queue_dequeue_timed:
+ * @queue: a #VAsyncQueue.
+ * @timeout: the most seconds to wait for data.
+ *
+ * Gets the next data from @queue, waiting up to @timeout for some.
+ *
+ * Returns: the next void* casted data on the queue, %NULL if none arrived.
+ */
+void *
+v_async_queue_dequeue_timed (VAsyncQueue *queue, double timeout)
+{
+	void *data;
+	
+	if (v_async_queue_dequeue_many_timed (queue, &data, 1, timeout) == 0)
+		return NULL;
+	
+	return data;
+}
+
+
+
+
+
+/**
+ * v_async_queue_enqueue_many:
+ * @queue: a #VAsyncQueue.
+ * @data: the data to add.
+ * @count: the amount of data.
+ *
+ * Adds as much of @data to the end of @queue as fits, taking the lock and
+ * waking readers only once.
+ *
+ * Returns: the amount of data added.
+ */
+unsigned int
+v_async_queue_enqueue_many (VAsyncQueue *queue, void **data, unsigned int count)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	unsigned int ret;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	ret = put_many (priv, data, count);
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_async_queue_dequeue_many:
+ * @queue: a #VAsyncQueue.
+ * @data: return location for the data.
+ * @max: the most data to get.
+ *
+ * Gets up to @max entries from @queue, taking the lock and waking writers
+ * only once.
+ *
+ * Returns: the amount of data stored in @data, 0 if empty.
+ */
+unsigned int
+v_async_queue_dequeue_many (VAsyncQueue *queue, void **data, unsigned int max)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	unsigned int ret;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	ret = take_many (priv, data, max);
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_async_queue_enqueue_many_wait:
+ * @queue: a #VAsyncQueue.
+ * @data: the data to add.
+ * @count: the amount of data.
+ *
+ * Adds all of @data to the end of @queue, waiting for space whenever it
+ * fills up.
+ */
+void
+v_async_queue_enqueue_many_wait (VAsyncQueue *queue, void **data, unsigned int count)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	unsigned int done = 0;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	while (true)
+	{
+		done += put_many (priv, data + done, count - done);
+		
+		if (done == count)
+			break;
+		
+		pthread_cond_wait (&priv->write, &priv->mutex);
+	}
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+/**
+ * v_async_queue_dequeue_many_wait:
+ * @queue: a #VAsyncQueue.
+ * @data: return location for the data.
+ * @max: the most data to get.
+ *
+ * Waits until @queue has data and then gets everything available, up to
+ * @max entries, in one go. Returns straight away when @max is 0.
+ *
+ * Returns: the amount of data stored in @data, at least one unless @max
+ * is 0.
+ */
+unsigned int
+v_async_queue_dequeue_many_wait (VAsyncQueue *queue, void **data, unsigned int max)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	unsigned int ret;
+	
+	
+	/* nothing could ever satisfy the wait */
+	if (max == 0)
+		return 0;
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	while ((ret = take_many (priv, data, max)) == 0)
+		pthread_cond_wait (&priv->read, &priv->mutex);
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_async_queue_dequeue_many_timed:
+ * @queue: a #VAsyncQueue.
+ * @data: return location for the data.
+ * @max: the most data to get.
+ * @timeout: the most seconds to wait for data.
+ *
+ * Like v_async_queue_dequeue_many_wait() but gives up after @timeout.
+ *
+ * Returns: the amount of data stored in @data, 0 if none arrived.
+ */
+unsigned int
+v_async_queue_dequeue_many_timed (VAsyncQueue *queue,
+                                  void **data,
+                                  unsigned int max,
+                                  double timeout)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	struct timespec deadline;
+	unsigned int ret;
+	
+	
+	if (max == 0)
+		return 0;
+	
+	get_deadline (timeout, &deadline);
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	while ((ret = take_many (priv, data, max)) == 0)
+	{
+		if (pthread_cond_timedwait (&priv->read, &priv->mutex, &deadline) != 0)
+		{
+			ret = take_many (priv, data, max);
+			break;
+		}
+	}
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_async_queue_drain:
+ * @queue: a #VAsyncQueue.
+ * @func: a #VDestroyFunc to release each entry with, or %NULL.
+ *
+ * Removes everything from @queue at once, such as when flushing a
+ * pipeline, and wakes all waiting writers.
+ *
+ * Returns: the amount of entries removed.
+ */
+unsigned int
+v_async_queue_drain (VAsyncQueue *queue, VDestroyFunc *func)
+{
+	VAsyncQueuePriv *priv = queue->priv;
+	unsigned int ret = 0;
+	void *data;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	while ((data = v_queue_dequeue (priv->queue)) != NULL)
+	{
+		if (func != NULL)
+			func (data);
+		
+		ret++;
+	}
+	
+	if (ret > 0)
+		pthread_cond_broadcast (&priv->write);
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return ret;
+}
+
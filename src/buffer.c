@@ -138,6 +138,26 @@ v_buffer_free (VBuffer *buffer)
 
 
 
+/**
+ * v_buffer_reset:
+ * @buffer: a #VBuffer.
+ *
+ * Discards the data already buffered, such as after the input moved to
+ * another position. The next read fills the buffer from the new position.
+ */
+void
+v_buffer_reset (VBuffer *buffer)
+{
+	buffer->priv->index  = 0;
+	buffer->priv->length = 0;
+	
+	buffer->eos = false;
+}
+
+
+
+
+
 /**
  * v_buffer_skip:
  * @buffer: a #VBuffer to skip on.
@@ -6,20 +6,30 @@
  */
 
 
-#include "config.h"
-
 #include "clock.h"
 #include "mem.h"
+#include <pthread.h>
+#include <time.h>   /* clock_gettime */
+
+
+
+/* MPEG timestamps count a 90 kHz clock in 33 bits */
+#define PTS_RATE 90000
+#define PTS_WRAP (INT64_C (1) << 33)
+
+#define NSEC_PER_SEC INT64_C (1000000000)
+
+/* presentation errors within this many nanoseconds are on time */
+#define ON_TIME (NSEC_PER_SEC / 1000)
 
+/* deadlines further away than this are a discontinuity, not a delay */
+#define MAX_DRIFT (10 * NSEC_PER_SEC)
 
-/* FIXME: clock shouldn't be directly using libavcodec */
-#ifdef HAVE_LIBAVCODEC_AVCODEC_H
-	#include <libavcodec/avcodec.h>
-	#include <libswscale/swscale.h>
-#else
-	#include <ffmpeg/avcodec.h>
-	#include <ffmpeg/swscale.h>
-#endif
+/* audio further off the timeline than this is resynced at once */
+#define MAX_AUDIO_ERROR (NSEC_PER_SEC / 10)
+
+/* the share of smaller audio errors corrected per update */
+#define DRIFT_GAIN 8
 
 
 
@@ -30,20 +40,166 @@
  */
 struct _VClockPriv
 {
-	double audio_clock;
-	double video_clock;
+	pthread_mutex_t mutex;
+	
+	
+	/* the monotonic time and pts the timeline starts from */
+	bool started;
+	int64_t base_time;
+	int64_t base_pts;
+	
+	/* used to give an absolute value to wrapping pts values */
+	int64_t wrap_offset;
+	int64_t last_pts;
+	
 	
+	/* presentation statistics */
+	unsigned int presented;
+	unsigned int late;
+	unsigned int early;
 	
-	/* used to give an absolute value to incremental pts values */
-	double base_clock;
+	int64_t total_error;
+	int64_t max_late;
+	int64_t max_early;
 	
-	/* used to adjust sync for a specific clock */
-	double delay;
+	int64_t audio_error;
 };
 
 
 
 
+/*
+ * get_monotonic:
+ *
+ * Returns: the monotonic time in nanoseconds.
+ */
+static int64_t
+get_monotonic (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+
+
+/*
+ * unwrap_pts:
+ * @priv: a #VClockPriv.
+ * @pts: a 33 bit presentation timestamp.
+ *
+ * Extends @pts past the 33 bit wrap around, which happens every 26.5 hours.
+ * A jump of more than half the range is taken as the counter wrapping
+ * rather than a jump in time, in either direction as reordered frames can
+ * arrive just before a wrap that was already seen.
+ *
+ * Returns: the unwrapped timestamp.
+ */
+static int64_t
+unwrap_pts (VClockPriv *priv, int64_t pts)
+{
+	int64_t ret = (pts & (PTS_WRAP - 1)) + priv->wrap_offset;
+	
+	
+	if (priv->started)
+	{
+		if (ret < priv->last_pts - PTS_WRAP / 2)
+		{
+			priv->wrap_offset += PTS_WRAP;
+			ret += PTS_WRAP;
+		}
+		
+		else if (ret > priv->last_pts + PTS_WRAP / 2)
+		{
+			priv->wrap_offset -= PTS_WRAP;
+			ret -= PTS_WRAP;
+		}
+	}
+	
+	
+	priv->last_pts = ret;
+	return ret;
+}
+
+
+
+/*
+ * get_deadline:
+ * @priv: a #VClockPriv, locked.
+ * @pts: a presentation timestamp.
+ *
+ * Maps @pts onto the monotonic clock. The first timestamp seen starts
+ * the timeline at the current time.
+ *
+ * Returns: the monotonic time in nanoseconds to present at.
+ */
+static int64_t
+get_deadline (VClockPriv *priv, int64_t pts)
+{
+	int64_t now = get_monotonic ();
+	int64_t deadline;
+	
+	
+	/* nothing to schedule by */
+	if (pts == V_NO_PTS)
+		return now;
+	
+	pts = unwrap_pts (priv, pts);
+	
+	if (!priv->started)
+	{
+		priv->started = true;
+		priv->base_time = now;
+		priv->base_pts = pts;
+	}
+	
+	
+	deadline = priv->base_time + (pts - priv->base_pts) * NSEC_PER_SEC / PTS_RATE;
+	
+	/* restart the timeline rather than stall or rush through a jump */
+	if (deadline > now + MAX_DRIFT || deadline < now - MAX_DRIFT)
+	{
+		priv->base_time = now;
+		priv->base_pts = pts;
+		deadline = now;
+	}
+	
+	
+	return deadline;
+}
+
+
+
+/*
+ * record_error:
+ * @priv: a #VClockPriv, locked.
+ * @error: how far past its deadline a picture was presented.
+ *
+ * Adds a presented picture to the statistics.
+ */
+static void
+record_error (VClockPriv *priv, int64_t error)
+{
+	priv->presented++;
+	priv->total_error += error < 0 ? -error : error;
+	
+	if (error > ON_TIME)
+		priv->late++;
+	
+	else if (error < -ON_TIME)
+		priv->early++;
+	
+	if (error > priv->max_late)
+		priv->max_late = error;
+	
+	if (-error > priv->max_early)
+		priv->max_early = -error;
+}
+
+
+
+
 
 /**
  * v_clock_new:
@@ -59,7 +215,9 @@ v_clock_new (VError *error)
 	VClockPriv *priv = v_new (VClockPriv);
 	
 	
-	priv->base_clock = 0;
+	pthread_mutex_init (&priv->mutex, NULL);
+	priv->started = false;
+	
 	ret->priv = priv;
 	
 	return ret;
@@ -78,6 +236,8 @@ v_clock_free (VClock *clock)
 {
 	VClockPriv *priv = clock->priv;
 	
+	pthread_mutex_destroy (&priv->mutex);
+	
 	v_free (clock->priv);
 	v_free (clock);
 }
@@ -85,27 +245,216 @@ v_clock_free (VClock *clock)
 
 
 
+/**
+ * v_clock_reset:
+ * @clock: a #VClock.
+ *
+ * Restarts the timeline, so that the next timestamp is presented straight
+ * away. Used when the position changes. The statistics are kept.
+ */
+void
+v_clock_reset (VClock *clock)
+{
+	VClockPriv *priv = clock->priv;
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	priv->started = false;
+	priv->wrap_offset = 0;
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
 /**
  * v_clock_get_timeout:
  * @clock: a #VClock.
+ * @frame: a raw frame with a presentation timestamp.
  *
- * Destroys @clock and its contents.
+ * Gets how long until @frame is due to be presented, as v_clock_get_delay()
+ * does for its timestamp.
+ *
+ * Returns: the time left in seconds, negative if @frame is late.
  */
 double
 v_clock_get_timeout (VClock *clock, VFrameRaw *frame)
+{
+	return v_clock_get_delay (clock, frame->pts);
+}
+
+
+
+
+/**
+ * v_clock_get_delay:
+ * @clock: a #VClock.
+ * @pts: the presentation timestamp of a picture, in 90 kHz units.
+ *
+ * Gets how long until @pts is due, without sleeping. Callers that can't
+ * block, such as pipeline nodes, wait this long by other means and then
+ * call v_clock_present().
+ *
+ * Returns: the time left in seconds, negative if @pts is late.
+ */
+double
+v_clock_get_delay (VClock *clock, int64_t pts)
 {
 	VClockPriv *priv = clock->priv;
+	int64_t deadline;
 	
 	
-	if (priv->base_clock = 0)
-		priv->base_clock = av_gettime() / 1000000.0;
+	pthread_mutex_lock (&priv->mutex);
+	deadline = get_deadline (priv, pts);
+	pthread_mutex_unlock (&priv->mutex);
 	
 	
-	double master = (double) av_gettime () / 1000000.0;
+	return (double) (deadline - get_monotonic ()) / NSEC_PER_SEC;
+}
+
+
 
-//	printf ("%g - %jd - %g\n", priv->base_clock, frame->pts, master);
+
+/**
+ * v_clock_present:
+ * @clock: a #VClock.
+ * @pts: the presentation timestamp of a picture, in 90 kHz units.
+ *
+ * Records that the picture at @pts is being presented now, for the
+ * statistics of v_clock_get_stats().
+ *
+ * Returns: the time in seconds the deadline was missed by, negative if
+ * presented early.
+ */
+double
+v_clock_present (VClock *clock, int64_t pts)
+{
+	VClockPriv *priv = clock->priv;
+	int64_t error;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
 	
-	return (priv->base_clock + frame->pts) - master;
+	error = get_monotonic () - get_deadline (priv, pts);
+	record_error (priv, error);
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return (double) error / NSEC_PER_SEC;
 }
 
 
+
+
+/**
+ * v_clock_set_audio:
+ * @clock: a #VClock.
+ * @pts: the timestamp just past the last sample written to the device.
+ * @delay: the time in seconds until that sample is heard.
+ *
+ * Slaves the timeline to the audio device, which runs off its own crystal
+ * and drifts against the system clock. The sample being heard now is at
+ * @pts less @delay, and the timeline is moved towards it: small errors a
+ * fraction at a time so video doesn't stutter, large ones at once. Audio
+ * written before any video starts the timeline.
+ *
+ * Reports can come from any source, such as v_output_get_delay() on the
+ * audio output, or a fake device when testing.
+ */
+void
+v_clock_set_audio (VClock *clock, int64_t pts, double delay)
+{
+	VClockPriv *priv = clock->priv;
+	int64_t now, playing, expected, error;
+	
+	
+	if (pts == V_NO_PTS)
+		return;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	now = get_monotonic ();
+	playing = unwrap_pts (priv, pts) - (int64_t) (delay * PTS_RATE);
+	
+	if (!priv->started)
+	{
+		priv->started = true;
+		priv->base_time = now;
+		priv->base_pts = playing;
+	}
+	
+	
+	/* positive when the device is behind the timeline */
+	expected = priv->base_time + (playing - priv->base_pts) * NSEC_PER_SEC / PTS_RATE;
+	error = now - expected;
+	
+	if (error > MAX_AUDIO_ERROR || error < -MAX_AUDIO_ERROR)
+		priv->base_time += error;
+	
+	else
+		priv->base_time += error / DRIFT_GAIN;
+	
+	priv->audio_error = error;
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+/**
+ * v_clock_pts_diff:
+ * @a: a presentation timestamp.
+ * @b: a presentation timestamp.
+ *
+ * Gets the distance between two 33 bit timestamps, taking the shorter way
+ * round a wrap.
+ *
+ * Returns: the time from @b to @a in 90 kHz units.
+ */
+int64_t
+v_clock_pts_diff (int64_t a, int64_t b)
+{
+	int64_t diff = (a - b) & (PTS_WRAP - 1);
+	
+	if (diff >= PTS_WRAP / 2)
+		diff -= PTS_WRAP;
+	
+	return diff;
+}
+
+
+
+
+/**
+ * v_clock_get_stats:
+ * @clock: a #VClock.
+ * @stats: return location for the #VClockStats.
+ *
+ * Gets how accurately pictures were presented, as recorded by
+ * v_clock_present().
+ */
+void
+v_clock_get_stats (VClock *clock, VClockStats *stats)
+{
+	VClockPriv *priv = clock->priv;
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	stats->presented = priv->presented;
+	stats->late = priv->late;
+	stats->early = priv->early;
+	
+	stats->mean_error = priv->presented > 0 ?
+			(double) priv->total_error / priv->presented / 1000.0 : 0;
+	
+	stats->max_late  = priv->max_late  / 1000.0;
+	stats->max_early = priv->max_early / 1000.0;
+	
+	stats->audio_error = priv->audio_error / 1000.0;
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
@@ -0,0 +1,698 @@
+/***************************************************************************
+ *            codec-parallel.c
+ *
+ *  Oct 19, 2026 6:38:24 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "codec-parallel.h"
+#include "codec.h"
+#include "thread-pool.h"
+#include "async-queue.h"
+#include "queue.h"
+#include "mem.h"
+#include <pthread.h>
+#include <string.h>  /* memcpy */
+
+
+/* the minimum amount of pictures in a segment, excluding priming pictures */
+#define SEGMENT_LENGTH 64
+
+
+/* MPEG video start codes */
+#define PICTURE_START_CODE   0x00
+#define SEQUENCE_HEADER_CODE 0xb3
+#define GOP_START_CODE       0xb8
+
+
+
+typedef struct _VSegment VSegment;
+
+
+
+/*
+ * VCodecParallelPriv:
+ * @pool: the worker threads decoding segments.
+ * @codecs: idle decoder instances.
+ * @segments: submitted segments in decode order.
+ * @current: the segment being filled.
+ * @pending: the amount of segments being decoded.
+ * @finished: no more frames will be pushed.
+ *
+ * Private structure for #VCodecParallel.
+ */
+struct _VCodecParallelPriv
+{
+	VThreadPool *pool;
+	VAsyncQueue *codecs;
+	
+	VQueue   *segments;
+	VSegment *current;
+	
+	int  pending;
+	bool finished;
+	
+	pthread_mutex_t mutex;
+	pthread_cond_t  cond;
+};
+
+
+
+/*
+ * VSegment:
+ * @parallel: the #VCodecParallel the segment belongs to.
+ * @frames: the raw frames in decode order.
+ * @count: the amount of frames.
+ * @prime: the amount of leading frames only used to prime references.
+ * @gop_start: the index of the last GOP in @frames.
+ * @output: the decoded frames in display order.
+ * @done: the segment has been decoded.
+ *
+ * A run of GOPs which can be decoded independently.
+ */
+struct _VSegment
+{
+	VCodecParallel *parallel;
+	
+	VFrameRaw **frames;
+	int count;
+	int allocated;
+	
+	int prime;
+	int gop_start;
+	
+	VQueue *output;
+	bool done;
+};
+
+
+
+
+
+/*
+ * find_gop_start:
+ * @frame: a parsed #VFrameRaw.
+ * @closed: sets to whether the GOP can be decoded on its own.
+ *
+ * Looks for a sequence header or GOP header in front of the picture data.
+ *
+ * Returns: %true if @frame starts a new GOP, %false otherwise.
+ */
+static bool
+find_gop_start (VFrameRaw *frame, bool *closed)
+{
+	bool found = false;
+	int i;
+	
+	*closed = false;
+	
+	
+	for (i = 0; i + 3 < frame->length; i++)
+	{
+		uint8_t *p = frame->data + i;
+		
+		if (p[0] != 0 || p[1] != 0 || p[2] != 1)
+			continue;
+		
+		
+		/* headers only come before the picture */
+		if (p[3] == PICTURE_START_CODE)
+			break;
+		
+		if (p[3] == SEQUENCE_HEADER_CODE)
+			found = true;
+		
+		
+		/* the closed_gop and broken_link flags follow the time code.
+		 * a broken link means the leading B pictures can't be decoded
+		 * anyway so priming won't help */
+		if (p[3] == GOP_START_CODE && i + 7 < frame->length)
+		{
+			found = true;
+			*closed = (p[7] & 0x60) != 0;
+		}
+	}
+	
+	
+	return found;
+}
+
+
+
+
+/*
+ * segment_new:
+ * @parallel: a #VCodecParallel.
+ *
+ * Creates an empty segment.
+ *
+ * Returns: a #VSegment structure.
+ */
+static VSegment *
+segment_new (VCodecParallel *parallel)
+{
+	VSegment *ret = v_new (VSegment);
+	
+	ret->parallel = parallel;
+	ret->output = v_queue_new (0);
+	
+	return ret;
+}
+
+
+
+
+/*
+ * segment_append:
+ * @segment: a #VSegment.
+ * @frame: a #VFrameRaw to take ownership of.
+ *
+ * Adds @frame to the end of @segment.
+ */
+static void
+segment_append (VSegment *segment, VFrameRaw *frame)
+{
+	if (segment->count == segment->allocated)
+	{
+		segment->allocated = segment->allocated ? segment->allocated * 2 : 32;
+		segment->frames = v_realloc (segment->frames,
+				segment->allocated * sizeof (VFrameRaw *));
+	}
+	
+	segment->frames[segment->count++] = frame;
+}
+
+
+
+
+/*
+ * segment_free:
+ * @segment: a #VSegment to free.
+ *
+ * Free's @segment and any frames it still holds.
+ */
+static void
+segment_free (VSegment *segment)
+{
+	VFrame *frame;
+	int i;
+	
+	
+	for (i = 0; i < segment->count; i++)
+		if (segment->frames[i] != NULL)
+			v_frame_free (V_FRAME (segment->frames[i]));
+	
+	while ((frame = v_queue_dequeue (segment->output)) != NULL)
+		v_frame_free (frame);
+	
+	
+	v_queue_free (segment->output);
+	v_free (segment->frames);
+	v_free (segment);
+}
+
+
+
+
+/*
+ * collect_frame:
+ * @segment: the #VSegment being decoded.
+ * @frame: a decoded #VFrame, or %NULL.
+ * @pts: the original timestamps of the segment frames.
+ * @output: the queue to add the frame to.
+ *
+ * Keeps a decoded frame unless it was only decoded for priming. Frames
+ * borrowing the decoder's planes are copied first.
+ */
+static void
+collect_frame (VSegment *segment, VFrame *frame, int64_t *pts, VQueue *output)
+{
+	if (frame == NULL)
+		return;
+	
+	
+	/* the pts was replaced with the frame index before decoding */
+	VFrameVideo *video = V_FRAME_VIDEO (frame);
+	int64_t idx = video->pts;
+	
+	
+	if (idx >= segment->prime && idx < segment->count)
+	{
+		/* the decoder will reuse borrowed picture buffers */
+		if (video->buffer == NULL)
+		{
+			video = v_frame_video_copy (video);
+			v_frame_free (frame);
+		}
+		
+		video->pts = pts[idx];
+		v_queue_enqueue (output, video);
+		return;
+	}
+	
+	
+	v_frame_free (frame);
+}
+
+
+
+
+/*
+ * decode_segment:
+ * @user_data: a #VSegment.
+ *
+ * Decodes a whole segment on an idle decoder.
+ */
+static void
+decode_segment (void *user_data)
+{
+	VSegment *segment = (VSegment *) user_data;
+	VCodecParallel *parallel = segment->parallel;
+	VCodecParallelPriv *priv = parallel->priv;
+	
+	
+	VCodec *codec = v_async_queue_dequeue_wait (priv->codecs);
+	VQueue *output = v_queue_new (0);
+	
+	int64_t *pts = v_malloc (segment->count * sizeof (int64_t));
+	int i;
+	
+	
+	/* start from a clean state */
+	v_codec_flush (codec);
+	
+	
+	for (i = 0; i < segment->count; i++)
+	{
+		VFrameRaw *raw = segment->frames[i];
+		
+		/* tag frames so we can tell them apart after reordering */
+		pts[i] = raw->pts;
+		raw->pts = i;
+		
+		collect_frame (segment, v_codec_decode (codec, V_FRAME (raw), NULL),
+				pts, output);
+		
+		v_frame_free (V_FRAME (raw));
+		segment->frames[i] = NULL;
+	}
+	
+	
+	/* get the last delayed picture */
+	VFrameRaw *end = v_frame_raw_new (0);
+	end->pts = -1;
+	
+	collect_frame (segment, v_codec_decode (codec, V_FRAME (end), NULL),
+			pts, output);
+	
+	v_frame_free (V_FRAME (end));
+	v_free (pts);
+	
+	
+	/* return the decoder */
+	v_async_queue_enqueue_wait (priv->codecs, codec);
+	
+	
+	/* publish the decoded frames */
+	pthread_mutex_lock (&priv->mutex);
+	
+	v_queue_free (segment->output);
+	segment->output = output;
+	segment->done = true;
+	priv->pending--;
+	
+	pthread_cond_broadcast (&priv->cond);
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+/*
+ * submit_segment:
+ * @parallel: a #VCodecParallel.
+ * @segment: the #VSegment to decode.
+ *
+ * Queues @segment for decoding, waiting if too many segments are already
+ * being decoded.
+ */
+static void
+submit_segment (VCodecParallel *parallel, VSegment *segment)
+{
+	VCodecParallelPriv *priv = parallel->priv;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	/* keep the amount of undecoded frames bounded */
+	while (priv->pending >= parallel->threads * 2)
+		pthread_cond_wait (&priv->cond, &priv->mutex);
+	
+	priv->pending++;
+	v_queue_enqueue (priv->segments, segment);
+	
+	pthread_cond_broadcast (&priv->cond);
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	v_thread_pool_push (priv->pool, decode_segment, segment);
+}
+
+
+
+
+/*
+ * pop_frame:
+ * @parallel: a #VCodecParallel.
+ * @wait: whether to wait for a frame to be decoded.
+ *
+ * Gets the next decoded frame in display order.
+ *
+ * Returns: a #VFrameVideo, or %NULL.
+ */
+static VFrameVideo *
+pop_frame (VCodecParallel *parallel, bool wait)
+{
+	VCodecParallelPriv *priv = parallel->priv;
+	VFrameVideo *frame = NULL;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	while (true)
+	{
+		VSegment *segment = v_queue_peek (priv->segments);
+		
+		
+		/* the oldest segment is ready */
+		if (segment != NULL && segment->done)
+		{
+			frame = v_queue_dequeue (segment->output);
+			
+			if (frame != NULL)
+				break;
+			
+			/* move on to the next segment */
+			v_queue_dequeue (priv->segments);
+			segment_free (segment);
+			continue;
+		}
+		
+		
+		/* everything has been decoded */
+		if (segment == NULL && priv->finished)
+			break;
+		
+		if (!wait)
+			break;
+		
+		pthread_cond_wait (&priv->cond, &priv->mutex);
+	}
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	return frame;
+}
+
+
+
+
+
+/**
+ * v_codec_parallel_new:
+ * @id: the codec of the video stream.
+ * @threads: the amount of concurrent decoders, or 0 for one per processor.
+ * @error: a #VError, or %NULL.
+ *
+ * Creates a new #VCodecParallel. Only MPEG video can be split into
+ * independently decodable segments.
+ *
+ * Returns: a #VCodecParallel structure if successful, %NULL otherwise.
+ */
+VCodecParallel *
+v_codec_parallel_new (VCodecID id, int threads, VError *error)
+{
+	/* we only know how to find MPEG GOP boundaries */
+	if (id != V_CODEC_ID_MPEG2)
+	{
+		v_error_set (error,
+					 V_ERROR_DOMAIN_CODEC,
+					 V_CODEC_ERROR_UNSUPPORTED,
+					 "codec-parallel",
+					 "Cannot split '%s' streams for parallel decoding",
+					 v_codec_id_string (id));
+		
+		return NULL;
+	}
+	
+	
+	if (threads <= 0)
+		threads = v_thread_pool_cpu_count ();
+	
+	
+	VCodecParallel *ret = v_new (VCodecParallel);
+	VCodecParallelPriv *priv = v_new (VCodecParallelPriv);
+	
+	
+	/* default values */
+	ret->id = id;
+	ret->threads = threads;
+	ret->priv = priv;
+	
+	pthread_mutex_init (&priv->mutex, NULL);
+	pthread_cond_init  (&priv->cond, NULL);
+	
+	priv->segments = v_queue_new (0);
+	priv->codecs = v_async_queue_new (0);
+	
+	
+	/* create a decoder for each thread */
+	int i;
+	
+	for (i = 0; i < threads; i++)
+	{
+		VCodec *codec = v_codec_new (id, error);
+		
+		/* no codec */
+		if (codec == NULL)
+		{
+			v_codec_parallel_free (ret);
+			return NULL;
+		}
+		
+		v_async_queue_enqueue_wait (priv->codecs, codec);
+	}
+	
+	
+	priv->pool = v_thread_pool_new (threads);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_codec_parallel_free:
+ * @parallel: a #VCodecParallel to free.
+ *
+ * Waits for any segments being decoded and free's @parallel along with
+ * all the frames not yet popped.
+ */
+void
+v_codec_parallel_free (VCodecParallel *parallel)
+{
+	VCodecParallelPriv *priv = parallel->priv;
+	
+	VSegment *segment;
+	VCodec *codec;
+	
+	
+	/* wait for the workers to finish */
+	if (priv->pool != NULL)
+		v_thread_pool_free (priv->pool);
+	
+	
+	while ((segment = v_queue_dequeue (priv->segments)) != NULL)
+		segment_free (segment);
+	
+	if (priv->current != NULL)
+		segment_free (priv->current);
+	
+	while ((codec = v_async_queue_dequeue (priv->codecs)) != NULL)
+		v_codec_free (codec);
+	
+	
+	v_queue_free (priv->segments);
+	v_async_queue_free (priv->codecs);
+	
+	pthread_mutex_destroy (&priv->mutex);
+	pthread_cond_destroy  (&priv->cond);
+	
+	v_free (priv);
+	v_free (parallel);
+}
+
+
+
+
+/**
+ * v_codec_parallel_push:
+ * @parallel: a #VCodecParallel.
+ * @frame: a parsed #VFrameRaw to decode.
+ *
+ * Adds the next frame of the stream in decode order. @parallel takes
+ * ownership of @frame. This may wait for decoders to catch up but never
+ * waits for frames to be popped, so a single thread can alternate between
+ * v_codec_parallel_push() and v_codec_parallel_try_pop().
+ */
+void
+v_codec_parallel_push (VCodecParallel *parallel, VFrameRaw *frame)
+{
+	VCodecParallelPriv *priv = parallel->priv;
+	bool closed;
+	
+	
+	if (priv->current == NULL)
+		priv->current = segment_new (parallel);
+	
+	
+	if (find_gop_start (frame, &closed))
+	{
+		VSegment *current = priv->current;
+		
+		
+		/* long enough to split off */
+		if (current->count - current->prime >= SEGMENT_LENGTH)
+		{
+			VSegment *next = segment_new (parallel);
+			int i;
+			
+			
+			/* leading B pictures of an open GOP reference the last GOP */
+			if (!closed)
+			{
+				for (i = current->gop_start; i < current->count; i++)
+				{
+					VFrameRaw *src = current->frames[i];
+					VFrameRaw *dst = v_frame_raw_new (src->length);
+					
+					memcpy (dst->data, src->data, src->length);
+					dst->stream_id = src->stream_id;
+					dst->pts = src->pts;
+					dst->dts = src->dts;
+					dst->key_frame = src->key_frame;
+					
+					segment_append (next, dst);
+				}
+				
+				next->prime = next->count;
+			}
+			
+			
+			submit_segment (parallel, current);
+			priv->current = next;
+		}
+		
+		
+		priv->current->gop_start = priv->current->count;
+	}
+	
+	
+	segment_append (priv->current, frame);
+}
+
+
+
+
+/**
+ * v_codec_parallel_finish:
+ * @parallel: a #VCodecParallel.
+ *
+ * Signals the end of the stream so that the last segment gets decoded.
+ * No more frames may be pushed afterwards.
+ */
+void
+v_codec_parallel_finish (VCodecParallel *parallel)
+{
+	VCodecParallelPriv *priv = parallel->priv;
+	
+	
+	/* decode whatever is left */
+	if (priv->current != NULL)
+	{
+		if (priv->current->count > priv->current->prime)
+			submit_segment (parallel, priv->current);
+		else
+			segment_free (priv->current);
+		
+		priv->current = NULL;
+	}
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	priv->finished = true;
+	pthread_cond_broadcast (&priv->cond);
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+/**
+ * v_codec_parallel_pop:
+ * @parallel: a #VCodecParallel.
+ *
+ * Gets the next decoded frame in display order, waiting for it to be
+ * decoded if needed. The frame owns its picture data and must be free'd
+ * with v_frame_free().
+ *
+ * Returns: a #VFrameVideo, or %NULL once all frames have been popped after
+ * v_codec_parallel_finish().
+ */
+VFrameVideo *
+v_codec_parallel_pop (VCodecParallel *parallel)
+{
+	return pop_frame (parallel, true);
+}
+
+
+
+
+/**
+ * v_codec_parallel_try_pop:
+ * @parallel: a #VCodecParallel.
+ *
+ * Gets the next decoded frame in display order if it is available.
+ *
+ * Returns: a #VFrameVideo, or %NULL if no frame is ready.
+ */
+VFrameVideo *
+v_codec_parallel_try_pop (VCodecParallel *parallel)
+{
+	return pop_frame (parallel, false);
+}
+
+
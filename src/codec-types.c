@@ -25,6 +25,7 @@
  
 #include "codec-types.h"
 #include <stddef.h>  /* NULL */
+#include <stdbool.h>
 
 
 
@@ -103,3 +104,76 @@ v_codec_id_string (VCodecID id)
 	return "Unknown";
 }
 
+
+
+
+/**
+ * v_pixel_format_get_plane:
+ * @format: the #VPixelFormat of the picture.
+ * @plane: the plane index.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @bytes: sets to the amount of bytes in a line of the plane.
+ * @lines: sets to the amount of lines in the plane.
+ *
+ * Gets the dimensions of a single picture plane. Iterating @plane from 0
+ * until %false is returned visits every plane of @format.
+ *
+ * Returns: %true if @plane exists in @format, %false otherwise.
+ */
+bool
+v_pixel_format_get_plane (VPixelFormat format,
+                          int plane,
+                          int width,
+                          int height,
+                          int *bytes,
+                          int *lines)
+{
+	switch (format)
+	{
+		case V_PIXEL_FORMAT_YUV420:
+			if (plane > 2)
+				return false;
+			
+			*bytes = plane ? (width + 1) / 2 : width;
+			*lines = plane ? (height + 1) / 2 : height;
+			return true;
+			
+		case V_PIXEL_FORMAT_RGB32:
+			if (plane > 0)
+				return false;
+			
+			*bytes = width * 4;
+			*lines = height;
+			return true;
+			
+		case V_PIXEL_FORMAT_PAL8:
+			if (plane > 1)
+				return false;
+			
+			/* the second plane holds the palette */
+			*bytes = plane ? 256 * 4 : width;
+			*lines = plane ? 1 : height;
+			return true;
+			
+		case V_PIXEL_FORMAT_NV12:
+			if (plane > 1)
+				return false;
+			
+			*bytes = plane ? ((width + 1) / 2) * 2 : width;
+			*lines = plane ? (height + 1) / 2 : height;
+			return true;
+			
+		case V_PIXEL_FORMAT_YUY2:
+		case V_PIXEL_FORMAT_UYVY:
+			if (plane > 0)
+				return false;
+			
+			*bytes = ((width + 1) / 2) * 4;
+			*lines = height;
+			return true;
+			
+		default:
+			return false;
+	}
+}
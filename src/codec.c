@@ -52,6 +52,8 @@ v_codec_new (VCodecID id, VError *error)
 	/* default values */
 	ret->id = id;
 	ret->type = v_codec_id_type (id);
+	ret->mode = V_CODEC_MODE_FULL;
+	ret->lowres = 0;
 	
 	
 	return ret;
@@ -64,12 +66,16 @@ v_codec_new (VCodecID id, VError *error)
  * v_codec_free:
  * @codec: a #VCodec to free.
  *
- * Free's @codec and its contents.
+ * Free's @codec and its contents. Codec modules may keep the underlying
+ * decoder around to be reused by the next v_codec_new() call.
  */
 void
 v_codec_free (VCodec *codec)
 {
-	v_free (codec);
+	if (codec->free != NULL)
+		codec->free (codec);
+	else
+		v_free (codec);
 }
 
 
@@ -123,7 +129,8 @@ v_codec_parse (VCodec *codec, VPacket *packet, VQueue *frames)
  * @frame: a #VFrame to decode.
  * @error: a #VError, or %NULL.
  *
- * Decodes @frame.
+ * Decodes @frame. Decoders which delay pictures return their last picture
+ * when given an empty #VFrameRaw with a length of 0.
  *
  * Returns: %true if successful, %false otherwise.
  */
@@ -136,6 +143,133 @@ v_codec_decode (VCodec *codec, VFrame *frame, VError *error)
 
 
 
+/**
+ * v_codec_decode_batch:
+ * @codec: a #VCodec.
+ * @frames: an array of #VFrameRaw to decode, in decode order.
+ * @count: the amount of frames in @frames.
+ * @output: an array of at least @count entries to store decoded frames in.
+ * @error: a #VError, or %NULL.
+ *
+ * Decodes several frames in one call. Audio codecs decode all of @frames
+ * into a single #VFrameAudio holding contiguous samples, which saves a
+ * queue hop and an output write for every small compressed frame. Other
+ * codecs store one decoded frame per completed picture.
+ *
+ * The frames in @frames are not free'd.
+ *
+ * Returns: the amount of frames stored in @output.
+ */
+int
+v_codec_decode_batch (VCodec     *codec,
+                      VFrameRaw **frames,
+                      int         count,
+                      VFrame    **output,
+                      VError     *error)
+{
+	if (codec->decode_batch != NULL)
+		return codec->decode_batch (codec, frames, count, output, error);
+	
+	
+	/* decode frames one by one */
+	int i;
+	int ret = 0;
+	
+	for (i = 0; i < count; i++)
+	{
+		VFrame *frame = codec->decode (codec, V_FRAME (frames[i]), error);
+		
+		if (frame != NULL)
+			output[ret++] = frame;
+	}
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_codec_flush:
+ * @codec: a #VCodec.
+ *
+ * Discards any partially parsed frame and all decoder state such as
+ * reference pictures, so that decoding can restart at a discontinuity.
+ */
+void
+v_codec_flush (VCodec *codec)
+{
+	if (codec->flush != NULL)
+		codec->flush (codec);
+}
+
+
+
+
+/**
+ * v_codec_set_mode:
+ * @codec: a #VCodec.
+ * @mode: the #VCodecMode to use.
+ *
+ * Sets the decoding mode of @codec. Setting %V_CODEC_MODE_KEYFRAMES on a
+ * video stream allows fast scrubbing since only independently decodable
+ * frames are parsed out and decoded. The mode takes effect on the next
+ * parsed packet.
+ */
+void
+v_codec_set_mode (VCodec *codec, VCodecMode mode)
+{
+	codec->mode = mode;
+}
+
+
+
+
+/**
+ * v_codec_set_lowres:
+ * @codec: a #VCodec.
+ * @lowres: the scale factor, where 0 is full size, 1 is half size,
+ * 2 is quarter size and so on.
+ *
+ * Makes @codec decode pictures at a reduced resolution, skipping most of the
+ * decoding work for the discarded detail. This is only useful for previews
+ * and thumbnails. The stream properties must be updated afterwards with
+ * v_stream_update() to pick up the reduced dimensions.
+ *
+ * Returns: %true if successful, %false if @codec cannot decode at @lowres.
+ */
+bool
+v_codec_set_lowres (VCodec *codec, int lowres)
+{
+	/* nothing to change */
+	if (codec->lowres == lowres)
+		return true;
+	
+	/* not supported */
+	if (codec->set_lowres == NULL)
+		return false;
+	
+	
+	if (codec->set_lowres (codec, lowres) == false)
+		return false;
+	
+	codec->lowres = lowres;
+	return true;
+}
+
+
+
+
+/**
+ * v_codec_properties:
+ * @codec: a #VCodec.
+ *
+ * Gets the stream properties detected by @codec.
+ *
+ * Returns: a newly allocated #VCodecProperties which must be free'd
+ * with v_free().
+ */
 VCodecProperties *
 v_codec_properties (VCodec *codec)
 {
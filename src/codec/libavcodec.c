@@ -26,7 +26,9 @@
 #include "config.h"
 
 #include "codec.h"
+#include "list.h"
 #include "mem.h"
+#include <pthread.h>
 #include <string.h>  /* memcpy */
 
 
@@ -38,6 +40,11 @@
 
 
 
+/* the maximum amount of idle decoders kept for each codec */
+#define CACHE_SIZE 4
+
+
+
 typedef struct _VCodecLibavcodec VCodecLibavcodec;
 
 
@@ -51,17 +58,213 @@ struct _VCodecLibavcodec
 {
 	VCodec parent;
 	
+	AVCodec *av_codec;
 	AVCodecContext *codec_ctx;
 	AVCodecParserContext *parser_ctx;
 	
 	
 	/* video decoding */
 	AVFrame *raw;
+	
+	/* the pictures the decoder decodes into, shared with their consumers */
+	VFramePool *pool;
 };
 
 
 
 
+/* libavcodec only needs to be initialised once */
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+
+/* idle decoders ready to be reused */
+static VList *cache;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+
+
+/*
+ * init_libavcodec:
+ *
+ * Registers all the libavcodec codecs and parsers.
+ */
+static void
+init_libavcodec (void)
+{
+	avcodec_register_all ();
+	cache = v_list_new ();
+}
+
+
+
+
+/*
+ * take_cached:
+ * @codec_id: the codec type to handle.
+ *
+ * Takes an idle decoder out of the cache.
+ *
+ * Returns: a #VCodec structure if one was cached, %NULL otherwise.
+ */
+static VCodec *
+take_cached (VCodecID codec_id)
+{
+	VListNode *node;
+	VCodec *ret = NULL;
+	
+	
+	pthread_mutex_lock (&cache_mutex);
+	
+	for (node = cache->first; node; node = node->next)
+	{
+		VCodec *codec = (VCodec *) node->data;
+		
+		/* found a matching decoder */
+		if (codec->id == codec_id)
+		{
+			ret = codec;
+			v_list_remove (cache, node);
+			break;
+		}
+	}
+	
+	pthread_mutex_unlock (&cache_mutex);
+	
+	
+	return ret;
+}
+
+
+
+
+
+
+/*
+ * convert_pixel_format:
+ * @pix_fmt: a libavcodec pixel format.
+ *
+ * Converts @pix_fmt into our pixel format range.
+ *
+ * Returns: a #VPixelFormat value.
+ */
+static VPixelFormat
+convert_pixel_format (enum PixelFormat pix_fmt)
+{
+	switch (pix_fmt)
+	{
+		case PIX_FMT_YUV420P:
+			return V_PIXEL_FORMAT_YUV420;
+			
+		case PIX_FMT_RGB32:
+			return V_PIXEL_FORMAT_RGB32;
+			
+		case PIX_FMT_NV12:
+			return V_PIXEL_FORMAT_NV12;
+			
+		case PIX_FMT_YUYV422:
+			return V_PIXEL_FORMAT_YUY2;
+			
+		case PIX_FMT_UYVY422:
+			return V_PIXEL_FORMAT_UYVY;
+	}
+	
+	
+	return V_PIXEL_FORMAT_UNKNOWN;
+}
+
+
+
+
+/*
+ * get_buffer:
+ * @codec_ctx: the decoder context.
+ * @pic: the picture to provide planes for.
+ *
+ * Hands the decoder a pooled frame to decode into. The decoder holds a
+ * reference until it no longer predicts from the picture, and each
+ * decoded picture returned from the codec another, so pictures stay valid
+ * while they are queued for display.
+ *
+ * Returns: 0 if successful, a negative value otherwise.
+ */
+static int
+get_buffer (AVCodecContext *codec_ctx, AVFrame *pic)
+{
+	VCodecLibavcodec *self = (VCodecLibavcodec *) codec_ctx->opaque;
+	VPixelFormat format = convert_pixel_format (codec_ctx->pix_fmt);
+	VFrameVideo *frame;
+	int width, height;
+	int i;
+	
+	
+	/* formats we can't lay out are left to libavcodec */
+	if (format == V_PIXEL_FORMAT_UNKNOWN)
+		return avcodec_default_get_buffer (codec_ctx, pic);
+	
+	
+	/* the decoder writes whole macroblocks, of field pictures too */
+	width  = (codec_ctx->width  + 15) & ~15;
+	height = (codec_ctx->height + 31) & ~31;
+	
+	if (self->pool == NULL || self->pool->pixel_format != format ||
+	    self->pool->width != width || self->pool->height != height)
+	{
+		/* pictures of the old size are still valid until released */
+		if (self->pool != NULL)
+			v_frame_pool_free (self->pool);
+		
+		self->pool = v_frame_pool_new (format, width, height);
+	}
+	
+	frame = v_frame_pool_get (self->pool);
+	
+	
+	for (i = 0; i < 4; i++)
+	{
+		pic->data[i] = frame->data[i];
+		pic->linesize[i] = frame->linesize[i];
+	}
+	
+	pic->opaque = frame;
+	pic->type = FF_BUFFER_TYPE_USER;
+	pic->age = 256 * 256 * 256 * 64;
+	pic->reordered_opaque = codec_ctx->reordered_opaque;
+	
+	
+	return 0;
+}
+
+
+
+
+/*
+ * release_buffer:
+ * @codec_ctx: the decoder context.
+ * @pic: the picture the decoder is done with.
+ *
+ * Drops the decoder's reference on a picture from get_buffer().
+ */
+static void
+release_buffer (AVCodecContext *codec_ctx, AVFrame *pic)
+{
+	int i;
+	
+	
+	if (pic->type != FF_BUFFER_TYPE_USER)
+	{
+		avcodec_default_release_buffer (codec_ctx, pic);
+		return;
+	}
+	
+	v_frame_free (V_FRAME (pic->opaque));
+	
+	for (i = 0; i < 4; i++)
+		pic->data[i] = NULL;
+}
+
+
 
 
 static VCodecProperties *
@@ -75,17 +278,154 @@ v_codec_libavcodec_properties (VCodec *codec)
 	
 	if (self->codec_ctx->sample_fmt == SAMPLE_FMT_S16)
 		prop->sample_format = V_SAMPLE_FORMAT_S16;
-
-	if (self->codec_ctx->pix_fmt == PIX_FMT_YUV420P)
-		prop->pixel_format = V_PIXEL_FORMAT_YUV420;
+	
+	prop->pixel_format = convert_pixel_format (self->codec_ctx->pix_fmt);
 	
 	
 	
 	prop->channels = self->codec_ctx->channels;
 	prop->sample_rate = self->codec_ctx->sample_rate;
 	
+	/* the dimensions are already reduced by the lowres factor */
 	prop->width = self->codec_ctx->width;
 	prop->height = self->codec_ctx->height;
+	prop->lowres = self->codec_ctx->lowres;
+	
+	
+	return prop;
+}
+
+
+
+
+/*
+ * v_codec_libavcodec_flush:
+ *
+ * Resets the parser and the decoder state.
+ */
+static void
+v_codec_libavcodec_flush (VCodec *codec)
+{
+	VCodecLibavcodec *self = (VCodecLibavcodec *) codec;
+	
+	
+	/* drop reference and delayed pictures */
+	avcodec_flush_buffers (self->codec_ctx);
+	
+	
+	/* parsers cannot be reset so create a fresh one */
+	if (self->parser_ctx != NULL)
+	{
+		av_parser_close (self->parser_ctx);
+		self->parser_ctx = av_parser_init (self->av_codec->id);
+	}
+}
+
+
+
+
+/*
+ * v_codec_libavcodec_set_lowres:
+ *
+ * Reopens the decoder to use the downscaling IDCT at @lowres. If the
+ * decoder can't be reopened it goes back to the previous size, so it keeps
+ * decoding either way.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+static bool
+v_codec_libavcodec_set_lowres (VCodec *codec, int lowres)
+{
+	VCodecLibavcodec *self = (VCodecLibavcodec *) codec;
+	int previous = self->codec_ctx->lowres;
+	
+	
+	/* libavcodec supports up to an 8th of the size */
+	if (lowres < 0 || lowres > 3)
+		return false;
+	
+	
+	/* the IDCT is chosen when the decoder is opened */
+	avcodec_close (self->codec_ctx);
+	self->codec_ctx->lowres = lowres;
+	
+	
+	/* reopen and recalculate the picture dimensions */
+	if (avcodec_open (self->codec_ctx, self->av_codec) < 0)
+	{
+		self->codec_ctx->lowres = previous;
+		avcodec_open (self->codec_ctx, self->av_codec);
+		
+		return false;
+	}
+	
+	if (self->codec_ctx->coded_width && self->codec_ctx->coded_height)
+	{
+		self->codec_ctx->width  = -((-self->codec_ctx->coded_width)  >> lowres);
+		self->codec_ctx->height = -((-self->codec_ctx->coded_height) >> lowres);
+	}
+	
+	
+	return true;
+}
+
+
+
+
+/*
+ * v_codec_libavcodec_free:
+ *
+ * Resets the decoder and keeps it for reuse, or destroys it if the
+ * cache is full.
+ */
+static void
+v_codec_libavcodec_free (VCodec *codec)
+{
+	VCodecLibavcodec *self = (VCodecLibavcodec *) codec;
+	
+	
+	/* clear all decoding state from the last stream */
+	v_codec_libavcodec_flush (codec);
+	
+	if (self->codec_ctx->lowres != 0)
+		v_codec_libavcodec_set_lowres (codec, 0);
+	
+	
+	pthread_mutex_lock (&cache_mutex);
+	
+	VListNode *node;
+	int count = 0;
+	
+	for (node = cache->first; node; node = node->next)
+		if (((VCodec *) node->data)->id == codec->id)
+			count++;
+	
+	
+	/* keep the decoder around */
+	if (count < CACHE_SIZE)
+	{
+		v_list_append (cache, codec);
+		pthread_mutex_unlock (&cache_mutex);
+		return;
+	}
+	
+	pthread_mutex_unlock (&cache_mutex);
+	
+	
+	/* destroy the decoder */
+	avcodec_close (self->codec_ctx);
+	av_free (self->codec_ctx);
+	
+	if (self->parser_ctx != NULL)
+		av_parser_close (self->parser_ctx);
+	
+	if (self->raw != NULL)
+		av_free (self->raw);
+	
+	if (self->pool != NULL)
+		v_frame_pool_free (self->pool);
+	
+	v_free (self);
 }
 
 
@@ -133,11 +473,24 @@ v_codec_libavcodec_parse (VCodec *codec, VPacket *packet, VQueue *frames)
 		/* we've got a complete frame */
 		if (size)
 		{
+			/* only video frames depend on other frames */
+			bool key_frame = true;
+			
+			if (codec->type == V_CODEC_TYPE_VIDEO)
+				key_frame = (self->parser_ctx->pict_type == FF_I_TYPE);
+			
+			
+			/* drop the frame before its payload is copied */
+			if (codec->mode == V_CODEC_MODE_KEYFRAMES && !key_frame)
+				continue;
+			
+			
 			VFrameRaw *frame = v_frame_raw_new (size);
 			
 			frame->stream_id = packet->id;
 			frame->pts = self->parser_ctx->pts;
 			frame->dts = self->parser_ctx->dts;
+			frame->key_frame = key_frame;
 			
 			
 			/* copy frame data */
@@ -192,6 +545,76 @@ v_codec_libavcodec_decode_audio (VCodec *codec, VFrame *frame, VError *error)
 
 
 
+/*
+ * v_codec_libavcodec_decode_audio_batch:
+ *
+ * Decodes several audio frames into one contiguous sample buffer. Frames
+ * the decoder fails on are skipped.
+ *
+ * Returns: the amount of decoded frames, which is at most 1, or 0 if no
+ * samples were decoded.
+ */
+static int
+v_codec_libavcodec_decode_audio_batch (VCodec     *codec,
+                                       VFrameRaw **frames,
+                                       int         count,
+                                       VFrame    **output,
+                                       VError     *error)
+{
+	VCodecLibavcodec *self = (VCodecLibavcodec *) codec;
+	
+	
+	int size = AVCODEC_MAX_AUDIO_FRAME_SIZE * 2;
+	int used = 0;
+	int i;
+	
+	VFrameAudio *audio = v_frame_audio_new (size);
+	
+	
+	for (i = 0; i < count; i++)
+	{
+		/* libavcodec needs room for the largest possible frame */
+		if (size - used < AVCODEC_MAX_AUDIO_FRAME_SIZE)
+		{
+			size *= 2;
+			audio->samples = v_realloc (audio->samples, size);
+		}
+		
+		
+		/* tells the decoder how much space there is */
+		int len = size - used;
+		
+		
+		/* decode audio frame after the previous ones */
+		if (avcodec_decode_audio2 (self->codec_ctx,
+				(int16_t *) ((uint8_t *) audio->samples + used),
+				&len,
+				frames[i]->data,
+				frames[i]->length) < 0)
+			continue;
+		
+		if (len > 0)
+			used += len;
+	}
+	
+	
+	/* nothing to play */
+	if (used == 0)
+	{
+		v_frame_free (V_FRAME (audio));
+		return 0;
+	}
+	
+	audio->length = used;
+	output[0] = V_FRAME (audio);
+	
+	return 1;
+}
+
+
+
+
+
 /*
  * v_codec_libavcodec_decode_video:
  *
@@ -211,6 +634,17 @@ v_codec_libavcodec_decode_video (VCodec *codec, VFrame *frame, VError *error)
 	int frame_finished;
 	
 	
+	/* frames not coming from our parser still need to be skipped */
+	if (codec->mode == V_CODEC_MODE_KEYFRAMES)
+		self->codec_ctx->skip_frame = AVDISCARD_NONKEY;
+	else
+		self->codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+	
+	
+	/* carry the pts through the decoder's picture reordering */
+	self->codec_ctx->reordered_opaque = raw->pts;
+	
+	
 	/* decode video frame */
 	avcodec_decode_video (self->codec_ctx,
 			self->raw,
@@ -222,18 +656,35 @@ v_codec_libavcodec_decode_video (VCodec *codec, VFrame *frame, VError *error)
 	
 	if (frame_finished)
 	{
-		VFrameVideo *video = v_frame_video_new ();
+		VFrameVideo *video;
+		
+		
+		/* pooled pictures are shared with the decoder */
+		if (self->raw->type == FF_BUFFER_TYPE_USER)
+			video = V_FRAME_VIDEO (v_frame_ref (V_FRAME (self->raw->opaque)));
 		
+		else
+		{
+			video = v_frame_video_new ();
+			
+			video->data[0] = self->raw->data[0];
+			video->data[1] = self->raw->data[1];
+			video->data[2] = self->raw->data[2];
+			video->data[3] = self->raw->data[3];
+			
+			video->linesize[0] = self->raw->linesize[0];
+			video->linesize[1] = self->raw->linesize[1];
+			video->linesize[2] = self->raw->linesize[2];
+			video->linesize[3] = self->raw->linesize[3];
+		}
 		
-		video->data[0] = self->raw->data[0];
-		video->data[1] = self->raw->data[1];
-		video->data[2] = self->raw->data[2];
-		video->data[3] = self->raw->data[3];
 		
-		video->linesize[0] = self->raw->linesize[0];
-		video->linesize[1] = self->raw->linesize[1];
-		video->linesize[2] = self->raw->linesize[2];
-		video->linesize[3] = self->raw->linesize[3];
+		video->width  = self->codec_ctx->width;
+		video->height = self->codec_ctx->height;
+		video->pixel_format = convert_pixel_format (self->codec_ctx->pix_fmt);
+		video->pts = self->raw->reordered_opaque;
+		video->interlaced = self->raw->interlaced_frame;
+		video->top_field_first = self->raw->top_field_first;
 		
 		
 		return V_FRAME (video);
@@ -276,33 +727,60 @@ v_codec_libavcodec_decode_subtitle (VCodec *codec, VFrame *frame, VError *error)
 
 
 	
-	if (got_sub != 0)
+	if (got_sub == 0)
+		return NULL;
+	
+	
+	VFrameSubtitle *ret;
+	unsigned int i;
+	
+	
+	/* an empty subtitle clears the screen */
+	if (sub.num_rects == 0)
 	{
-		VFrameSubtitle *subpic = v_frame_subtitle_new ();
+		ret = v_frame_subtitle_new ();
+		ret->pixel_format = V_PIXEL_FORMAT_PAL8;
+	}
+	
+	else
+	{
+		VFrameSubtitle subpic;
 		
-
-		subpic->x = sub.rects[0]->x;
-		subpic->y = sub.rects[0]->y;
-		subpic->w = sub.rects[0]->w;
-		subpic->h = sub.rects[0]->h;
-
-
-		subpic->data[0] = sub.rects[0]->pict.data[0];
-		subpic->data[1] = sub.rects[0]->pict.data[1];
-		subpic->data[2] = sub.rects[0]->pict.data[2];
-		subpic->data[3] = sub.rects[0]->pict.data[3];
-
-		subpic->linesize[0] = sub.rects[0]->pict.linesize[0];
-		subpic->linesize[1] = sub.rects[0]->pict.linesize[1];
-		subpic->linesize[2] = sub.rects[0]->pict.linesize[2];
-		subpic->linesize[3] = sub.rects[0]->pict.linesize[3];
+		subpic.x = sub.rects[0]->x;
+		subpic.y = sub.rects[0]->y;
+		subpic.w = sub.rects[0]->w;
+		subpic.h = sub.rects[0]->h;
+		subpic.pixel_format = V_PIXEL_FORMAT_PAL8;
+		
+		for (i = 0; i < 4; i++)
+		{
+			subpic.data[i] = sub.rects[0]->pict.data[i];
+			subpic.linesize[i] = sub.rects[0]->pict.linesize[i];
+		}
+		
+		
+		/* the palette holds only the used colours */
+		uint32_t palette[256] = { 0 };
 		
+		memcpy (palette, subpic.data[1], sub.rects[0]->nb_colors * 4);
+		subpic.data[1] = (uint8_t *) palette;
 		
-		return V_FRAME (subpic);
+		ret = v_frame_subtitle_copy (&subpic);
 	}
 	
 	
-	return NULL;
+	/* the rectangles belong to the caller */
+	for (i = 0; i < sub.num_rects; i++)
+	{
+		av_freep (&sub.rects[i]->pict.data[0]);
+		av_freep (&sub.rects[i]->pict.data[1]);
+		av_freep (&sub.rects[i]);
+	}
+	
+	av_freep (&sub.rects);
+	
+	
+	return V_FRAME (ret);
 }
 
 
@@ -318,9 +796,20 @@ v_codec_libavcodec_decode_subtitle (VCodec *codec, VFrame *frame, VError *error)
 VCodec *
 v_codec_libavcodec_new (VCodecID codec_id)
 {
+	/* register codecs */
+	pthread_once (&init_once, init_libavcodec);
+	
+	
+	/* reuse a warmed up decoder */
+	VCodec *ret = take_cached (codec_id);
+	
+	if (ret != NULL)
+		return ret;
+	
+	
 	VCodecLibavcodec *priv = v_new (VCodecLibavcodec);
 	
-	VCodec *ret = (VCodec *) priv;
+	ret = (VCodec *) priv;
 	
 	
 	
@@ -351,22 +840,29 @@ v_codec_libavcodec_new (VCodecID codec_id)
 	}
 	
 	
-	
-	avcodec_register_all ();
-	
 	/* create contexts */
 	priv->codec_ctx  = avcodec_alloc_context ();
 	priv->parser_ctx = av_parser_init (id);
 	
+	/* decode into our own refcounted pictures, without borders */
+	priv->codec_ctx->opaque = priv;
+	priv->codec_ctx->get_buffer = get_buffer;
+	priv->codec_ctx->release_buffer = release_buffer;
+	priv->codec_ctx->flags |= CODEC_FLAG_EMU_EDGE;
+	
 	
 	/* open codec */
 	AVCodec *av_codec = avcodec_find_decoder (id);
 	avcodec_open (priv->codec_ctx, av_codec);
 	
+	priv->av_codec = av_codec;
+	
 	
 	
 	/* set interface methods */
 	ret->parse = v_codec_libavcodec_parse;
+	ret->flush = v_codec_libavcodec_flush;
+	ret->free  = v_codec_libavcodec_free;
 	ret->properties = v_codec_libavcodec_properties;
 	
 	
@@ -375,10 +871,12 @@ v_codec_libavcodec_new (VCodecID codec_id)
 	{
 		case CODEC_TYPE_AUDIO:
 			ret->decode = v_codec_libavcodec_decode_audio;
+			ret->decode_batch = v_codec_libavcodec_decode_audio_batch;
 			break;
 			
 		case CODEC_TYPE_VIDEO:
 			ret->decode = v_codec_libavcodec_decode_video;
+			ret->set_lowres = v_codec_libavcodec_set_lowres;
 			priv->raw = avcodec_alloc_frame ();
 			break;
 			
@@ -26,7 +26,12 @@
 #include "config.h"
 
 #include "colorspace.h"
+#include "convert.h"
+#include "list.h"
 #include "mem.h"
+#include "thread-pool.h"
+#include <string.h>  /* memcpy */
+#include <pthread.h>
 
 
 /* FIXME: colorspace should be based on modules
@@ -42,6 +47,19 @@
 
 
 
+typedef struct _Band Band;
+
+
+
+/* the band counter value once no bands are left to claim */
+#define NO_BANDS (1 << 30)
+
+/* rows swscale bands convert past each edge so their filters see the same
+ * neighbours as a whole picture conversion would */
+#define BAND_MARGIN 16
+
+
+
 /*
  * VColorspacePriv:
  * @demuxer: the demuxer.
@@ -57,20 +75,153 @@ struct _VColorspacePriv
 	int width;
 	int height;
 	
+	/* scaling */
+	int dest_width;
+	int dest_height;
+	VScalePreset preset;
+	int flags;
+	
+	
+	bool passthrough;
+	
+	/* built-in conversion kernels */
+	bool native;
+	VColorMatrix matrix;
+	
+	enum PixelFormat pix_src;
+	enum PixelFormat pix_dest;
+	
+	VFramePool *pool;
+	struct SwsContext *convert_ctx;
+	
+	/* held by the owner and each queued helper task */
+	int ref_count;
+	
+	
+	/* parallel conversion */
+	int   threads;
+	Band *bands;
+	
+	int next_band;
+	int pending;
+	pthread_mutex_t mutex;
+	pthread_cond_t  done;
+};
+
+
+
+/*
+ * Band:
+ * @priv: the colorspace the band belongs to.
+ * @first: the first row of the band.
+ * @rows: the amount of rows in the band.
+ * @data: the source planes of the picture being converted.
+ * @linesize: the size of each source plane line.
+ * @dest: the destination planes.
+ * @dest_linesize: the size of each destination plane line.
+ * @convert_ctx: the swscale context of the band, %NULL for built-in kernels.
+ * @top: the margin rows converted above the band.
+ * @lines: the rows converted by swscale, margins included.
+ * @scratch: the planes swscale bands are converted into, margins included.
+ * @scratch_linesize: the size of each scratch plane line.
+ *
+ * A horizontal band of the picture converted by a worker thread.
+ */
+struct _Band
+{
+	VColorspacePriv *priv;
+	
+	
+	int first;
+	int rows;
+	
+	uint8_t **data;
+	int *linesize;
+	
+	uint8_t **dest;
+	int *dest_linesize;
+	
 	
-	AVPicture *pic;
 	struct SwsContext *convert_ctx;
+	int top;
+	int lines;
+	
+	uint8_t *buffer;
+	uint8_t *scratch[4];
+	int scratch_linesize[4];
+};
+
+
+
+/*
+ * VColorspaceCachePriv:
+ * @size: the maximum amount of cached colorspaces.
+ * @entries: the cached colorspaces, from least to most recently used.
+ *
+ * Private structure for #VColorspaceCache.
+ */
+struct _VColorspaceCachePriv
+{
+	unsigned int size;
+	VList *entries;
 };
 
 
 
 
+/*
+ * get_pix_fmt:
+ * @format: a #VPixelFormat.
+ *
+ * Maps @format to the matching swscale pixel format.
+ */
+static enum PixelFormat
+get_pix_fmt (VPixelFormat format)
+{
+	switch (format)
+	{
+		case V_PIXEL_FORMAT_RGB32: return PIX_FMT_RGB32;
+		case V_PIXEL_FORMAT_PAL8:  return PIX_FMT_PAL8;
+		case V_PIXEL_FORMAT_NV12:  return PIX_FMT_NV12;
+		case V_PIXEL_FORMAT_YUY2:  return PIX_FMT_YUYV422;
+		case V_PIXEL_FORMAT_UYVY:  return PIX_FMT_UYVY422;
+		default:                   return PIX_FMT_YUV420P;
+	}
+}
+
+
+
+
+/*
+ * get_sws_flags:
+ * @preset: a #VScalePreset.
+ *
+ * Maps @preset to the matching swscale algorithm.
+ */
+static int
+get_sws_flags (VScalePreset preset)
+{
+	switch (preset)
+	{
+		case V_SCALE_PRESET_FAST_BILINEAR: return SWS_FAST_BILINEAR;
+		case V_SCALE_PRESET_AREA:          return SWS_AREA;
+		default:                           return SWS_BICUBIC;
+	}
+}
+
+
+
+
 /**
  * v_colorspace_new:
- * @id: the codec type to handle.
+ * @src: the source pixel format.
+ * @dest: the destination pixel format.
+ * @width: the picture width.
+ * @height: the picture height.
  * @error: a #VError, or %NULL.
  *
- * Creates a new #VCodec which can handle @id type codecs.
+ * Creates a new #VColorspace converting pictures from @src to @dest
+ * without scaling them.
  *
  * Returns: a #VColorspace structure if successful, %NULL otherwise.
  */
@@ -80,58 +231,156 @@ v_colorspace_new (VPixelFormat src,
                   int width,
                   int height,
                   VError *error)
+{
+	return v_colorspace_new_scaled (src, dest, width, height,
+			width, height, V_SCALE_PRESET_BICUBIC, error);
+}
+
+
+
+
+/**
+ * v_colorspace_new_scaled:
+ * @src: the source pixel format.
+ * @dest: the destination pixel format.
+ * @width: the source picture width.
+ * @height: the source picture height.
+ * @dest_width: the width to scale pictures to.
+ * @dest_height: the height to scale pictures to.
+ * @preset: the #VScalePreset to scale with.
+ * @error: a #VError, or %NULL.
+ *
+ * Creates a new #VColorspace converting pictures from @src to @dest and
+ * scaling them to @dest_width by @dest_height, for outputs which can't
+ * scale on their own.
+ *
+ * Returns: a #VColorspace structure if successful, %NULL otherwise.
+ */
+VColorspace *
+v_colorspace_new_scaled (VPixelFormat src,
+                         VPixelFormat dest,
+                         int width,
+                         int height,
+                         int dest_width,
+                         int dest_height,
+                         VScalePreset preset,
+                         VError *error)
 {
 	VColorspace     *ret = v_new (VColorspace);
 	VColorspacePriv *priv = v_new (VColorspacePriv);
 	
+	bool scaled = width != dest_width || height != dest_height;
+	
 	
 	/* default values */
 	priv->src    = src;
 	priv->dest   = dest;
 	priv->width  = width;
 	priv->height = height;
+	priv->dest_width  = dest_width;
+	priv->dest_height = dest_height;
+	priv->preset = preset;
+	priv->flags  = get_sws_flags (preset);
+	priv->threads = 1;
+	priv->next_band = NO_BANDS;
+	priv->ref_count = 1;
+	
+	pthread_mutex_init (&priv->mutex, NULL);
+	pthread_cond_init  (&priv->done,  NULL);
 	
 	ret->priv = priv;
 	
 	
+	/* identical formats are handed through untouched */
+	if (src == dest && !scaled)
+	{
+		priv->passthrough = true;
+		return ret;
+	}
+	
 	
-	enum PixelFormat pix_src = PIX_FMT_YUV420P;
-	enum PixelFormat pix_dest = PIX_FMT_YUV420P;
+	/* unscaled conversions with a built-in kernel skip swscale */
+	priv->matrix = V_COLOR_MATRIX_BT601;
+	priv->native = !scaled && v_convert_supported (src, dest);
 	
+	priv->pix_src  = get_pix_fmt (src);
+	priv->pix_dest = get_pix_fmt (dest);
 	
-	if (src == V_PIXEL_FORMAT_RGB32)
-		pix_src = PIX_FMT_RGB32;
 	
-	if (dest == V_PIXEL_FORMAT_RGB32)
-		pix_dest = PIX_FMT_RGB32;
-		
+	/* setup the conversion and scale context */
+	if (!priv->native)
+		priv->convert_ctx = sws_getContext (width, height, priv->pix_src,
+				dest_width, dest_height, priv->pix_dest,
+				priv->flags, NULL, NULL, NULL);
 	
 	
+	/* converted pictures are recycled once the output is done with them */
+	priv->pool = v_frame_pool_new (dest, dest_width, dest_height);
 	
-	/* setup the conversion and scale context */
-	priv->convert_ctx = sws_getContext (width, height, pix_src,
-			width, height, pix_dest,
-			SWS_BICUBIC, NULL, NULL, NULL);
-
 	
+	return ret;
+}
 
 
-	priv->pic = (AVPicture *) avcodec_alloc_frame ();
 
-	int size = avpicture_get_size (PIX_FMT_YUV420P, width, height);
 
-	uint8_t *buf = v_mallocz (size);
 
-	avpicture_fill (priv->pic, buf, PIX_FMT_YUV420P, width, height);
+/*
+ * free_bands:
+ * @priv: a #VColorspacePriv.
+ *
+ * Releases the bands used for parallel conversion.
+ */
+static void
+free_bands (VColorspacePriv *priv)
+{
+	int i;
 	
+	if (priv->bands == NULL)
+		return;
 	
 	
-	return ret;
+	/* helper tasks still queued must not claim the released bands */
+	__atomic_store_n (&priv->next_band, NO_BANDS, __ATOMIC_RELEASE);
+	
+	for (i = 0; i < priv->threads; i++)
+	{
+		if (priv->bands[i].convert_ctx != NULL)
+			sws_freeContext (priv->bands[i].convert_ctx);
+		
+		v_free (priv->bands[i].buffer);
+	}
+	
+	v_free (priv->bands);
+	
+	priv->bands = NULL;
+	priv->threads = 1;
 }
 
 
 
 
+/*
+ * unref_priv:
+ * @priv: a #VColorspacePriv.
+ *
+ * Releases a reference to @priv. Helper tasks can still be queued after
+ * their conversion is done, so the last of them may outlive the owner.
+ */
+static void
+unref_priv (VColorspacePriv *priv)
+{
+	if (__sync_sub_and_fetch (&priv->ref_count, 1) > 0)
+		return;
+	
+	pthread_mutex_destroy (&priv->mutex);
+	pthread_cond_destroy  (&priv->done);
+	
+	v_free (priv);
+}
+
+
+
 
 /**
  * v_colorspace_free:
@@ -142,7 +391,21 @@ v_colorspace_new (VPixelFormat src,
 void
 v_colorspace_free (VColorspace *colorspace)
 {
-	v_free (colorspace->priv);
+	VColorspacePriv *priv = colorspace->priv;
+	
+	
+	/* free conversion components */
+	free_bands (priv);
+	
+	if (!priv->passthrough)
+	{
+		if (priv->convert_ctx != NULL)
+			sws_freeContext (priv->convert_ctx);
+		
+		v_frame_pool_free (priv->pool);
+	}
+	
+	unref_priv (priv);
 	v_free (colorspace);
 }
 
@@ -150,12 +413,414 @@ v_colorspace_free (VColorspace *colorspace)
 
 
 
+/**
+ * v_colorspace_set_matrix:
+ * @colorspace: a #VColorspace.
+ * @matrix: the #VColorMatrix to use.
+ *
+ * Sets the matrix used by the built-in YUV and RGB conversion kernels. The
+ * default is %V_COLOR_MATRIX_BT601 which matches swscale.
+ */
+void
+v_colorspace_set_matrix (VColorspace *colorspace, VColorMatrix matrix)
+{
+	colorspace->priv->matrix = matrix;
+}
+
+
+
+
+/*
+ * setup_band_scaler:
+ * @priv: a #VColorspacePriv.
+ * @band: the #Band to setup.
+ *
+ * Creates the swscale context of @band over its rows and the margins
+ * around them, along with the planes it converts into.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ */
+static bool
+setup_band_scaler (VColorspacePriv *priv, Band *band)
+{
+	int bottom = priv->height - band->first - band->rows;
+	int size = 0;
+	int bytes, plane_lines;
+	int i;
+	
+	
+	band->top = band->first < BAND_MARGIN ? band->first : BAND_MARGIN;
+	
+	if (bottom > BAND_MARGIN)
+		bottom = BAND_MARGIN;
+	
+	band->lines = band->top + band->rows + bottom;
+	
+	
+	band->convert_ctx = sws_getContext (priv->width, band->lines, priv->pix_src,
+			priv->dest_width, band->lines, priv->pix_dest,
+			priv->flags, NULL, NULL, NULL);
+	
+	if (band->convert_ctx == NULL)
+		return false;
+	
+	
+	for (i = 0; v_pixel_format_get_plane (priv->dest, i,
+			priv->dest_width, band->lines, &bytes, &plane_lines); i++)
+	{
+		band->scratch_linesize[i] = (bytes + 15) & ~15;
+		size += band->scratch_linesize[i] * plane_lines;
+	}
+	
+	band->buffer = v_malloc (size);
+	size = 0;
+	
+	for (i = 0; v_pixel_format_get_plane (priv->dest, i,
+			priv->dest_width, band->lines, &bytes, &plane_lines); i++)
+	{
+		band->scratch[i] = band->buffer + size;
+		size += band->scratch_linesize[i] * plane_lines;
+	}
+	
+	
+	return true;
+}
+
+
+
+
+/**
+ * v_colorspace_set_threads:
+ * @colorspace: a #VColorspace.
+ * @threads: the amount of bands to convert at once, or 0 for one per CPU.
+ *
+ * Splits conversions into horizontal bands which are converted concurrently
+ * by a worker pool shared between all colorspaces. The built-in kernels
+ * convert each pair of rows on their own. Conversions going through swscale
+ * get a context per band, which converts a margin of rows past each edge of
+ * the band and keeps only its own rows, so filtering across rows gives the
+ * same result as a single context. Conversions scaling pictures vertically
+ * stay on one thread.
+ */
+void
+v_colorspace_set_threads (VColorspace *colorspace, int threads)
+{
+	VColorspacePriv *priv = colorspace->priv;
+	int rows, i;
+	
+	
+	if (threads <= 0)
+		threads = v_thread_pool_cpu_count ();
+	
+	free_bands (priv);
+	
+	
+	/* nothing to split */
+	if (threads == 1 || priv->passthrough)
+		return;
+	
+	/* swscale bands can't share rows when scaling vertically, and paletted
+	 * pictures have no rows to offset in their palette plane */
+	if (!priv->native && (priv->dest_height != priv->height ||
+			priv->src == V_PIXEL_FORMAT_PAL8))
+		return;
+	
+	/* keep bands big enough to be worth a task */
+	if (threads > priv->height / 16)
+		threads = priv->height / 16;
+	
+	if (threads <= 1)
+		return;
+	
+	
+	/* bands start on every fourth row to keep whole chroma rows together
+	 * and swscale bands on the same chroma phase as the whole picture */
+	rows = ((priv->height + threads - 1) / threads + 3) & ~3;
+	threads = (priv->height + rows - 1) / rows;
+	
+	if (threads <= 1)
+		return;
+	
+	
+	priv->threads = threads;
+	priv->bands = v_mallocz (threads * sizeof (Band));
+	
+	for (i = 0; i < threads; i++)
+	{
+		Band *band = &priv->bands[i];
+		
+		band->priv  = priv;
+		band->first = i * rows;
+		band->rows  = i < threads - 1 ? rows : priv->height - band->first;
+		
+		if (!priv->native && !setup_band_scaler (priv, band))
+		{
+			free_bands (priv);
+			return;
+		}
+	}
+}
+
+
+
+
+/*
+ * plane_offset:
+ * @format: the pixel format of the plane.
+ * @plane: the plane index.
+ * @row: the picture row.
+ * @linesize: the size of the plane lines.
+ *
+ * Gets the byte offset of @row within a plane.
+ */
+static inline int
+plane_offset (VPixelFormat format, int plane, int row, int linesize)
+{
+	/* chroma planes are subsampled vertically */
+	if ((format == V_PIXEL_FORMAT_YUV420 || format == V_PIXEL_FORMAT_NV12) && plane > 0)
+		row /= 2;
+	
+	return row * linesize;
+}
+
+
+
+
+/*
+ * convert_rows:
+ * @priv: a #VColorspacePriv.
+ * @convert_ctx: the swscale context to use.
+ * @data: the source planes.
+ * @linesize: the size of each source plane line.
+ * @src_first: the first source row to convert.
+ * @src_rows: the amount of source rows to convert.
+ * @dest_data: the destination planes.
+ * @dest_linesize: the size of each destination plane line.
+ * @first: the destination row to convert to.
+ *
+ * Converts a range of rows from the source planes into the destination
+ * planes, scaling them if needed. Built-in kernels convert @src_rows rows
+ * without scaling.
+ */
+static void
+convert_rows (VColorspacePriv *priv,
+              struct SwsContext *convert_ctx,
+              uint8_t *data[4],
+              int linesize[4],
+              int src_first,
+              int src_rows,
+              uint8_t *dest_data[4],
+              int dest_linesize[4],
+              int first)
+{
+	uint8_t *src[4];
+	uint8_t *dest[4];
+	int i;
+	
+	
+	for (i = 0; i < 4; i++)
+	{
+		src[i]  = data[i] ? data[i] + plane_offset (priv->src, i, src_first, linesize[i]) : NULL;
+		dest[i] = dest_data[i] ?
+				dest_data[i] + plane_offset (priv->dest, i, first, dest_linesize[i]) : NULL;
+	}
+	
+	
+	if (!priv->native)
+	{
+		/* convert frame and scale it */
+		sws_scale (convert_ctx,
+				src,
+				linesize,
+				0, src_rows,
+				dest,
+				dest_linesize);
+	}
+	
+	else
+		v_convert_picture (priv->src, src, linesize,
+				priv->dest, dest, dest_linesize,
+				priv->width, src_rows, priv->matrix);
+}
+
+
+
+
+/*
+ * convert_band_rows:
+ * @priv: a #VColorspacePriv.
+ * @band: the #Band to convert.
+ *
+ * Converts the rows of @band. Swscale bands are converted with their
+ * margins into scratch planes, from which only the rows of the band are
+ * copied out.
+ */
+static void
+convert_band_rows (VColorspacePriv *priv, Band *band)
+{
+	int bytes, lines;
+	int i, y;
+	
+	
+	if (band->convert_ctx == NULL)
+	{
+		convert_rows (priv, NULL, band->data, band->linesize,
+				band->first, band->rows,
+				band->dest, band->dest_linesize, band->first);
+		return;
+	}
+	
+	
+	convert_rows (priv, band->convert_ctx, band->data, band->linesize,
+			band->first - band->top, band->lines,
+			band->scratch, band->scratch_linesize, 0);
+	
+	/* the margins are cut off, as the rows next to the edges differ */
+	for (i = 0; v_pixel_format_get_plane (priv->dest, i,
+			priv->dest_width, band->rows, &bytes, &lines); i++)
+	{
+		uint8_t *src  = band->scratch[i] +
+				plane_offset (priv->dest, i, band->top, band->scratch_linesize[i]);
+		uint8_t *dest = band->dest[i] +
+				plane_offset (priv->dest, i, band->first, band->dest_linesize[i]);
+		
+		for (y = 0; y < lines; y++)
+			memcpy (dest + y * band->dest_linesize[i],
+					src + y * band->scratch_linesize[i], bytes);
+	}
+}
+
+
+
+
+/*
+ * run_bands:
+ * @priv: a #VColorspacePriv.
+ *
+ * Claims and converts bands until none are left, signalling when the last
+ * one is done.
+ */
+static void
+run_bands (VColorspacePriv *priv)
+{
+	int i;
+	
+	while ((i = __sync_fetch_and_add (&priv->next_band, 1)) < priv->threads)
+	{
+		Band *band = &priv->bands[i];
+		
+		convert_band_rows (priv, band);
+		
+		
+		pthread_mutex_lock (&priv->mutex);
+		
+		if (--priv->pending == 0)
+			pthread_cond_broadcast (&priv->done);
+		
+		pthread_mutex_unlock (&priv->mutex);
+	}
+}
+
+
+
+
+/*
+ * convert_band:
+ * @data: a #VColorspacePriv.
+ *
+ * Helps converting bands on a worker thread. By the time the task runs the
+ * caller may have converted every band itself, in which case it does
+ * nothing.
+ */
+static void
+convert_band (void *data)
+{
+	VColorspacePriv *priv = (VColorspacePriv *) data;
+	
+	run_bands (priv);
+	unref_priv (priv);
+}
+
+
+
+
+/*
+ * convert_picture:
+ * @priv: a #VColorspacePriv.
+ * @data: the source planes.
+ * @linesize: the size of each source plane line.
+ * @dest: the destination planes.
+ * @dest_linesize: the size of each destination plane line.
+ *
+ * Converts the source planes into the destination planes.
+ */
+static void
+convert_picture (VColorspacePriv *priv,
+                 uint8_t *data[4],
+                 int linesize[4],
+                 uint8_t *dest[4],
+                 int dest_linesize[4])
+{
+	int i;
+	
+	
+	if (priv->bands == NULL)
+	{
+		convert_rows (priv, priv->convert_ctx, data, linesize, 0, priv->height,
+				dest, dest_linesize, 0);
+		return;
+	}
+	
+	
+	for (i = 0; i < priv->threads; i++)
+	{
+		priv->bands[i].data = data;
+		priv->bands[i].linesize = linesize;
+		priv->bands[i].dest = dest;
+		priv->bands[i].dest_linesize = dest_linesize;
+	}
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	priv->pending = priv->threads;
+	__atomic_store_n (&priv->next_band, 0, __ATOMIC_RELEASE);
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	__sync_fetch_and_add (&priv->ref_count, priv->threads - 1);
+	
+	
+	/* bands are claimed by whoever gets to them first, so the caller never
+	 * waits on a band that hasn't started, even when it is a worker itself */
+	for (i = 1; i < priv->threads; i++)
+		v_thread_pool_push (v_thread_pool_get_default (), convert_band, priv);
+	
+	run_bands (priv);
+	
+	
+	/* wait for bands claimed by the workers */
+	pthread_mutex_lock (&priv->mutex);
+	
+	while (priv->pending > 0)
+		pthread_cond_wait (&priv->done, &priv->mutex);
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+
 /**
  * v_colorspace_convert:
  * @colorspace: a #VColorspace.
  * @frame: a #VFrame to convert.
  *
- * Converts @frame to the specified colorspace/pixel format.
+ * Converts @frame to the specified colorspace/pixel format. Converted
+ * pictures come from a #VFramePool and own their planes. When no
+ * conversion is needed @frame itself is returned with an extra reference.
+ * Either way the returned frame must be released with v_frame_free().
  * 
  * Returns: a #VFrame if successful, %NULL otherwise.
  */
@@ -164,32 +829,24 @@ v_colorspace_convert (VColorspace *colorspace, VFrame *frame)
 {
 	VColorspacePriv *priv = colorspace->priv;
 	
+	
+	/* share the source planes instead of copying them */
+	if (priv->passthrough)
+		return v_frame_ref (frame);
+	
 
 	if (frame->type == V_FRAME_TYPE_VIDEO)
 	{
 		VFrameVideo *raw   = V_FRAME_VIDEO (frame);
-		VFrameVideo *video = v_frame_video_new ();
-
-
-		/* convert frame and scale it */
-		sws_scale (priv->convert_ctx,
-				raw->data,
-				raw->linesize,
-				0, priv->height,
-				priv->pic->data,
-				priv->pic->linesize);
-
-
+		VFrameVideo *video = v_frame_pool_get (priv->pool);
+		
+		video->pts = raw->pts;
+		video->interlaced = raw->interlaced;
+		video->top_field_first = raw->top_field_first;
 
-		video->data[0] = priv->pic->data[0];
-		video->data[1] = priv->pic->data[1];
-		video->data[2] = priv->pic->data[2];
-		video->data[3] = priv->pic->data[3];
 
-		video->linesize[0] = priv->pic->linesize[0];
-		video->linesize[1] = priv->pic->linesize[1];
-		video->linesize[2] = priv->pic->linesize[2];
-		video->linesize[3] = priv->pic->linesize[3];
+		convert_picture (priv, raw->data, raw->linesize,
+				video->data, video->linesize);
 		
 
 		return V_FRAME (video);
@@ -200,34 +857,28 @@ v_colorspace_convert (VColorspace *colorspace, VFrame *frame)
 	else
 	{
 		VFrameSubtitle *raw = V_FRAME_SUBTITLE (frame);
-		VFrameSubtitle *sub = v_frame_subtitle_new ();
+		VFrameVideo *pic = v_frame_pool_get (priv->pool);
+		VFrameSubtitle view = *raw;
+		VFrameSubtitle *sub;
 
 
-		/* convert frame and scale it */
-		sws_scale (priv->convert_ctx,
-				raw->data,
-				raw->linesize,
-				0, priv->height,
-				priv->pic->data,
-				priv->pic->linesize);
+		convert_picture (priv, raw->data, raw->linesize,
+				pic->data, pic->linesize);
 
 
+		/* the subtitle keeps its own copy of the pooled picture */
+		view.pixel_format = priv->dest;
+		view.x = raw->x * priv->dest_width / priv->width;
+		view.y = raw->y * priv->dest_height / priv->height;
+		view.w = priv->dest_width;
+		view.h = priv->dest_height;
 		
-		sub->x = raw->x;
-		sub->y = raw->y;
-		sub->w = raw->w;
-		sub->h = raw->h;
+		memcpy (view.data, pic->data, sizeof (view.data));
+		memcpy (view.linesize, pic->linesize, sizeof (view.linesize));
 		
-
-		sub->data[0] = priv->pic->data[0];
-		sub->data[1] = priv->pic->data[1];
-		sub->data[2] = priv->pic->data[2];
-		sub->data[3] = priv->pic->data[3];
-
-		sub->linesize[0] = priv->pic->linesize[0];
-		sub->linesize[1] = priv->pic->linesize[1];
-		sub->linesize[2] = priv->pic->linesize[2];
-		sub->linesize[3] = priv->pic->linesize[3];
+		sub = v_frame_subtitle_copy (&view);
+		
+		v_frame_free (V_FRAME (pic));
 		
 		
 		return V_FRAME (sub);
@@ -237,3 +888,243 @@ v_colorspace_convert (VColorspace *colorspace, VFrame *frame)
 
 
 
+
+
+/*
+ * copy_picture:
+ * @priv: a #VColorspacePriv.
+ * @data: the source planes.
+ * @linesize: the size of each source plane line.
+ * @dest: the destination planes.
+ * @dest_linesize: the size of each destination plane line.
+ *
+ * Copies the source planes line by line for passthrough colorspaces.
+ */
+static void
+copy_picture (VColorspacePriv *priv,
+              uint8_t *data[4],
+              int linesize[4],
+              uint8_t *dest[4],
+              int dest_linesize[4])
+{
+	int bytes, lines;
+	int i, y;
+	
+	
+	for (i = 0; v_pixel_format_get_plane (priv->src, i,
+			priv->width, priv->height, &bytes, &lines); i++)
+	{
+		for (y = 0; y < lines; y++)
+			memcpy (dest[i] + y * dest_linesize[i], data[i] + y * linesize[i], bytes);
+	}
+}
+
+
+
+
+/**
+ * v_colorspace_convert_into:
+ * @colorspace: a #VColorspace.
+ * @frame: a #VFrame to convert.
+ * @dest: the destination planes.
+ * @dest_linesize: the size of each destination plane line.
+ *
+ * Converts @frame straight into caller supplied planes, such as an output
+ * device buffer, saving the copy out of the colorspace picture. The planes
+ * are in the order of the destination pixel format and must be large
+ * enough to hold the whole picture at the destination size.
+ */
+void
+v_colorspace_convert_into (VColorspace *colorspace,
+                           VFrame *frame,
+                           uint8_t *dest[4],
+                           int dest_linesize[4])
+{
+	VColorspacePriv *priv = colorspace->priv;
+	
+	uint8_t **data;
+	int *linesize;
+	
+	
+	if (frame->type == V_FRAME_TYPE_VIDEO)
+	{
+		data = V_FRAME_VIDEO (frame)->data;
+		linesize = V_FRAME_VIDEO (frame)->linesize;
+	}
+	
+	else
+	{
+		data = V_FRAME_SUBTITLE (frame)->data;
+		linesize = V_FRAME_SUBTITLE (frame)->linesize;
+	}
+	
+	
+	if (priv->passthrough)
+		copy_picture (priv, data, linesize, dest, dest_linesize);
+	
+	else
+		convert_picture (priv, data, linesize, dest, dest_linesize);
+}
+
+
+
+
+
+/**
+ * v_colorspace_cache_new:
+ * @size: the maximum amount of colorspaces to keep.
+ *
+ * Creates an empty #VColorspaceCache. Once @size colorspaces are cached the
+ * least recently used one is free'd to make room for a new one.
+ *
+ * Returns: a #VColorspaceCache structure.
+ */
+VColorspaceCache *
+v_colorspace_cache_new (unsigned int size)
+{
+	VColorspaceCache *ret = v_new (VColorspaceCache);
+	VColorspaceCachePriv *priv = v_new (VColorspaceCachePriv);
+	
+	
+	/* default values */
+	priv->size = size > 0 ? size : 1;
+	priv->entries = v_list_new ();
+	
+	ret->priv = priv;
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_colorspace_cache_free:
+ * @cache: a #VColorspaceCache to free.
+ *
+ * Free's @cache along with all the colorspaces it holds.
+ */
+void
+v_colorspace_cache_free (VColorspaceCache *cache)
+{
+	VColorspaceCachePriv *priv = cache->priv;
+	VListNode *node;
+	
+	
+	for (node = priv->entries->first; node; node = node->next)
+		v_colorspace_free ((VColorspace *) node->data);
+	
+	
+	v_list_free (priv->entries);
+	v_free (priv);
+	v_free (cache);
+}
+
+
+
+
+/**
+ * v_colorspace_cache_get:
+ * @cache: a #VColorspaceCache.
+ * @src: the source pixel format.
+ * @dest: the destination pixel format.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @error: a #VError, or %NULL.
+ *
+ * Gets a colorspace converting from @src to @dest at the specified size,
+ * creating it if none is cached. The returned #VColorspace belongs to
+ * @cache and stays valid until another colorspace is requested, as it may
+ * then be evicted.
+ *
+ * Returns: a #VColorspace structure if successful, %NULL otherwise.
+ */
+VColorspace *
+v_colorspace_cache_get (VColorspaceCache *cache,
+                        VPixelFormat src,
+                        VPixelFormat dest,
+                        int width,
+                        int height,
+                        VError *error)
+{
+	return v_colorspace_cache_get_scaled (cache, src, dest, width, height,
+			width, height, V_SCALE_PRESET_BICUBIC, error);
+}
+
+
+
+
+/**
+ * v_colorspace_cache_get_scaled:
+ * @cache: a #VColorspaceCache.
+ * @src: the source pixel format.
+ * @dest: the destination pixel format.
+ * @width: the source picture width.
+ * @height: the source picture height.
+ * @dest_width: the width to scale pictures to.
+ * @dest_height: the height to scale pictures to.
+ * @preset: the #VScalePreset to scale with.
+ * @error: a #VError, or %NULL.
+ *
+ * Like v_colorspace_cache_get() but for colorspaces which also scale. The
+ * destination size and preset are part of what makes a cached colorspace
+ * match.
+ *
+ * Returns: a #VColorspace structure if successful, %NULL otherwise.
+ */
+VColorspace *
+v_colorspace_cache_get_scaled (VColorspaceCache *cache,
+                               VPixelFormat src,
+                               VPixelFormat dest,
+                               int width,
+                               int height,
+                               int dest_width,
+                               int dest_height,
+                               VScalePreset preset,
+                               VError *error)
+{
+	VColorspaceCachePriv *priv = cache->priv;
+	VListNode *node;
+	
+	
+	/* look for a matching colorspace */
+	for (node = priv->entries->first; node; node = node->next)
+	{
+		VColorspace *colorspace = (VColorspace *) node->data;
+		VColorspacePriv *cs = colorspace->priv;
+		
+		
+		if (cs->src == src && cs->dest == dest &&
+			cs->width == width && cs->height == height &&
+			cs->dest_width == dest_width && cs->dest_height == dest_height &&
+			cs->preset == preset)
+		{
+			/* move to the most recently used end */
+			v_list_remove (priv->entries, node);
+			v_list_append (priv->entries, colorspace);
+			
+			return colorspace;
+		}
+	}
+	
+	
+	/* evict the least recently used colorspace */
+	if (priv->entries->length >= priv->size)
+	{
+		node = priv->entries->first;
+		
+		v_colorspace_free ((VColorspace *) node->data);
+		v_list_remove (priv->entries, node);
+	}
+	
+	
+	VColorspace *ret = v_colorspace_new_scaled (src, dest, width, height,
+			dest_width, dest_height, preset, error);
+	
+	if (ret != NULL)
+		v_list_append (priv->entries, ret);
+	
+	
+	return ret;
+}
@@ -0,0 +1,617 @@
+/***************************************************************************
+ *            compositor.c
+ *
+ *  Oct 19, 2026 6:50:59 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "compositor.h"
+#include "mem.h"
+#include <pthread.h>
+#include <string.h>  /* strcmp */
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <emmintrin.h>
+#endif
+
+
+
+/*
+ * BlendRowFunc:
+ *
+ * Blends @src over @dest weighted by @alpha, returning the amount of
+ * samples done. The remaining samples are finished by the scalar blender.
+ */
+typedef int BlendRowFunc (uint8_t *dest,
+                          const uint8_t *src,
+                          const uint8_t *alpha,
+                          int length);
+
+
+
+/*
+ * VCompositorPriv:
+ * @x: the horizontal position of the overlay, always even.
+ * @y: the vertical position of the overlay, always even.
+ * @w: the overlay width, always even.
+ * @h: the overlay height, always even.
+ * @buffer: memory holding all the overlay planes.
+ * @planes: the overlay Y, U and V planes.
+ * @alpha: the overlay alpha at luma resolution.
+ * @chroma_alpha: the overlay alpha at chroma resolution.
+ *
+ * Private structure for #VCompositor.
+ */
+struct _VCompositorPriv
+{
+	pthread_mutex_t mutex;
+	VColorMatrix matrix;
+	
+	int x, y;
+	int w, h;
+	
+	uint8_t *buffer;
+	uint8_t *planes[3];
+	uint8_t *alpha;
+	uint8_t *chroma_alpha;
+};
+
+
+
+static BlendRowFunc *blend_kernel;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+
+
+
+/*
+ * scalar_blend_row:
+ *
+ * Reference blender for the samples from @start onwards. Dividing by 255
+ * is done with a rounded shift which the vector kernel repeats exactly.
+ */
+static void
+scalar_blend_row (uint8_t *dest,
+                  const uint8_t *src,
+                  const uint8_t *alpha,
+                  int start,
+                  int length)
+{
+	int i;
+	
+	for (i = start; i < length; i++)
+	{
+		unsigned int x = src[i] * alpha[i] + dest[i] * (255 - alpha[i]) + 128;
+		dest[i] = (x + (x >> 8)) >> 8;
+	}
+}
+
+
+
+
+/*
+ * blend_samples:
+ *
+ * Scalar blender for samples @step bytes apart in @dest, as found in
+ * interleaved chroma and packed pictures.
+ */
+static void
+blend_samples (uint8_t *dest,
+               int step,
+               const uint8_t *src,
+               const uint8_t *alpha,
+               int length)
+{
+	int i;
+	
+	for (i = 0; i < length; i++)
+	{
+		unsigned int x = src[i] * alpha[i] + dest[i * step] * (255 - alpha[i]) + 128;
+		dest[i * step] = (x + (x >> 8)) >> 8;
+	}
+}
+
+
+
+
+static int
+none_blend_row (uint8_t *dest,
+                const uint8_t *src,
+                const uint8_t *alpha,
+                int length)
+{
+	return 0;
+}
+
+
+
+
+#ifdef HAVE_X86_KERNELS
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_blend_row (uint8_t *dest,
+                const uint8_t *src,
+                const uint8_t *alpha,
+                int length)
+{
+	const __m128i zero  = _mm_setzero_si128 ();
+	const __m128i full  = _mm_set1_epi16 (255);
+	const __m128i round = _mm_set1_epi16 (128);
+	
+	int i;
+	
+	
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		__m128i a = _mm_loadu_si128 ((const __m128i *) (alpha + i));
+		
+		/* transparent spans are common around the text */
+		if (_mm_movemask_epi8 (_mm_cmpeq_epi8 (a, zero)) == 0xffff)
+			continue;
+		
+		
+		__m128i s = _mm_loadu_si128 ((const __m128i *) (src + i));
+		__m128i d = _mm_loadu_si128 ((const __m128i *) (dest + i));
+		
+		__m128i a_lo = _mm_unpacklo_epi8 (a, zero);
+		__m128i a_hi = _mm_unpackhi_epi8 (a, zero);
+		
+		
+		/* the 16 bit sums cannot overflow since they stay below 65536 */
+		__m128i lo = _mm_add_epi16 (_mm_add_epi16 (
+				_mm_mullo_epi16 (_mm_unpacklo_epi8 (s, zero), a_lo),
+				_mm_mullo_epi16 (_mm_unpacklo_epi8 (d, zero), _mm_sub_epi16 (full, a_lo))), round);
+		
+		__m128i hi = _mm_add_epi16 (_mm_add_epi16 (
+				_mm_mullo_epi16 (_mm_unpackhi_epi8 (s, zero), a_hi),
+				_mm_mullo_epi16 (_mm_unpackhi_epi8 (d, zero), _mm_sub_epi16 (full, a_hi))), round);
+		
+		lo = _mm_srli_epi16 (_mm_add_epi16 (lo, _mm_srli_epi16 (lo, 8)), 8);
+		hi = _mm_srli_epi16 (_mm_add_epi16 (hi, _mm_srli_epi16 (hi, 8)), 8);
+		
+		_mm_storeu_si128 ((__m128i *) (dest + i), _mm_packus_epi16 (lo, hi));
+	}
+	
+	
+	return i;
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+
+
+
+static void
+init_kernels (void)
+{
+	blend_kernel = none_blend_row;
+	
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	
+	if (__builtin_cpu_supports ("sse2"))
+		blend_kernel = sse2_blend_row;
+#endif
+}
+
+
+
+/*
+ * set_kernels:
+ * @name: the kernel to use.
+ *
+ * Switches the row blender to the @name kernel.
+ *
+ * Returns: %true if the CPU supports @name, %false otherwise.
+ */
+static bool
+set_kernels (const char *name)
+{
+	if (strcmp (name, "c") == 0)
+	{
+		blend_kernel = none_blend_row;
+		return true;
+	}
+	
+	
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	
+	if (strcmp (name, "sse2") == 0 && __builtin_cpu_supports ("sse2"))
+	{
+		blend_kernel = sse2_blend_row;
+		return true;
+	}
+#endif
+	
+	return false;
+}
+
+
+
+static inline void
+blend_row (uint8_t *dest, const uint8_t *src, const uint8_t *alpha, int length)
+{
+	int done = blend_kernel (dest, src, alpha, length);
+	scalar_blend_row (dest, src, alpha, done, length);
+}
+
+
+
+
+/**
+ * v_compositor_new:
+ *
+ * Creates a new #VCompositor without a subpicture.
+ *
+ * Returns: a #VCompositor structure.
+ */
+VCompositor *
+v_compositor_new (void)
+{
+	VCompositor *ret = v_new (VCompositor);
+	VCompositorPriv *priv = v_new (VCompositorPriv);
+	
+	
+	pthread_once (&init_once, init_kernels);
+	
+	
+	/* default values */
+	pthread_mutex_init (&priv->mutex, NULL);
+	priv->matrix = V_COLOR_MATRIX_BT601;
+	priv->buffer = NULL;
+	
+	ret->priv = priv;
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_compositor_free:
+ * @compositor: a #VCompositor to free.
+ *
+ * Free's @compositor and its subpicture.
+ */
+void
+v_compositor_free (VCompositor *compositor)
+{
+	VCompositorPriv *priv = compositor->priv;
+	
+	
+	pthread_mutex_destroy (&priv->mutex);
+	
+	if (priv->buffer != NULL)
+		v_free (priv->buffer);
+	
+	v_free (priv);
+	v_free (compositor);
+}
+
+
+
+
+/**
+ * v_compositor_set_matrix:
+ * @compositor: a #VCompositor.
+ * @matrix: the #VColorMatrix of the video.
+ *
+ * Sets the matrix used to convert subpicture colours. It applies from the
+ * next subpicture onwards.
+ */
+void
+v_compositor_set_matrix (VCompositor *compositor, VColorMatrix matrix)
+{
+	compositor->priv->matrix = matrix;
+}
+
+
+
+
+/**
+ * v_compositor_set_kernel:
+ * @name: the kernel to use, "c" or "sse2".
+ *
+ * Overrides the blend kernel picked for the running CPU, so each one can be
+ * tested and timed. No blending may run while the kernel changes.
+ *
+ * Returns: %true if the CPU supports @name, %false otherwise.
+ */
+bool
+v_compositor_set_kernel (const char *name)
+{
+	pthread_once (&init_once, init_kernels);
+	return set_kernels (name);
+}
+
+
+
+
+/*
+ * get_pixel:
+ * @subpic: a #VFrameSubtitle.
+ * @x: the horizontal position relative to the overlay.
+ * @y: the vertical position relative to the overlay.
+ *
+ * Gets an RGB32 subpicture pixel, transparent outside of the subpicture.
+ */
+static inline uint32_t
+get_pixel (VFrameSubtitle *subpic, int x, int y)
+{
+	if (x < 0 || y < 0 || x >= subpic->w || y >= subpic->h)
+		return 0;
+	
+	
+	if (subpic->pixel_format == V_PIXEL_FORMAT_PAL8)
+	{
+		const uint32_t *palette = (const uint32_t *) subpic->data[1];
+		return palette[subpic->data[0][y * subpic->linesize[0] + x]];
+	}
+	
+	return ((const uint32_t *) (subpic->data[0] + y * subpic->linesize[0]))[x];
+}
+
+
+
+
+/**
+ * v_compositor_set_subpicture:
+ * @compositor: a #VCompositor.
+ * @subpic: a #VFrameSubtitle in PAL8 or RGB32, or %NULL.
+ *
+ * Sets the subpicture blended over the following frames, replacing the
+ * previous one. The subpicture is converted to YUV420 with its alpha once
+ * here so that blending does no conversion. An empty or %NULL subpicture
+ * clears the overlay.
+ */
+void
+v_compositor_set_subpicture (VCompositor *compositor, VFrameSubtitle *subpic)
+{
+	VCompositorPriv *priv = compositor->priv;
+	
+	uint8_t *buffer = NULL;
+	uint8_t *planes[3];
+	uint8_t *alpha = NULL, *chroma_alpha = NULL;
+	int x = 0, y = 0, w = 0, h = 0;
+	
+	
+	if (subpic != NULL && subpic->w > 0 && subpic->h > 0 &&
+		(subpic->pixel_format == V_PIXEL_FORMAT_PAL8 ||
+		 subpic->pixel_format == V_PIXEL_FORMAT_RGB32))
+	{
+		/* align to whole chroma samples, padding with transparency */
+		x = subpic->x & ~1;
+		y = subpic->y & ~1;
+		w = (subpic->x + subpic->w - x + 1) & ~1;
+		h = (subpic->y + subpic->h - y + 1) & ~1;
+		
+		int chroma = (w / 2) * (h / 2);
+		
+		buffer = v_malloc (w * h * 2 + chroma * 3);
+		
+		planes[0]    = buffer;
+		alpha        = planes[0] + w * h;
+		planes[1]    = alpha + w * h;
+		planes[2]    = planes[1] + chroma;
+		chroma_alpha = planes[2] + chroma;
+		
+		
+		int bx, by, i;
+		
+		for (by = 0; by < h / 2; by++)
+		{
+			for (bx = 0; bx < w / 2; bx++)
+			{
+				unsigned int sum_a = 0, sum_u = 0, sum_v = 0;
+				
+				for (i = 0; i < 4; i++)
+				{
+					int px = bx * 2 + (i & 1);
+					int py = by * 2 + (i >> 1);
+					
+					uint32_t argb = get_pixel (subpic, x + px - subpic->x, y + py - subpic->y);
+					uint8_t a = argb >> 24;
+					uint8_t cy, cu, cv;
+					
+					v_convert_pixel_rgb32_to_yuv (argb, &cy, &cu, &cv, priv->matrix);
+					
+					planes[0][py * w + px] = cy;
+					alpha[py * w + px] = a;
+					
+					sum_a += a;
+					sum_u += a * cu;
+					sum_v += a * cv;
+				}
+				
+				
+				/* chroma is weighted by alpha so transparent edges don't bleed */
+				int pos = by * (w / 2) + bx;
+				
+				planes[1][pos] = sum_a ? (sum_u + sum_a / 2) / sum_a : 128;
+				planes[2][pos] = sum_a ? (sum_v + sum_a / 2) / sum_a : 128;
+				chroma_alpha[pos] = (sum_a + 2) >> 2;
+			}
+		}
+	}
+	
+	
+	/* swap in the new overlay */
+	pthread_mutex_lock (&priv->mutex);
+	
+	if (priv->buffer != NULL)
+		v_free (priv->buffer);
+	
+	priv->buffer = buffer;
+	priv->x = x;
+	priv->y = y;
+	priv->w = w;
+	priv->h = h;
+	
+	if (buffer != NULL)
+	{
+		priv->planes[0] = planes[0];
+		priv->planes[1] = planes[1];
+		priv->planes[2] = planes[2];
+		priv->alpha = alpha;
+		priv->chroma_alpha = chroma_alpha;
+	}
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+/**
+ * v_compositor_blend:
+ * @compositor: a #VCompositor.
+ * @format: the #VPixelFormat of the picture, YUV420, NV12, YUY2 or UYVY.
+ * @data: the planes to blend into.
+ * @linesize: the size of each plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ *
+ * Blends the current subpicture into the picture in place. Only the rows
+ * and columns covered by the subpicture are read or written. Packed 4:2:2
+ * pictures repeat each overlay chroma row on both of its luma rows.
+ */
+void
+v_compositor_blend (VCompositor *compositor,
+                    VPixelFormat format,
+                    uint8_t *data[4],
+                    int linesize[4],
+                    int width,
+                    int height)
+{
+	VCompositorPriv *priv = compositor->priv;
+	int row, i;
+	
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	if (priv->buffer == NULL)
+	{
+		pthread_mutex_unlock (&priv->mutex);
+		return;
+	}
+	
+	
+	/* clip the overlay to the picture */
+	int right  = priv->x + priv->w < width  ? priv->x + priv->w : width;
+	int bottom = priv->y + priv->h < height ? priv->y + priv->h : height;
+	
+	
+	int chroma_w  = priv->w / 2;
+	int chroma_x  = priv->x / 2;
+	int chroma_y  = priv->y / 2;
+	int chroma_right  = (right + 1) / 2;
+	int chroma_bottom = (bottom + 1) / 2;
+	
+	
+	switch (format)
+	{
+		case V_PIXEL_FORMAT_YUV420:
+		case V_PIXEL_FORMAT_NV12:
+			for (row = priv->y; row < bottom; row++)
+			{
+				int offset = (row - priv->y) * priv->w;
+				
+				blend_row (data[0] + row * linesize[0] + priv->x,
+						priv->planes[0] + offset,
+						priv->alpha + offset,
+						right - priv->x);
+			}
+			
+			
+			for (row = chroma_y; row < chroma_bottom; row++)
+			{
+				int offset = (row - chroma_y) * chroma_w;
+				
+				/* NV12 interleaves both chroma planes in the second one */
+				for (i = 1; i < 3; i++)
+				{
+					if (format == V_PIXEL_FORMAT_YUV420)
+						blend_row (data[i] + row * linesize[i] + chroma_x,
+								priv->planes[i] + offset,
+								priv->chroma_alpha + offset,
+								chroma_right - chroma_x);
+					else
+						blend_samples (data[1] + row * linesize[1] + chroma_x * 2 + i - 1, 2,
+								priv->planes[i] + offset,
+								priv->chroma_alpha + offset,
+								chroma_right - chroma_x);
+				}
+			}
+			
+			break;
+			
+			
+		case V_PIXEL_FORMAT_YUY2:
+		case V_PIXEL_FORMAT_UYVY:
+		{
+			/* byte positions of Y, U and V within each Y0 U Y1 V group */
+			int y_pos = format == V_PIXEL_FORMAT_YUY2 ? 0 : 1;
+			int u_pos = format == V_PIXEL_FORMAT_YUY2 ? 1 : 0;
+			int v_pos = u_pos + 2;
+			
+			for (row = priv->y; row < bottom; row++)
+			{
+				uint8_t *line = data[0] + row * linesize[0];
+				int offset = (row - priv->y) * priv->w;
+				int chroma_offset = ((row - priv->y) / 2) * chroma_w;
+				
+				blend_samples (line + priv->x * 2 + y_pos, 2,
+						priv->planes[0] + offset,
+						priv->alpha + offset,
+						right - priv->x);
+				
+				/* an odd last pixel is repeated to fill its pair */
+				if (right == width && (width & 1) && right > priv->x)
+					line[width * 2 + y_pos] = line[width * 2 - 2 + y_pos];
+				
+				blend_samples (line + chroma_x * 4 + u_pos, 4,
+						priv->planes[1] + chroma_offset,
+						priv->chroma_alpha + chroma_offset,
+						chroma_right - chroma_x);
+				
+				blend_samples (line + chroma_x * 4 + v_pos, 4,
+						priv->planes[2] + chroma_offset,
+						priv->chroma_alpha + chroma_offset,
+						chroma_right - chroma_x);
+			}
+			
+			break;
+		}
+		
+		
+		default:
+			break;
+	}
+	
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
@@ -0,0 +1,1394 @@
+/***************************************************************************
+ *            convert.c
+ *
+ *  Oct 19, 2026 6:46:44 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "convert.h"
+#include <string.h>  /* memcpy, strcmp */
+#include <stdbool.h>
+#include <pthread.h>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+
+
+/* fixed point precision of the conversion coefficients */
+#define SHIFT 13
+#define ROUND (1 << (SHIFT - 1))
+
+
+
+/*
+ * YuvToRgb:
+ *
+ * Coefficients converting limited range YUV to RGB.
+ */
+typedef struct _YuvToRgb
+{
+	int y;
+	int rv;
+	int gu, gv;
+	int bu;
+} YuvToRgb;
+
+
+
+/*
+ * RgbToYuv:
+ *
+ * Coefficients converting RGB to limited range YUV.
+ */
+typedef struct _RgbToYuv
+{
+	int yr, yg, yb;
+	int ur, ug, ub;
+	int vr, vg, vb;
+} RgbToYuv;
+
+
+
+/* indexed by VColorMatrix */
+static const YuvToRgb yuv_to_rgb[] =
+{
+	{ 9539, 13075, -3209, -6660, 16525 },
+	{ 9539, 14686, -1747, -4366, 17305 }
+};
+
+static const RgbToYuv rgb_to_yuv[] =
+{
+	{ 2104, 4130, 802, -1214, -2384, 3598, 3598, -3013, -585 },
+	{ 1496, 5032, 508,  -824, -2774, 3598, 3598, -3268, -330 }
+};
+
+
+
+
+/*
+ * YuvRowFunc:
+ *
+ * Converts a row of YUV420 to RGB32, returning the amount of pixels done.
+ * The remaining pixels are finished by the scalar row converter.
+ */
+typedef int YuvRowFunc (const uint8_t *y,
+                        const uint8_t *u,
+                        const uint8_t *v,
+                        uint32_t *dest,
+                        int width,
+                        const YuvToRgb *m);
+
+
+/*
+ * RgbRowFunc:
+ *
+ * Converts two rows of RGB32 to YUV420, returning the amount of pixels done.
+ * The remaining pixels are finished by the scalar row converter.
+ */
+typedef int RgbRowFunc (const uint32_t *src0,
+                        const uint32_t *src1,
+                        uint8_t *y0,
+                        uint8_t *y1,
+                        uint8_t *u,
+                        uint8_t *v,
+                        int width,
+                        const RgbToYuv *m);
+
+
+
+/*
+ * PackRowFunc:
+ *
+ * Packs a row of YUV420 into packed 4:2:2, returning the amount of pixels
+ * done. The remaining pixels are finished by the scalar row packer.
+ */
+typedef int PackRowFunc (const uint8_t *y,
+                         const uint8_t *u,
+                         const uint8_t *v,
+                         uint8_t *dest,
+                         int width);
+
+
+/*
+ * InterleaveRowFunc:
+ *
+ * Interleaves a row of U and V samples, returning the amount of samples
+ * done. The remaining samples are finished by the scalar row interleaver.
+ */
+typedef int InterleaveRowFunc (const uint8_t *u,
+                               const uint8_t *v,
+                               uint8_t *dest,
+                               int length);
+
+
+
+/*
+ * Kernels:
+ *
+ * The row converters picked for the running CPU.
+ */
+typedef struct _Kernels
+{
+	const char *name;
+	
+	YuvRowFunc *yuv_row;
+	RgbRowFunc *rgb_row;
+	
+	PackRowFunc *yuy2_row;
+	PackRowFunc *uyvy_row;
+	InterleaveRowFunc *interleave_row;
+} Kernels;
+
+
+
+static Kernels kernels;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+
+
+
+static inline uint8_t
+clip (int value)
+{
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+
+
+
+/*
+ * scalar_yuv_row:
+ *
+ * Reference YUV420 to RGB32 converter for the pixels from @start onwards.
+ * The vector kernels must produce identical results.
+ */
+static void
+scalar_yuv_row (const uint8_t *y,
+                const uint8_t *u,
+                const uint8_t *v,
+                uint32_t *dest,
+                int start,
+                int width,
+                const YuvToRgb *m)
+{
+	int x;
+	
+	for (x = start; x < width; x++)
+	{
+		int luma = m->y * (y[x] - 16);
+		int cu = u[x / 2] - 128;
+		int cv = v[x / 2] - 128;
+		
+		int r = clip ((luma + m->rv * cv + ROUND) >> SHIFT);
+		int g = clip ((luma + m->gu * cu + m->gv * cv + ROUND) >> SHIFT);
+		int b = clip ((luma + m->bu * cu + ROUND) >> SHIFT);
+		
+		dest[x] = 0xff000000u | (r << 16) | (g << 8) | b;
+	}
+}
+
+
+
+
+/*
+ * scalar_rgb_row:
+ *
+ * Reference RGB32 to YUV420 converter for the pixels from @start onwards.
+ * Chroma is the rounded average of each 2x2 block. When @y1 is %NULL the
+ * second row is a repeat of the first one.
+ */
+static void
+scalar_rgb_row (const uint32_t *src0,
+                const uint32_t *src1,
+                uint8_t *y0,
+                uint8_t *y1,
+                uint8_t *u,
+                uint8_t *v,
+                int start,
+                int width,
+                const RgbToYuv *m)
+{
+	int x;
+	
+	
+	/* luma */
+	for (x = start; x < width; x++)
+	{
+		uint32_t p0 = src0[x];
+		uint32_t p1 = src1[x];
+		
+		y0[x] = clip (((m->yr * ((p0 >> 16) & 0xff) +
+				m->yg * ((p0 >> 8) & 0xff) +
+				m->yb * (p0 & 0xff) + ROUND) >> SHIFT) + 16);
+		
+		if (y1 != NULL)
+			y1[x] = clip (((m->yr * ((p1 >> 16) & 0xff) +
+					m->yg * ((p1 >> 8) & 0xff) +
+					m->yb * (p1 & 0xff) + ROUND) >> SHIFT) + 16);
+	}
+	
+	
+	/* chroma */
+	for (x = start; x < width; x += 2)
+	{
+		int next = x + 1 < width ? x + 1 : x;
+		uint32_t p[4] = { src0[x], src0[next], src1[x], src1[next] };
+		
+		int r = 2, g = 2, b = 2;
+		int i;
+		
+		for (i = 0; i < 4; i++)
+		{
+			r += (p[i] >> 16) & 0xff;
+			g += (p[i] >> 8) & 0xff;
+			b += p[i] & 0xff;
+		}
+		
+		r >>= 2;
+		g >>= 2;
+		b >>= 2;
+		
+		u[x / 2] = clip (((m->ur * r + m->ug * g + m->ub * b + ROUND) >> SHIFT) + 128);
+		v[x / 2] = clip (((m->vr * r + m->vg * g + m->vb * b + ROUND) >> SHIFT) + 128);
+	}
+}
+
+
+
+
+/*
+ * scalar_pack_row:
+ *
+ * Reference YUV420 to YUY2 or UYVY packer for the pixels from @start
+ * onwards. An odd last pixel is repeated to fill its pair.
+ */
+static void
+scalar_pack_row (const uint8_t *y,
+                 const uint8_t *u,
+                 const uint8_t *v,
+                 uint8_t *dest,
+                 int start,
+                 int width,
+                 bool uyvy)
+{
+	int x;
+	
+	for (x = start; x < width; x += 2)
+	{
+		uint8_t *out = dest + x * 2;
+		uint8_t y1 = x + 1 < width ? y[x + 1] : y[x];
+		
+		if (uyvy)
+		{
+			out[0] = u[x / 2];
+			out[1] = y[x];
+			out[2] = v[x / 2];
+			out[3] = y1;
+		}
+		
+		else
+		{
+			out[0] = y[x];
+			out[1] = u[x / 2];
+			out[2] = y1;
+			out[3] = v[x / 2];
+		}
+	}
+}
+
+
+
+static void
+scalar_interleave_row (const uint8_t *u,
+                       const uint8_t *v,
+                       uint8_t *dest,
+                       int start,
+                       int length)
+{
+	int i;
+	
+	for (i = start; i < length; i++)
+	{
+		dest[i * 2]     = u[i];
+		dest[i * 2 + 1] = v[i];
+	}
+}
+
+
+
+
+static int
+none_pack_row (const uint8_t *y,
+               const uint8_t *u,
+               const uint8_t *v,
+               uint8_t *dest,
+               int width)
+{
+	return 0;
+}
+
+
+
+static int
+none_interleave_row (const uint8_t *u,
+                     const uint8_t *v,
+                     uint8_t *dest,
+                     int length)
+{
+	return 0;
+}
+
+
+
+static int
+none_yuv_row (const uint8_t *y,
+              const uint8_t *u,
+              const uint8_t *v,
+              uint32_t *dest,
+              int width,
+              const YuvToRgb *m)
+{
+	return 0;
+}
+
+
+
+static int
+none_rgb_row (const uint32_t *src0,
+              const uint32_t *src1,
+              uint8_t *y0,
+              uint8_t *y1,
+              uint8_t *u,
+              uint8_t *v,
+              int width,
+              const RgbToYuv *m)
+{
+	return 0;
+}
+
+
+
+
+#ifdef HAVE_X86_KERNELS
+
+
+/* packs two 16 bit coefficients for use with madd */
+#define PAIR(a, b) ((int) (((uint32_t) (uint16_t) (b) << 16) | (uint16_t) (a)))
+
+
+
+/*
+ * The vector kernels compute exactly the same 32 bit sums as the scalar
+ * converters using madd on interleaved 16 bit values, then clamp with
+ * saturating packs, so the output is bit identical.
+ */
+
+
+__attribute__ ((target ("sse2")))
+static inline __m128i
+sse2_scale (__m128i sum, __m128i round, __m128i offset)
+{
+	return _mm_add_epi32 (_mm_srai_epi32 (_mm_add_epi32 (sum, round), SHIFT), offset);
+}
+
+
+
+/* weighted sum of four BGRA pixels, expanded to 16 bits as two halves */
+__attribute__ ((target ("sse2")))
+static inline __m128i
+sse2_weigh (__m128i lo, __m128i hi, __m128i coef)
+{
+	__m128i a = _mm_madd_epi16 (lo, coef);
+	__m128i b = _mm_madd_epi16 (hi, coef);
+	
+	a = _mm_add_epi32 (a, _mm_srli_epi64 (a, 32));
+	b = _mm_add_epi32 (b, _mm_srli_epi64 (b, 32));
+	
+	return _mm_unpacklo_epi64 (_mm_shuffle_epi32 (a, _MM_SHUFFLE (2, 0, 2, 0)),
+	                           _mm_shuffle_epi32 (b, _MM_SHUFFLE (2, 0, 2, 0)));
+}
+
+
+
+/* averages the 2x2 blocks of four pixels from two rows */
+__attribute__ ((target ("sse2")))
+static inline __m128i
+sse2_average (__m128i row0, __m128i row1, __m128i two)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	
+	__m128i lo = _mm_add_epi16 (_mm_unpacklo_epi8 (row0, zero),
+	                            _mm_unpacklo_epi8 (row1, zero));
+	__m128i hi = _mm_add_epi16 (_mm_unpackhi_epi8 (row0, zero),
+	                            _mm_unpackhi_epi8 (row1, zero));
+	
+	lo = _mm_add_epi16 (lo, _mm_srli_si128 (lo, 8));
+	hi = _mm_add_epi16 (hi, _mm_srli_si128 (hi, 8));
+	
+	return _mm_srli_epi16 (_mm_add_epi16 (_mm_unpacklo_epi64 (lo, hi), two), 2);
+}
+
+
+
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_yuv_row (const uint8_t *y,
+              const uint8_t *u,
+              const uint8_t *v,
+              uint32_t *dest,
+              int width,
+              const YuvToRgb *m)
+{
+	const __m128i zero   = _mm_setzero_si128 ();
+	const __m128i y_off  = _mm_set1_epi16 (16);
+	const __m128i c_off  = _mm_set1_epi16 (128);
+	const __m128i round  = _mm_set1_epi32 (ROUND);
+	const __m128i alpha  = _mm_set1_epi8 ((char) 0xff);
+	
+	const __m128i c_r  = _mm_set1_epi32 (PAIR (m->y, m->rv));
+	const __m128i c_g  = _mm_set1_epi32 (PAIR (m->y, m->gu));
+	const __m128i c_gv = _mm_set1_epi32 (PAIR (m->gv, 0));
+	const __m128i c_b  = _mm_set1_epi32 (PAIR (m->y, m->bu));
+	
+	int x;
+	
+	
+	for (x = 0; x + 8 <= width; x += 8)
+	{
+		int32_t cu, cv;
+		
+		memcpy (&cu, u + x / 2, 4);
+		memcpy (&cv, v + x / 2, 4);
+		
+		
+		/* expand to signed 16 bit, repeating each chroma sample */
+		__m128i ly = _mm_loadl_epi64 ((const __m128i *) (y + x));
+		__m128i lu = _mm_cvtsi32_si128 (cu);
+		__m128i lv = _mm_cvtsi32_si128 (cv);
+		
+		ly = _mm_sub_epi16 (_mm_unpacklo_epi8 (ly, zero), y_off);
+		lu = _mm_sub_epi16 (_mm_unpacklo_epi8 (_mm_unpacklo_epi8 (lu, lu), zero), c_off);
+		lv = _mm_sub_epi16 (_mm_unpacklo_epi8 (_mm_unpacklo_epi8 (lv, lv), zero), c_off);
+		
+		__m128i yv_lo = _mm_unpacklo_epi16 (ly, lv);
+		__m128i yv_hi = _mm_unpackhi_epi16 (ly, lv);
+		__m128i yu_lo = _mm_unpacklo_epi16 (ly, lu);
+		__m128i yu_hi = _mm_unpackhi_epi16 (ly, lu);
+		__m128i v_lo  = _mm_unpacklo_epi16 (lv, zero);
+		__m128i v_hi  = _mm_unpackhi_epi16 (lv, zero);
+		
+		
+		/* red */
+		__m128i r = _mm_packs_epi32 (
+				_mm_srai_epi32 (_mm_add_epi32 (_mm_madd_epi16 (yv_lo, c_r), round), SHIFT),
+				_mm_srai_epi32 (_mm_add_epi32 (_mm_madd_epi16 (yv_hi, c_r), round), SHIFT));
+		
+		/* green */
+		__m128i g = _mm_packs_epi32 (
+				_mm_srai_epi32 (_mm_add_epi32 (_mm_add_epi32 (_mm_madd_epi16 (yu_lo, c_g),
+						_mm_madd_epi16 (v_lo, c_gv)), round), SHIFT),
+				_mm_srai_epi32 (_mm_add_epi32 (_mm_add_epi32 (_mm_madd_epi16 (yu_hi, c_g),
+						_mm_madd_epi16 (v_hi, c_gv)), round), SHIFT));
+		
+		/* blue */
+		__m128i b = _mm_packs_epi32 (
+				_mm_srai_epi32 (_mm_add_epi32 (_mm_madd_epi16 (yu_lo, c_b), round), SHIFT),
+				_mm_srai_epi32 (_mm_add_epi32 (_mm_madd_epi16 (yu_hi, c_b), round), SHIFT));
+		
+		
+		/* clamp and interleave into BGRA */
+		r = _mm_packus_epi16 (r, r);
+		g = _mm_packus_epi16 (g, g);
+		b = _mm_packus_epi16 (b, b);
+		
+		__m128i bg = _mm_unpacklo_epi8 (b, g);
+		__m128i ra = _mm_unpacklo_epi8 (r, alpha);
+		
+		_mm_storeu_si128 ((__m128i *) (dest + x),     _mm_unpacklo_epi16 (bg, ra));
+		_mm_storeu_si128 ((__m128i *) (dest + x + 4), _mm_unpackhi_epi16 (bg, ra));
+	}
+	
+	
+	return x;
+}
+
+
+
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_rgb_row (const uint32_t *src0,
+              const uint32_t *src1,
+              uint8_t *y0,
+              uint8_t *y1,
+              uint8_t *u,
+              uint8_t *v,
+              int width,
+              const RgbToYuv *m)
+{
+	const __m128i zero     = _mm_setzero_si128 ();
+	const __m128i two      = _mm_set1_epi16 (2);
+	const __m128i round    = _mm_set1_epi32 (ROUND);
+	const __m128i y_off    = _mm_set1_epi32 (16);
+	const __m128i c_off    = _mm_set1_epi32 (128);
+	
+	const __m128i c_y = _mm_setr_epi16 (m->yb, m->yg, m->yr, 0, m->yb, m->yg, m->yr, 0);
+	const __m128i c_u = _mm_setr_epi16 (m->ub, m->ug, m->ur, 0, m->ub, m->ug, m->ur, 0);
+	const __m128i c_v = _mm_setr_epi16 (m->vb, m->vg, m->vr, 0, m->vb, m->vg, m->vr, 0);
+	
+	int x;
+	
+	
+	/* both rows are needed for the chroma blocks */
+	if (y1 == NULL)
+		return 0;
+	
+	
+	for (x = 0; x + 8 <= width; x += 8)
+	{
+		__m128i a0 = _mm_loadu_si128 ((const __m128i *) (src0 + x));
+		__m128i a1 = _mm_loadu_si128 ((const __m128i *) (src0 + x + 4));
+		__m128i b0 = _mm_loadu_si128 ((const __m128i *) (src1 + x));
+		__m128i b1 = _mm_loadu_si128 ((const __m128i *) (src1 + x + 4));
+		
+		
+		/* luma */
+		__m128i ya = _mm_packs_epi32 (
+				sse2_scale (sse2_weigh (_mm_unpacklo_epi8 (a0, zero), _mm_unpackhi_epi8 (a0, zero), c_y), round, y_off),
+				sse2_scale (sse2_weigh (_mm_unpacklo_epi8 (a1, zero), _mm_unpackhi_epi8 (a1, zero), c_y), round, y_off));
+		
+		__m128i yb = _mm_packs_epi32 (
+				sse2_scale (sse2_weigh (_mm_unpacklo_epi8 (b0, zero), _mm_unpackhi_epi8 (b0, zero), c_y), round, y_off),
+				sse2_scale (sse2_weigh (_mm_unpacklo_epi8 (b1, zero), _mm_unpackhi_epi8 (b1, zero), c_y), round, y_off));
+		
+		_mm_storel_epi64 ((__m128i *) (y0 + x), _mm_packus_epi16 (ya, ya));
+		_mm_storel_epi64 ((__m128i *) (y1 + x), _mm_packus_epi16 (yb, yb));
+		
+		
+		/* chroma */
+		__m128i avg0 = sse2_average (a0, b0, two);
+		__m128i avg1 = sse2_average (a1, b1, two);
+		
+		__m128i cu = _mm_packs_epi32 (sse2_scale (sse2_weigh (avg0, avg1, c_u), round, c_off), zero);
+		__m128i cv = _mm_packs_epi32 (sse2_scale (sse2_weigh (avg0, avg1, c_v), round, c_off), zero);
+		
+		int32_t pu = _mm_cvtsi128_si32 (_mm_packus_epi16 (cu, cu));
+		int32_t pv = _mm_cvtsi128_si32 (_mm_packus_epi16 (cv, cv));
+		
+		memcpy (u + x / 2, &pu, 4);
+		memcpy (v + x / 2, &pv, 4);
+	}
+	
+	
+	return x;
+}
+
+
+
+
+__attribute__ ((target ("avx2")))
+static int
+avx2_yuv_row (const uint8_t *y,
+              const uint8_t *u,
+              const uint8_t *v,
+              uint32_t *dest,
+              int width,
+              const YuvToRgb *m)
+{
+	const __m256i zero   = _mm256_setzero_si256 ();
+	const __m256i y_off  = _mm256_set1_epi16 (16);
+	const __m256i c_off  = _mm256_set1_epi16 (128);
+	const __m256i round  = _mm256_set1_epi32 (ROUND);
+	const __m256i alpha  = _mm256_set1_epi8 ((char) 0xff);
+	
+	const __m256i c_r  = _mm256_set1_epi32 (PAIR (m->y, m->rv));
+	const __m256i c_g  = _mm256_set1_epi32 (PAIR (m->y, m->gu));
+	const __m256i c_gv = _mm256_set1_epi32 (PAIR (m->gv, 0));
+	const __m256i c_b  = _mm256_set1_epi32 (PAIR (m->y, m->bu));
+	
+	int x;
+	
+	
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		/* expand to signed 16 bit, repeating each chroma sample */
+		__m128i su = _mm_loadl_epi64 ((const __m128i *) (u + x / 2));
+		__m128i sv = _mm_loadl_epi64 ((const __m128i *) (v + x / 2));
+		
+		__m256i ly = _mm256_sub_epi16 (_mm256_cvtepu8_epi16 (
+				_mm_loadu_si128 ((const __m128i *) (y + x))), y_off);
+		__m256i lu = _mm256_sub_epi16 (_mm256_cvtepu8_epi16 (_mm_unpacklo_epi8 (su, su)), c_off);
+		__m256i lv = _mm256_sub_epi16 (_mm256_cvtepu8_epi16 (_mm_unpacklo_epi8 (sv, sv)), c_off);
+		
+		__m256i yv_lo = _mm256_unpacklo_epi16 (ly, lv);
+		__m256i yv_hi = _mm256_unpackhi_epi16 (ly, lv);
+		__m256i yu_lo = _mm256_unpacklo_epi16 (ly, lu);
+		__m256i yu_hi = _mm256_unpackhi_epi16 (ly, lu);
+		__m256i v_lo  = _mm256_unpacklo_epi16 (lv, zero);
+		__m256i v_hi  = _mm256_unpackhi_epi16 (lv, zero);
+		
+		
+		/* the in-lane packs restore the pixel order */
+		__m256i r = _mm256_packs_epi32 (
+				_mm256_srai_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (yv_lo, c_r), round), SHIFT),
+				_mm256_srai_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (yv_hi, c_r), round), SHIFT));
+		
+		__m256i g = _mm256_packs_epi32 (
+				_mm256_srai_epi32 (_mm256_add_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (yu_lo, c_g),
+						_mm256_madd_epi16 (v_lo, c_gv)), round), SHIFT),
+				_mm256_srai_epi32 (_mm256_add_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (yu_hi, c_g),
+						_mm256_madd_epi16 (v_hi, c_gv)), round), SHIFT));
+		
+		__m256i b = _mm256_packs_epi32 (
+				_mm256_srai_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (yu_lo, c_b), round), SHIFT),
+				_mm256_srai_epi32 (_mm256_add_epi32 (_mm256_madd_epi16 (yu_hi, c_b), round), SHIFT));
+		
+		
+		/* clamp and interleave into BGRA */
+		r = _mm256_packus_epi16 (r, r);
+		g = _mm256_packus_epi16 (g, g);
+		b = _mm256_packus_epi16 (b, b);
+		
+		__m256i bg = _mm256_unpacklo_epi8 (b, g);
+		__m256i ra = _mm256_unpacklo_epi8 (r, alpha);
+		__m256i lo = _mm256_unpacklo_epi16 (bg, ra);
+		__m256i hi = _mm256_unpackhi_epi16 (bg, ra);
+		
+		_mm256_storeu_si256 ((__m256i *) (dest + x),     _mm256_permute2x128_si256 (lo, hi, 0x20));
+		_mm256_storeu_si256 ((__m256i *) (dest + x + 8), _mm256_permute2x128_si256 (lo, hi, 0x31));
+	}
+	
+	
+	return x;
+}
+
+
+
+
+__attribute__ ((target ("avx2")))
+static inline __m256i
+avx2_scale (__m256i sum, __m256i round, __m256i offset)
+{
+	return _mm256_add_epi32 (_mm256_srai_epi32 (_mm256_add_epi32 (sum, round), SHIFT), offset);
+}
+
+
+
+/* weighted sum of eight BGRA pixels, in order */
+__attribute__ ((target ("avx2")))
+static inline __m256i
+avx2_weigh (__m256i lo, __m256i hi, __m256i coef)
+{
+	__m256i a = _mm256_madd_epi16 (lo, coef);
+	__m256i b = _mm256_madd_epi16 (hi, coef);
+	
+	a = _mm256_add_epi32 (a, _mm256_srli_epi64 (a, 32));
+	b = _mm256_add_epi32 (b, _mm256_srli_epi64 (b, 32));
+	
+	return _mm256_unpacklo_epi64 (_mm256_shuffle_epi32 (a, _MM_SHUFFLE (2, 0, 2, 0)),
+	                              _mm256_shuffle_epi32 (b, _MM_SHUFFLE (2, 0, 2, 0)));
+}
+
+
+
+/* averages the 2x2 blocks of eight pixels from two rows */
+__attribute__ ((target ("avx2")))
+static inline __m256i
+avx2_average (__m256i row0, __m256i row1, __m256i two)
+{
+	const __m256i zero = _mm256_setzero_si256 ();
+	
+	__m256i lo = _mm256_add_epi16 (_mm256_unpacklo_epi8 (row0, zero),
+	                               _mm256_unpacklo_epi8 (row1, zero));
+	__m256i hi = _mm256_add_epi16 (_mm256_unpackhi_epi8 (row0, zero),
+	                               _mm256_unpackhi_epi8 (row1, zero));
+	
+	lo = _mm256_add_epi16 (lo, _mm256_srli_si256 (lo, 8));
+	hi = _mm256_add_epi16 (hi, _mm256_srli_si256 (hi, 8));
+	
+	return _mm256_srli_epi16 (_mm256_add_epi16 (_mm256_unpacklo_epi64 (lo, hi), two), 2);
+}
+
+
+
+/* narrows eight 32 bit values to unsigned bytes */
+__attribute__ ((target ("avx2")))
+static inline __m128i
+avx2_narrow (__m256i value)
+{
+	__m128i words = _mm_packs_epi32 (_mm256_castsi256_si128 (value),
+	                                 _mm256_extracti128_si256 (value, 1));
+	
+	return _mm_packus_epi16 (words, words);
+}
+
+
+
+
+__attribute__ ((target ("avx2")))
+static int
+avx2_rgb_row (const uint32_t *src0,
+              const uint32_t *src1,
+              uint8_t *y0,
+              uint8_t *y1,
+              uint8_t *u,
+              uint8_t *v,
+              int width,
+              const RgbToYuv *m)
+{
+	const __m256i zero  = _mm256_setzero_si256 ();
+	const __m256i two   = _mm256_set1_epi16 (2);
+	const __m256i round = _mm256_set1_epi32 (ROUND);
+	const __m256i y_off = _mm256_set1_epi32 (16);
+	const __m256i c_off = _mm256_set1_epi32 (128);
+	
+	/* restores the block order after the in-lane averaging */
+	const __m256i order = _mm256_setr_epi32 (0, 1, 4, 5, 2, 3, 6, 7);
+	
+	const __m256i c_y = _mm256_setr_epi16 (m->yb, m->yg, m->yr, 0, m->yb, m->yg, m->yr, 0,
+	                                       m->yb, m->yg, m->yr, 0, m->yb, m->yg, m->yr, 0);
+	const __m256i c_u = _mm256_setr_epi16 (m->ub, m->ug, m->ur, 0, m->ub, m->ug, m->ur, 0,
+	                                       m->ub, m->ug, m->ur, 0, m->ub, m->ug, m->ur, 0);
+	const __m256i c_v = _mm256_setr_epi16 (m->vb, m->vg, m->vr, 0, m->vb, m->vg, m->vr, 0,
+	                                       m->vb, m->vg, m->vr, 0, m->vb, m->vg, m->vr, 0);
+	
+	int x;
+	
+	
+	/* both rows are needed for the chroma blocks */
+	if (y1 == NULL)
+		return 0;
+	
+	
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		__m256i a0 = _mm256_loadu_si256 ((const __m256i *) (src0 + x));
+		__m256i a1 = _mm256_loadu_si256 ((const __m256i *) (src0 + x + 8));
+		__m256i b0 = _mm256_loadu_si256 ((const __m256i *) (src1 + x));
+		__m256i b1 = _mm256_loadu_si256 ((const __m256i *) (src1 + x + 8));
+		
+		
+		/* luma */
+		__m128i ya0 = avx2_narrow (avx2_scale (avx2_weigh (_mm256_unpacklo_epi8 (a0, zero),
+				_mm256_unpackhi_epi8 (a0, zero), c_y), round, y_off));
+		__m128i ya1 = avx2_narrow (avx2_scale (avx2_weigh (_mm256_unpacklo_epi8 (a1, zero),
+				_mm256_unpackhi_epi8 (a1, zero), c_y), round, y_off));
+		__m128i yb0 = avx2_narrow (avx2_scale (avx2_weigh (_mm256_unpacklo_epi8 (b0, zero),
+				_mm256_unpackhi_epi8 (b0, zero), c_y), round, y_off));
+		__m128i yb1 = avx2_narrow (avx2_scale (avx2_weigh (_mm256_unpacklo_epi8 (b1, zero),
+				_mm256_unpackhi_epi8 (b1, zero), c_y), round, y_off));
+		
+		_mm_storeu_si128 ((__m128i *) (y0 + x), _mm_unpacklo_epi64 (ya0, ya1));
+		_mm_storeu_si128 ((__m128i *) (y1 + x), _mm_unpacklo_epi64 (yb0, yb1));
+		
+		
+		/* chroma */
+		__m256i avg0 = avx2_average (a0, b0, two);
+		__m256i avg1 = avx2_average (a1, b1, two);
+		
+		__m256i cu = _mm256_permutevar8x32_epi32 (avx2_weigh (avg0, avg1, c_u), order);
+		__m256i cv = _mm256_permutevar8x32_epi32 (avx2_weigh (avg0, avg1, c_v), order);
+		
+		_mm_storel_epi64 ((__m128i *) (u + x / 2), avx2_narrow (avx2_scale (cu, round, c_off)));
+		_mm_storel_epi64 ((__m128i *) (v + x / 2), avx2_narrow (avx2_scale (cv, round, c_off)));
+	}
+	
+	
+	return x;
+}
+
+
+
+
+
+/* packing only shuffles bytes so SSE2 is enough to be memory bound */
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_yuy2_row (const uint8_t *y,
+               const uint8_t *u,
+               const uint8_t *v,
+               uint8_t *dest,
+               int width)
+{
+	int x;
+	
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		__m128i ly = _mm_loadu_si128 ((const __m128i *) (y + x));
+		__m128i uv = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (u + x / 2)),
+		                                _mm_loadl_epi64 ((const __m128i *) (v + x / 2)));
+		
+		_mm_storeu_si128 ((__m128i *) (dest + x * 2),      _mm_unpacklo_epi8 (ly, uv));
+		_mm_storeu_si128 ((__m128i *) (dest + x * 2 + 16), _mm_unpackhi_epi8 (ly, uv));
+	}
+	
+	return x;
+}
+
+
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_uyvy_row (const uint8_t *y,
+               const uint8_t *u,
+               const uint8_t *v,
+               uint8_t *dest,
+               int width)
+{
+	int x;
+	
+	for (x = 0; x + 16 <= width; x += 16)
+	{
+		__m128i ly = _mm_loadu_si128 ((const __m128i *) (y + x));
+		__m128i uv = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *) (u + x / 2)),
+		                                _mm_loadl_epi64 ((const __m128i *) (v + x / 2)));
+		
+		_mm_storeu_si128 ((__m128i *) (dest + x * 2),      _mm_unpacklo_epi8 (uv, ly));
+		_mm_storeu_si128 ((__m128i *) (dest + x * 2 + 16), _mm_unpackhi_epi8 (uv, ly));
+	}
+	
+	return x;
+}
+
+
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_interleave_row (const uint8_t *u,
+                     const uint8_t *v,
+                     uint8_t *dest,
+                     int length)
+{
+	int i;
+	
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		__m128i cu = _mm_loadu_si128 ((const __m128i *) (u + i));
+		__m128i cv = _mm_loadu_si128 ((const __m128i *) (v + i));
+		
+		_mm_storeu_si128 ((__m128i *) (dest + i * 2),      _mm_unpacklo_epi8 (cu, cv));
+		_mm_storeu_si128 ((__m128i *) (dest + i * 2 + 16), _mm_unpackhi_epi8 (cu, cv));
+	}
+	
+	return i;
+}
+
+
+#endif /* HAVE_X86_KERNELS */
+
+
+
+
+/*
+ * init_kernels:
+ *
+ * Picks the fastest row converters supported by the running CPU.
+ */
+static void
+init_kernels (void)
+{
+	kernels.name = "c";
+	kernels.yuv_row = none_yuv_row;
+	kernels.rgb_row = none_rgb_row;
+	kernels.yuy2_row = none_pack_row;
+	kernels.uyvy_row = none_pack_row;
+	kernels.interleave_row = none_interleave_row;
+	
+	
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	
+	if (__builtin_cpu_supports ("sse2"))
+	{
+		kernels.yuy2_row = sse2_yuy2_row;
+		kernels.uyvy_row = sse2_uyvy_row;
+		kernels.interleave_row = sse2_interleave_row;
+	}
+	
+	if (__builtin_cpu_supports ("avx2"))
+	{
+		kernels.name = "avx2";
+		kernels.yuv_row = avx2_yuv_row;
+		kernels.rgb_row = avx2_rgb_row;
+	}
+	
+	else if (__builtin_cpu_supports ("sse2"))
+	{
+		kernels.name = "sse2";
+		kernels.yuv_row = sse2_yuv_row;
+		kernels.rgb_row = sse2_rgb_row;
+	}
+#endif
+}
+
+
+
+/*
+ * set_kernels:
+ * @name: the kernel to use.
+ *
+ * Switches every row converter to the @name kernel.
+ *
+ * Returns: %true if the CPU supports @name, %false otherwise.
+ */
+static bool
+set_kernels (const char *name)
+{
+	if (strcmp (name, "c") == 0)
+	{
+		kernels.name = "c";
+		kernels.yuv_row = none_yuv_row;
+		kernels.rgb_row = none_rgb_row;
+		kernels.yuy2_row = none_pack_row;
+		kernels.uyvy_row = none_pack_row;
+		kernels.interleave_row = none_interleave_row;
+		
+		return true;
+	}
+	
+	
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	
+	if (strcmp (name, "sse2") == 0 && __builtin_cpu_supports ("sse2"))
+	{
+		kernels.name = "sse2";
+		kernels.yuv_row = sse2_yuv_row;
+		kernels.rgb_row = sse2_rgb_row;
+	}
+	
+	else if (strcmp (name, "avx2") == 0 && __builtin_cpu_supports ("avx2"))
+	{
+		kernels.name = "avx2";
+		kernels.yuv_row = avx2_yuv_row;
+		kernels.rgb_row = avx2_rgb_row;
+	}
+	
+	else
+		return false;
+	
+	
+	/* the packing kernels only come in sse2 */
+	kernels.yuy2_row = sse2_yuy2_row;
+	kernels.uyvy_row = sse2_uyvy_row;
+	kernels.interleave_row = sse2_interleave_row;
+	
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+
+/**
+ * v_convert_yuv420_to_rgb32:
+ * @src: the source Y, U and V planes.
+ * @src_linesize: the size of each source plane line.
+ * @dest: the destination RGB32 plane.
+ * @dest_linesize: the size of each destination plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @matrix: the #VColorMatrix to use.
+ *
+ * Converts a YUV420 picture to RGB32 without scaling using the fastest
+ * kernel supported by the CPU. Every kernel produces identical output.
+ */
+void
+v_convert_yuv420_to_rgb32 (uint8_t *src[4],
+                           int src_linesize[4],
+                           uint8_t *dest[4],
+                           int dest_linesize[4],
+                           int width,
+                           int height,
+                           VColorMatrix matrix)
+{
+	const YuvToRgb *m = &yuv_to_rgb[matrix];
+	int row;
+	
+	pthread_once (&init_once, init_kernels);
+	
+	
+	for (row = 0; row < height; row++)
+	{
+		const uint8_t *y = src[0] + row * src_linesize[0];
+		const uint8_t *u = src[1] + (row / 2) * src_linesize[1];
+		const uint8_t *v = src[2] + (row / 2) * src_linesize[2];
+		
+		uint32_t *out = (uint32_t *) (dest[0] + row * dest_linesize[0]);
+		
+		
+		int done = kernels.yuv_row (y, u, v, out, width, m);
+		scalar_yuv_row (y, u, v, out, done, width, m);
+	}
+}
+
+
+
+
+/**
+ * v_convert_rgb32_to_yuv420:
+ * @src: the source RGB32 plane.
+ * @src_linesize: the size of each source plane line.
+ * @dest: the destination Y, U and V planes.
+ * @dest_linesize: the size of each destination plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @matrix: the #VColorMatrix to use.
+ *
+ * Converts an RGB32 picture to YUV420 without scaling using the fastest
+ * kernel supported by the CPU. Every kernel produces identical output.
+ */
+void
+v_convert_rgb32_to_yuv420 (uint8_t *src[4],
+                           int src_linesize[4],
+                           uint8_t *dest[4],
+                           int dest_linesize[4],
+                           int width,
+                           int height,
+                           VColorMatrix matrix)
+{
+	const RgbToYuv *m = &rgb_to_yuv[matrix];
+	int row;
+	
+	pthread_once (&init_once, init_kernels);
+	
+	
+	for (row = 0; row < height; row += 2)
+	{
+		const uint32_t *src0 = (const uint32_t *) (src[0] + row * src_linesize[0]);
+		const uint32_t *src1 = src0;
+		
+		uint8_t *y0 = dest[0] + row * dest_linesize[0];
+		uint8_t *y1 = NULL;
+		uint8_t *u  = dest[1] + (row / 2) * dest_linesize[1];
+		uint8_t *v  = dest[2] + (row / 2) * dest_linesize[2];
+		
+		
+		/* an odd last row is paired with itself */
+		if (row + 1 < height)
+		{
+			src1 = (const uint32_t *) (src[0] + (row + 1) * src_linesize[0]);
+			y1 = y0 + dest_linesize[0];
+		}
+		
+		
+		int done = kernels.rgb_row (src0, src1, y0, y1, u, v, width, m);
+		scalar_rgb_row (src0, src1, y0, y1, u, v, done, width, m);
+	}
+}
+
+
+
+
+/**
+ * v_convert_yuv420_to_nv12:
+ * @src: the source Y, U and V planes.
+ * @src_linesize: the size of each source plane line.
+ * @dest: the destination Y and interleaved UV planes.
+ * @dest_linesize: the size of each destination plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ *
+ * Converts a YUV420 picture to semi-planar NV12.
+ */
+void
+v_convert_yuv420_to_nv12 (uint8_t *src[4],
+                          int src_linesize[4],
+                          uint8_t *dest[4],
+                          int dest_linesize[4],
+                          int width,
+                          int height)
+{
+	int chroma_w = (width + 1) / 2;
+	int row;
+	
+	pthread_once (&init_once, init_kernels);
+	
+	
+	for (row = 0; row < height; row++)
+		memcpy (dest[0] + row * dest_linesize[0], src[0] + row * src_linesize[0], width);
+	
+	
+	for (row = 0; row < (height + 1) / 2; row++)
+	{
+		const uint8_t *u = src[1] + row * src_linesize[1];
+		const uint8_t *v = src[2] + row * src_linesize[2];
+		uint8_t *out = dest[1] + row * dest_linesize[1];
+		
+		int done = kernels.interleave_row (u, v, out, chroma_w);
+		scalar_interleave_row (u, v, out, done, chroma_w);
+	}
+}
+
+
+
+
+/*
+ * pack_picture:
+ *
+ * Packs a YUV420 picture into YUY2 or UYVY. Each chroma row is used for
+ * the two rows it covers.
+ */
+static void
+pack_picture (uint8_t *src[4],
+              int src_linesize[4],
+              uint8_t *dest[4],
+              int dest_linesize[4],
+              int width,
+              int height,
+              bool uyvy)
+{
+	PackRowFunc *kernel;
+	int row;
+	
+	pthread_once (&init_once, init_kernels);
+	
+	kernel = uyvy ? kernels.uyvy_row : kernels.yuy2_row;
+	
+	
+	for (row = 0; row < height; row++)
+	{
+		const uint8_t *y = src[0] + row * src_linesize[0];
+		const uint8_t *u = src[1] + (row / 2) * src_linesize[1];
+		const uint8_t *v = src[2] + (row / 2) * src_linesize[2];
+		uint8_t *out = dest[0] + row * dest_linesize[0];
+		
+		int done = kernel (y, u, v, out, width);
+		scalar_pack_row (y, u, v, out, done, width, uyvy);
+	}
+}
+
+
+
+
+/**
+ * v_convert_yuv420_to_yuy2:
+ * @src: the source Y, U and V planes.
+ * @src_linesize: the size of each source plane line.
+ * @dest: the destination packed plane.
+ * @dest_linesize: the size of each destination plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ *
+ * Converts a YUV420 picture to packed YUY2.
+ */
+void
+v_convert_yuv420_to_yuy2 (uint8_t *src[4],
+                          int src_linesize[4],
+                          uint8_t *dest[4],
+                          int dest_linesize[4],
+                          int width,
+                          int height)
+{
+	pack_picture (src, src_linesize, dest, dest_linesize, width, height, false);
+}
+
+
+
+
+/**
+ * v_convert_yuv420_to_uyvy:
+ * @src: the source Y, U and V planes.
+ * @src_linesize: the size of each source plane line.
+ * @dest: the destination packed plane.
+ * @dest_linesize: the size of each destination plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ *
+ * Converts a YUV420 picture to packed UYVY.
+ */
+void
+v_convert_yuv420_to_uyvy (uint8_t *src[4],
+                          int src_linesize[4],
+                          uint8_t *dest[4],
+                          int dest_linesize[4],
+                          int width,
+                          int height)
+{
+	pack_picture (src, src_linesize, dest, dest_linesize, width, height, true);
+}
+
+
+
+
+/**
+ * v_convert_supported:
+ * @src: the source pixel format.
+ * @dest: the destination pixel format.
+ *
+ * Checks whether v_convert_picture() can convert from @src to @dest.
+ *
+ * Returns: %true if there is a built-in converter, %false otherwise.
+ */
+bool
+v_convert_supported (VPixelFormat src, VPixelFormat dest)
+{
+	if (src == V_PIXEL_FORMAT_YUV420)
+		return dest == V_PIXEL_FORMAT_RGB32 || dest == V_PIXEL_FORMAT_NV12 ||
+		       dest == V_PIXEL_FORMAT_YUY2  || dest == V_PIXEL_FORMAT_UYVY;
+	
+	return src == V_PIXEL_FORMAT_RGB32 && dest == V_PIXEL_FORMAT_YUV420;
+}
+
+
+
+
+/**
+ * v_convert_picture:
+ * @src_format: the source pixel format.
+ * @src: the source planes.
+ * @src_linesize: the size of each source plane line.
+ * @dest_format: the destination pixel format.
+ * @dest: the destination planes.
+ * @dest_linesize: the size of each destination plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @matrix: the #VColorMatrix for conversions between YUV and RGB.
+ *
+ * Converts a picture without scaling using the matching built-in
+ * converter.
+ *
+ * Returns: %true if converted, %false if the formats are unsupported.
+ */
+bool
+v_convert_picture (VPixelFormat src_format,
+                   uint8_t *src[4],
+                   int src_linesize[4],
+                   VPixelFormat dest_format,
+                   uint8_t *dest[4],
+                   int dest_linesize[4],
+                   int width,
+                   int height,
+                   VColorMatrix matrix)
+{
+	if (!v_convert_supported (src_format, dest_format))
+		return false;
+	
+	
+	switch (dest_format)
+	{
+		case V_PIXEL_FORMAT_RGB32:
+			v_convert_yuv420_to_rgb32 (src, src_linesize, dest, dest_linesize,
+					width, height, matrix);
+			break;
+			
+		case V_PIXEL_FORMAT_YUV420:
+			v_convert_rgb32_to_yuv420 (src, src_linesize, dest, dest_linesize,
+					width, height, matrix);
+			break;
+			
+		case V_PIXEL_FORMAT_NV12:
+			v_convert_yuv420_to_nv12 (src, src_linesize, dest, dest_linesize,
+					width, height);
+			break;
+			
+		case V_PIXEL_FORMAT_YUY2:
+			v_convert_yuv420_to_yuy2 (src, src_linesize, dest, dest_linesize,
+					width, height);
+			break;
+			
+		case V_PIXEL_FORMAT_UYVY:
+			v_convert_yuv420_to_uyvy (src, src_linesize, dest, dest_linesize,
+					width, height);
+			break;
+			
+		default:
+			break;
+	}
+	
+	
+	return true;
+}
+
+
+
+
+/**
+ * v_convert_pixel_rgb32_to_yuv:
+ * @pixel: an RGB32 pixel.
+ * @y: return location for the luma.
+ * @u: return location for the blue difference chroma.
+ * @v: return location for the red difference chroma.
+ * @matrix: the #VColorMatrix to use.
+ *
+ * Converts a single pixel without chroma subsampling, which is useful for
+ * palettes. The result matches the picture converters.
+ */
+void
+v_convert_pixel_rgb32_to_yuv (uint32_t pixel,
+                              uint8_t *y,
+                              uint8_t *u,
+                              uint8_t *v,
+                              VColorMatrix matrix)
+{
+	const RgbToYuv *m = &rgb_to_yuv[matrix];
+	
+	int r = (pixel >> 16) & 0xff;
+	int g = (pixel >> 8) & 0xff;
+	int b = pixel & 0xff;
+	
+	*y = clip (((m->yr * r + m->yg * g + m->yb * b + ROUND) >> SHIFT) + 16);
+	*u = clip (((m->ur * r + m->ug * g + m->ub * b + ROUND) >> SHIFT) + 128);
+	*v = clip (((m->vr * r + m->vg * g + m->vb * b + ROUND) >> SHIFT) + 128);
+}
+
+
+
+
+/**
+ * v_convert_kernel_string:
+ *
+ * Gets the name of the conversion kernel picked for the running CPU.
+ *
+ * Returns: the kernel name, such as "sse2".
+ */
+const char *
+v_convert_kernel_string (void)
+{
+	pthread_once (&init_once, init_kernels);
+	return kernels.name;
+}
+
+
+
+/**
+ * v_convert_set_kernel:
+ * @name: the kernel to use, "c", "sse2" or "avx2".
+ *
+ * Overrides the conversion kernel picked for the running CPU, so each one
+ * can be tested and timed. No conversion may run while the kernel changes.
+ *
+ * Returns: %true if the CPU supports @name, %false otherwise.
+ */
+bool
+v_convert_set_kernel (const char *name)
+{
+	pthread_once (&init_once, init_kernels);
+	return set_kernels (name);
+}
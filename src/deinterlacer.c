@@ -0,0 +1,565 @@
+/***************************************************************************
+ *            deinterlacer.c
+ *
+ *  Oct 19, 2026 6:53:00 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "deinterlacer.h"
+#include "mem.h"
+#include <string.h>  /* memcpy */
+#include <pthread.h>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <emmintrin.h>
+#endif
+
+
+
+/* the difference from the previous picture treated as motion */
+#define MOTION_THRESHOLD 10
+
+#define MAX_PLANES 3
+
+
+
+/*
+ * VDeinterlacerPriv:
+ * @format: the pixel format of the last picture.
+ * @width: the width of the last picture.
+ * @height: the height of the last picture.
+ * @parity: the row parity rebuilt in the last picture.
+ * @primed: whether @history holds the last picture.
+ * @history: the original rebuilt rows of the last picture, for each plane.
+ * @lines: scratch lines for the blend filter.
+ *
+ * Private structure for #VDeinterlacer.
+ */
+struct _VDeinterlacerPriv
+{
+	VPixelFormat format;
+	int width;
+	int height;
+	int parity;
+	
+	bool primed;
+	uint8_t *history[MAX_PLANES];
+	uint8_t *lines[2];
+};
+
+
+
+/*
+ * Kernels:
+ *
+ * The row filters picked for the running CPU. Each returns the amount of
+ * bytes done and the scalar filters finish the rest.
+ */
+typedef struct _Kernels
+{
+	int (* interpolate) (uint8_t *dest, const uint8_t *above, const uint8_t *below, int length);
+	
+	int (* blend) (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+	               const uint8_t *below, int length);
+	
+	int (* adaptive) (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+	                  const uint8_t *below, const uint8_t *prev, int length);
+} Kernels;
+
+
+
+static Kernels kernels;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+
+
+
+/* scalar reference filters, matched exactly by the vector kernels */
+
+static void
+scalar_interpolate (uint8_t *dest, const uint8_t *above, const uint8_t *below,
+                    int start, int length)
+{
+	int i;
+	
+	for (i = start; i < length; i++)
+		dest[i] = (above[i] + below[i] + 1) >> 1;
+}
+
+
+
+static void
+scalar_blend (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+              const uint8_t *below, int start, int length)
+{
+	int i;
+	
+	for (i = start; i < length; i++)
+		dest[i] = (above[i] + 2 * cur[i] + below[i] + 2) >> 2;
+}
+
+
+
+static void
+scalar_adaptive (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+                 const uint8_t *below, const uint8_t *prev, int start, int length)
+{
+	int i;
+	
+	for (i = start; i < length; i++)
+	{
+		int motion = cur[i] > prev[i] ? cur[i] - prev[i] : prev[i] - cur[i];
+		
+		dest[i] = motion > MOTION_THRESHOLD ? (above[i] + below[i] + 1) >> 1 : cur[i];
+	}
+}
+
+
+
+
+static int
+none_interpolate (uint8_t *dest, const uint8_t *above, const uint8_t *below, int length)
+{
+	return 0;
+}
+
+
+
+static int
+none_blend (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+            const uint8_t *below, int length)
+{
+	return 0;
+}
+
+
+
+static int
+none_adaptive (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+               const uint8_t *below, const uint8_t *prev, int length)
+{
+	return 0;
+}
+
+
+
+
+#ifdef HAVE_X86_KERNELS
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_interpolate (uint8_t *dest, const uint8_t *above, const uint8_t *below, int length)
+{
+	int i;
+	
+	for (i = 0; i + 16 <= length; i += 16)
+		_mm_storeu_si128 ((__m128i *) (dest + i), _mm_avg_epu8 (
+				_mm_loadu_si128 ((const __m128i *) (above + i)),
+				_mm_loadu_si128 ((const __m128i *) (below + i))));
+	
+	return i;
+}
+
+
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_blend (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+            const uint8_t *below, int length)
+{
+	const __m128i zero = _mm_setzero_si128 ();
+	const __m128i two  = _mm_set1_epi16 (2);
+	
+	int i;
+	
+	
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		__m128i a = _mm_loadu_si128 ((const __m128i *) (above + i));
+		__m128i c = _mm_loadu_si128 ((const __m128i *) (cur + i));
+		__m128i b = _mm_loadu_si128 ((const __m128i *) (below + i));
+		
+		__m128i c_lo = _mm_unpacklo_epi8 (c, zero);
+		__m128i c_hi = _mm_unpackhi_epi8 (c, zero);
+		
+		__m128i lo = _mm_add_epi16 (_mm_add_epi16 (_mm_unpacklo_epi8 (a, zero), _mm_unpacklo_epi8 (b, zero)),
+		                            _mm_add_epi16 (_mm_add_epi16 (c_lo, c_lo), two));
+		__m128i hi = _mm_add_epi16 (_mm_add_epi16 (_mm_unpackhi_epi8 (a, zero), _mm_unpackhi_epi8 (b, zero)),
+		                            _mm_add_epi16 (_mm_add_epi16 (c_hi, c_hi), two));
+		
+		_mm_storeu_si128 ((__m128i *) (dest + i),
+				_mm_packus_epi16 (_mm_srli_epi16 (lo, 2), _mm_srli_epi16 (hi, 2)));
+	}
+	
+	
+	return i;
+}
+
+
+
+__attribute__ ((target ("sse2")))
+static int
+sse2_adaptive (uint8_t *dest, const uint8_t *above, const uint8_t *cur,
+               const uint8_t *below, const uint8_t *prev, int length)
+{
+	const __m128i zero      = _mm_setzero_si128 ();
+	const __m128i threshold = _mm_set1_epi8 (MOTION_THRESHOLD);
+	
+	int i;
+	
+	
+	for (i = 0; i + 16 <= length; i += 16)
+	{
+		__m128i c = _mm_loadu_si128 ((const __m128i *) (cur + i));
+		__m128i p = _mm_loadu_si128 ((const __m128i *) (prev + i));
+		
+		
+		/* pixels whose difference exceeds the threshold are moving */
+		__m128i motion = _mm_or_si128 (_mm_subs_epu8 (c, p), _mm_subs_epu8 (p, c));
+		__m128i still  = _mm_cmpeq_epi8 (_mm_subs_epu8 (motion, threshold), zero);
+		
+		__m128i interp = _mm_avg_epu8 (
+				_mm_loadu_si128 ((const __m128i *) (above + i)),
+				_mm_loadu_si128 ((const __m128i *) (below + i)));
+		
+		_mm_storeu_si128 ((__m128i *) (dest + i),
+				_mm_or_si128 (_mm_and_si128 (still, c), _mm_andnot_si128 (still, interp)));
+	}
+	
+	
+	return i;
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+
+
+
+static void
+init_kernels (void)
+{
+	kernels.interpolate = none_interpolate;
+	kernels.blend       = none_blend;
+	kernels.adaptive    = none_adaptive;
+	
+#ifdef HAVE_X86_KERNELS
+	__builtin_cpu_init ();
+	
+	if (__builtin_cpu_supports ("sse2"))
+	{
+		kernels.interpolate = sse2_interpolate;
+		kernels.blend       = sse2_blend;
+		kernels.adaptive    = sse2_adaptive;
+	}
+#endif
+}
+
+
+
+
+/**
+ * v_deinterlacer_new:
+ * @mode: the #VDeinterlaceMode to use.
+ *
+ * Creates a new #VDeinterlacer.
+ *
+ * Returns: a #VDeinterlacer structure.
+ */
+VDeinterlacer *
+v_deinterlacer_new (VDeinterlaceMode mode)
+{
+	VDeinterlacer *ret = v_new (VDeinterlacer);
+	VDeinterlacerPriv *priv = v_new (VDeinterlacerPriv);
+	
+	
+	pthread_once (&init_once, init_kernels);
+	
+	
+	/* default values */
+	ret->mode = mode;
+	ret->priv = priv;
+	
+	priv->format = V_PIXEL_FORMAT_UNKNOWN;
+	priv->primed = false;
+	
+	
+	return ret;
+}
+
+
+
+
+/*
+ * free_buffers:
+ * @priv: a #VDeinterlacerPriv.
+ *
+ * Releases the history and scratch lines.
+ */
+static void
+free_buffers (VDeinterlacerPriv *priv)
+{
+	int i;
+	
+	for (i = 0; i < MAX_PLANES; i++)
+	{
+		v_free (priv->history[i]);
+		priv->history[i] = NULL;
+	}
+	
+	for (i = 0; i < 2; i++)
+	{
+		v_free (priv->lines[i]);
+		priv->lines[i] = NULL;
+	}
+	
+	priv->format = V_PIXEL_FORMAT_UNKNOWN;
+	priv->primed = false;
+}
+
+
+
+
+/**
+ * v_deinterlacer_free:
+ * @deinterlacer: a #VDeinterlacer to free.
+ *
+ * Free's @deinterlacer and its contents.
+ */
+void
+v_deinterlacer_free (VDeinterlacer *deinterlacer)
+{
+	free_buffers (deinterlacer->priv);
+	
+	v_free (deinterlacer->priv);
+	v_free (deinterlacer);
+}
+
+
+
+
+/**
+ * v_deinterlacer_set_mode:
+ * @deinterlacer: a #VDeinterlacer.
+ * @mode: the #VDeinterlaceMode to use.
+ *
+ * Changes how the following pictures are deinterlaced.
+ */
+void
+v_deinterlacer_set_mode (VDeinterlacer *deinterlacer, VDeinterlaceMode mode)
+{
+	deinterlacer->mode = mode;
+	deinterlacer->priv->primed = false;
+}
+
+
+
+
+/**
+ * v_deinterlacer_reset:
+ * @deinterlacer: a #VDeinterlacer.
+ *
+ * Forgets the last picture, so motion is not looked for against a picture
+ * from before a seek or from another title.
+ */
+void
+v_deinterlacer_reset (VDeinterlacer *deinterlacer)
+{
+	deinterlacer->priv->primed = false;
+}
+
+
+
+
+/*
+ * rebuild_field:
+ *
+ * Rebuilds the rows of one field from the rows around them, either
+ * everywhere or only where they differ from the last picture.
+ */
+static void
+rebuild_field (VDeinterlacer *self,
+               int plane,
+               uint8_t *data,
+               int linesize,
+               int bytes,
+               int lines,
+               int parity)
+{
+	VDeinterlacerPriv *priv = self->priv;
+	int row;
+	
+	
+	for (row = parity; row < lines; row += 2)
+	{
+		uint8_t *cur = data + row * linesize;
+		uint8_t *above = row > 0 ? cur - linesize : cur + linesize;
+		uint8_t *below = row + 1 < lines ? cur + linesize : cur - linesize;
+		
+		uint8_t *prev = priv->history[plane] + row * bytes;
+		int done;
+		
+		
+		if (self->mode == V_DEINTERLACE_MODE_ADAPTIVE && priv->primed)
+		{
+			uint8_t *out = priv->lines[0];
+			
+			done = kernels.adaptive (out, above, cur, below, prev, bytes);
+			scalar_adaptive (out, above, cur, below, prev, done, bytes);
+			
+			/* the original row is compared against the next picture */
+			memcpy (prev, cur, bytes);
+			memcpy (cur, out, bytes);
+		}
+		
+		else
+		{
+			if (self->mode == V_DEINTERLACE_MODE_ADAPTIVE)
+				memcpy (prev, cur, bytes);
+			
+			done = kernels.interpolate (cur, above, below, bytes);
+			scalar_interpolate (cur, above, below, done, bytes);
+		}
+	}
+}
+
+
+
+
+/*
+ * blend_fields:
+ *
+ * Filters every row with its neighbours, keeping a copy of the original
+ * previous row since it is overwritten first.
+ */
+static void
+blend_fields (VDeinterlacer *self,
+              uint8_t *data,
+              int linesize,
+              int bytes,
+              int lines)
+{
+	VDeinterlacerPriv *priv = self->priv;
+	
+	uint8_t *saved = priv->lines[0];
+	uint8_t *copy  = priv->lines[1];
+	int row;
+	
+	
+	for (row = 0; row < lines; row++)
+	{
+		uint8_t *cur = data + row * linesize;
+		uint8_t *above = row > 0 ? saved : cur + linesize;
+		uint8_t *below = row + 1 < lines ? cur + linesize : saved;
+		
+		
+		memcpy (copy, cur, bytes);
+		
+		int done = kernels.blend (cur, above, copy, below, bytes);
+		scalar_blend (cur, above, copy, below, done, bytes);
+		
+		
+		/* the original row becomes the next row's neighbour */
+		uint8_t *tmp = saved;
+		saved = copy;
+		copy = tmp;
+	}
+}
+
+
+
+
+/**
+ * v_deinterlacer_process:
+ * @deinterlacer: a #VDeinterlacer.
+ * @format: the #VPixelFormat of the picture.
+ * @data: the picture planes.
+ * @linesize: the size of each plane line.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @top_field_first: whether the top field is displayed first.
+ *
+ * Deinterlaces the picture in place. The first field is kept and the
+ * second one is rebuilt or blended depending on the mode. Only YUV420 and
+ * RGB32 pictures are supported, others are left untouched.
+ */
+void
+v_deinterlacer_process (VDeinterlacer *deinterlacer,
+                        VPixelFormat format,
+                        uint8_t *data[4],
+                        int linesize[4],
+                        int width,
+                        int height,
+                        bool top_field_first)
+{
+	VDeinterlacerPriv *priv = deinterlacer->priv;
+	
+	int parity = top_field_first ? 1 : 0;
+	int bytes, lines;
+	int i;
+	
+	
+	if (deinterlacer->mode == V_DEINTERLACE_MODE_NONE || height < 2 ||
+		!v_pixel_format_get_plane (format, 0, width, height, &bytes, &lines))
+		return;
+	
+	
+	/* the history only applies to pictures of the same shape */
+	if (priv->format != format || priv->width != width || priv->height != height)
+	{
+		free_buffers (priv);
+		
+		for (i = 0; v_pixel_format_get_plane (format, i, width, height, &bytes, &lines); i++)
+			priv->history[i] = v_malloc (bytes * lines);
+		
+		v_pixel_format_get_plane (format, 0, width, height, &bytes, &lines);
+		
+		priv->lines[0] = v_malloc (bytes);
+		priv->lines[1] = v_malloc (bytes);
+		
+		priv->format = format;
+		priv->width  = width;
+		priv->height = height;
+	}
+	
+	
+	/* a change of field order makes the history useless */
+	if (priv->parity != parity)
+		priv->primed = false;
+	
+	
+	for (i = 0; v_pixel_format_get_plane (format, i, width, height, &bytes, &lines); i++)
+	{
+		if (lines < 2)
+			continue;
+		
+		if (deinterlacer->mode == V_DEINTERLACE_MODE_BLEND)
+			blend_fields (deinterlacer, data[i], linesize[i], bytes, lines);
+		
+		else
+			rebuild_field (deinterlacer, i, data[i], linesize[i], bytes, lines, parity);
+	}
+	
+	
+	priv->parity = parity;
+	priv->primed = deinterlacer->mode == V_DEINTERLACE_MODE_ADAPTIVE;
+}
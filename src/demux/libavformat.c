@@ -27,6 +27,7 @@
 
 #include "demuxer.h"
 #include "mem.h"
+#include <pthread.h>
 #include <string.h>  /* memcpy */
 
 
@@ -65,6 +66,12 @@ struct _VDemuxerLibavformat
 
 
 
+/* libavformat only needs to be initialised once */
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+
+
+
 
 static void
 probe_codec_id (VDemuxer *demuxer, AVStream *stream, AVPacket *pkt)
@@ -261,7 +268,7 @@ v_demuxer_libavformat_new (VCodecID codec_id)
 	
 	
 	/* register demuxers */
-	av_register_all ();
+	pthread_once (&init_once, av_register_all);
 	
 	
 	/* find the input format */
@@ -25,6 +25,7 @@
  
 
 #include "demuxer.h"
+#include "frame.h"
 #include "mem.h"
 #include <stdbool.h>
 
@@ -73,10 +74,10 @@ struct _VDemuxerMpeg
 static int64_t
 read_timestamp (VDemuxer *demuxer, uint8_t c)
 {
-	uint8_t d = v_buffer_read_bits16 (demuxer->buffer);
-	uint8_t e = v_buffer_read_bits16 (demuxer->buffer);
+	uint16_t d = v_buffer_read_bits16 (demuxer->buffer);
+	uint16_t e = v_buffer_read_bits16 (demuxer->buffer);
 	
-	return (c & 0x0e) << 29 | (d >> 1) << 15 | (e >> 1);
+	return (int64_t) (c & 0x0e) << 29 | (d >> 1) << 15 | (e >> 1);
 }
 
 
@@ -336,8 +337,8 @@ v_demuxer_mpeg_read_packet (VDemuxer *demuxer, VError *error)
 	
 	uint8_t *data = NULL;
 	
-	int64_t pts = 0;
-	int64_t dts = 0;
+	int64_t pts = V_NO_PTS;
+	int64_t dts = V_NO_PTS;
 	
 	
 	
@@ -416,6 +417,25 @@ v_demuxer_mpeg_read_packet (VDemuxer *demuxer, VError *error)
 
 
 
+/*
+ * v_demuxer_mpeg_resync:
+ * @demuxer: a #VDemuxer.
+ *
+ * Skips to the start of the next pack. Other start codes also show up
+ * inside video data, so only a pack header is a safe packet boundary.
+ */
+static void
+v_demuxer_mpeg_resync (VDemuxer *demuxer)
+{
+	uint32_t code = 0xffffffff;
+	
+	while (code != PACK_HEADER_CODE && !demuxer->buffer->eos)
+		code = (code << 8) | v_buffer_read_bits8 (demuxer->buffer);
+}
+
+
+
+
 /**
  * v_demuxer_mpeg_new:
  *
@@ -433,6 +453,7 @@ v_demuxer_mpeg_new (VCodecID codec_id)
 	
 	/* set interface methods */
 	demuxer->read_packet = v_demuxer_mpeg_read_packet;
+	demuxer->resync = v_demuxer_mpeg_resync;
 	
 	
 	return demuxer;
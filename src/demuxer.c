@@ -170,3 +170,20 @@ v_demuxer_open (VDemuxer *demuxer, VError *error)
 }
 
 
+
+/**
+ * v_demuxer_resync:
+ * @demuxer: a #VDemuxer.
+ *
+ * Skips to the next packet boundary, such as after seeking into the
+ * middle of a packet. Demuxers without a resync method are expected to
+ * find it by themselves.
+ */
+void
+v_demuxer_resync (VDemuxer *demuxer)
+{
+	if (demuxer->resync != NULL)
+		demuxer->resync (demuxer);
+}
+
+
@@ -27,16 +27,36 @@
 #include "engine.h"
 #include "mem.h"
 #include "modules.h"
-#include "async-queue.h"
+#include "pipeline.h"
 #include "queue.h"
 #include "clock.h"
 #include "colorspace.h"
-#include <pthread.h>
-#include <unistd.h> /* usleep */
+#include "deinterlacer.h"
 #include <stdio.h>  /* printf */
+#include <string.h> /* memset */
+#include <time.h>   /* clock_gettime */
 
 
 
+/* the maximum amount of audio frames decoded per wake up */
+#define AUDIO_BATCH 16
+
+/* the seconds the audio device drains before writing the rest of a batch */
+#define AUDIO_RETRY 0.02
+
+/* the frames queued between the demuxer and each stream */
+#define QUEUE_DEPTH 10
+
+/* the pictures queued between the video stages */
+#define PICTURE_DEPTH 3
+
+/* the video conversions kept for titles opened after each other */
+#define COLORSPACE_CACHE 2
+
+/* the picture size from which conversions are split across the CPUs */
+#define BAND_PIXELS (1920 * 1080)
+
+
 
 /*
  * VEnginePriv:
@@ -45,17 +65,15 @@
  */
 struct _VEnginePriv
 {
-	/* threads */
-	pthread_t frames_proc;
-	pthread_t audio_proc;
-	pthread_t video_proc;
-	pthread_t subpic_proc;
-
-
-	/* queues */
-	VAsyncQueue *audio_events;
-	VAsyncQueue *video_events;
-	VAsyncQueue *subpic_events;
+	/* the demuxer feeding a node per stream */
+	VPipeline *pipeline;
+	
+	VNode *demux_node;
+	VNode *audio_node;
+	VNode *video_node;
+	VNode *deinterlace_node;
+	VNode *display_node;
+	VNode *subpic_node;
 
 
 	/* streams */
@@ -66,6 +84,60 @@ struct _VEnginePriv
 	
 	VClock *clock;
 	VColorspace *colorspace;
+	VColorspaceCache *colorspaces;
+	VDeinterlacer *deinterlacer;
+	
+	/* private copies of passed through pictures the deinterlacer writes to */
+	VFramePool *video_pool;
+	
+	/* the picture the display waits to present */
+	VFrame *pending;
+	
+	/* the format negotiated with the video output */
+	VPixelFormat video_format;
+	
+	/* the last audio timestamp and the samples written since */
+	int64_t audio_pts;
+	int64_t audio_samples;
+	
+	/* decoded audio waiting for room on the device */
+	VFrame *audio_frames[AUDIO_BATCH];
+	unsigned int audio_queued;
+	unsigned int audio_next;
+	int audio_offset;
+	
+	
+	/* frames before the position seeked to are dropped, until each
+	 * stream reaches it */
+	int64_t seek_pts;
+	bool audio_seeking;
+	bool video_seeking;
+	bool subpic_seeking;
+	bool need_keyframe;
+	
+	/* when the last seek started, to time the first picture */
+	double seek_time;
+	bool seek_timing;
+	
+	VEngineStats stats;
+	
+	bool playing;
+	
+	
+	/* whether frames wait for their presentation time */
+	bool paced;
+	
+	/* for the report at the end of stream */
+	double play_time;
+	unsigned long pictures;
+	
+	VEngineEosFunc *eos_handler;
+	void *eos_userdata;
+	
+	
+	/* decoding options */
+	VCodecMode video_mode;
+	int video_lowres;
 };
 
 
@@ -103,13 +175,36 @@ new_stream (VInput *input, VStream *stream, void *userdata)
 		if (priv->video == NULL)
 		{
 			priv->video = stream;
+			v_codec_set_mode (stream->codec, priv->video_mode);
+			
+			/* reduce the stream dimensions before setting up components,
+			 * staying at full size if the decoder can't */
+			if (priv->video_lowres > 0 &&
+			    !v_stream_set_lowres (stream, priv->video_lowres))
+				v_stream_update (stream);
+			
+			VPixelFormat source = stream->pixel_format;
+			
+			if (source == V_PIXEL_FORMAT_UNKNOWN)
+				source = V_PIXEL_FORMAT_YUV420;
+			
+			/* let the device pick what it displays best */
+			priv->video_format = v_output_negotiate_format (self->video_output, source);
 			v_output_open (self->video_output, stream);
 			
-			priv->colorspace = v_colorspace_new (V_PIXEL_FORMAT_YUV420,
-					V_PIXEL_FORMAT_YUV420,
+			/* titles of the same disc share their conversion */
+			priv->colorspace = v_colorspace_cache_get (priv->colorspaces,
+					source,
+					priv->video_format,
 					stream->width,
 					stream->height,
 					NULL);
+			
+			if (priv->colorspace != NULL && stream->width * stream->height >= BAND_PIXELS)
+				v_colorspace_set_threads (priv->colorspace, 0);
+			
+			priv->video_pool = v_frame_pool_new (priv->video_format,
+					stream->width, stream->height);
 		}
 		break;
 
@@ -139,203 +234,593 @@ new_stream (VInput *input, VStream *stream, void *userdata)
 
 
 /*
- * process_audio:
- * @user_data: a #VEngine.
+ * get_time:
  *
- * Reads frames from an input and adds it to the appropriate
- * queue for decoding and output.
+ * Returns: the monotonic time in seconds.
  */
-static void *
-process_audio (void *user_data)
+static double
+get_time (void)
 {
-	VEngine *self = (VEngine *) user_data;
-	VEnginePriv *priv = self->priv;
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+/*
+ * before_seek:
+ * @priv: a #VEnginePriv.
+ * @pts: a presentation timestamp.
+ *
+ * Returns: %true if @pts comes before the position last seeked to.
+ */
+static bool
+before_seek (VEnginePriv *priv, int64_t pts)
+{
+	return priv->seek_pts != V_NO_PTS && pts != V_NO_PTS &&
+			v_clock_pts_diff (pts, priv->seek_pts) < 0;
+}
 
 
-	while (true)
+
+/*
+ * reach_seek:
+ * @priv: a #VEnginePriv.
+ * @seeking: the seeking flag of the stream which reached the position.
+ *
+ * Stops a stream comparing its timestamps against the position seeked to,
+ * as timestamps are free to jump back after it at cell boundaries. The
+ * position is forgotten once audio and video have both reached it, as
+ * subtitles may not have any frame after it.
+ */
+static void
+reach_seek (VEnginePriv *priv, bool *seeking)
+{
+	*seeking = false;
+	
+	if (!priv->audio_seeking && !priv->video_seeking)
 	{
-		VFrame *frame = v_async_queue_dequeue_wait (priv->audio_events);
-		
-		if (frame == NULL)
-			continue;
-		
+		priv->seek_pts = V_NO_PTS;
+		priv->subpic_seeking = false;
+	}
+}
+
+
+
+
+/*
+ * write_audio:
+ * @node: the audio #VNode.
+ * @self: a #VEngine.
+ *
+ * Writes the decoded audio to the output for as long as the device takes
+ * it without blocking, then reports the device position to the clock. A
+ * full device leaves the rest for when the node is woken again.
+ */
+static void
+write_audio (VNode *node, VEngine *self)
+{
+	VEnginePriv *priv = self->priv;
+	
+	int64_t written = 0;
+	int offset;
+	double delay;
+	
+	
+	while (priv->audio_next < priv->audio_queued)
+	{
+		VFrame *frame = priv->audio_frames[priv->audio_next];
 		
-		/* decode audio frame */
-		VFrame *aud_frame = v_codec_decode (priv->audio->codec, frame, NULL);
+		offset = v_output_write_partial (self->audio_output, frame, priv->audio_offset);
+		written += offset - priv->audio_offset;
 		
+		if (offset < V_FRAME_AUDIO (frame)->length)
+		{
+			priv->audio_offset = offset;
+			v_node_wait (node, AUDIO_RETRY);
+			break;
+		}
 		
-		/* send frame to the output device */
-		v_output_write (self->audio_output, aud_frame);
+		v_frame_free (frame);
 		
+		priv->audio_next++;
+		priv->audio_offset = 0;
+	}
+	
+	if (priv->audio_next == priv->audio_queued)
+	{
+		priv->audio_next = 0;
+		priv->audio_queued = 0;
+	}
+	
+	
+	/* video follows the samples actually being heard */
+	if (priv->audio_pts != V_NO_PTS &&
+	    priv->audio->sample_rate > 0 && priv->audio->channels > 0)
+	{
+		priv->audio_samples += written / (2 * priv->audio->channels);
 		
-		/* clean up */
-		v_frame_free (aud_frame);
-		v_frame_free (frame);
+		if (v_output_get_delay (self->audio_output, &delay))
+			v_clock_set_audio (priv->clock, priv->audio_pts +
+					priv->audio_samples * 90000 / priv->audio->sample_rate,
+					delay);
 	}
+}
+
+
+
+/*
+ * drop_audio:
+ * @priv: a #VEnginePriv.
+ *
+ * Frees the decoded audio not written to the device yet.
+ */
+static void
+drop_audio (VEnginePriv *priv)
+{
+	while (priv->audio_next < priv->audio_queued)
+		v_frame_free (priv->audio_frames[priv->audio_next++]);
 	
+	priv->audio_next = 0;
+	priv->audio_queued = 0;
+	priv->audio_offset = 0;
 }
 
 
 
 /*
- * process_video:
- * @user_data: a #VEngine.
+ * decode_audio:
+ * @node: the audio #VNode.
+ * @frames: the waiting raw audio frames.
+ * @count: the amount of frames.
+ * @data: the #VEngine.
  *
- * Reads frames from an input and adds it to the appropriate
- * queue for decoding and output.
+ * Decodes the waiting audio frames as one batch and writes them to the
+ * audio output. The node is woken with no frames to write what the device
+ * had no room for.
  */
-static void *
-process_video (void *user_data)
+static void
+decode_audio (VNode *node, VFrame **frames, unsigned int count, void *data)
 {
-	VEngine *self = (VEngine *) user_data;
+	VEngine *self = (VEngine *) data;
 	VEnginePriv *priv = self->priv;
+	
+	int i, j;
+	
+	
+	if (count == 0)
+	{
+		write_audio (node, self);
+		return;
+	}
+	
+	
+	/* drop everything up to the first frame at the seek position */
+	for (i = 0, j = 0; i < count; i++)
+	{
+		VFrameRaw *raw = V_FRAME_RAW (frames[i]);
+		
+		if (priv->audio_seeking && raw->pts != V_NO_PTS && !before_seek (priv, raw->pts))
+			reach_seek (priv, &priv->audio_seeking);
+		
+		if (priv->audio_seeking)
+			v_frame_free (frames[i]);
+		
+		else
+			frames[j++] = frames[i];
+	}
+	
+	count = j;
+	
+	if (count == 0)
+		return;
+	
+	
+	/* batches without a timestamp carry on from the last one */
+	if (V_FRAME_RAW (frames[0])->pts != V_NO_PTS)
+	{
+		priv->audio_pts = V_FRAME_RAW (frames[0])->pts;
+		priv->audio_samples = 0;
+	}
+	
+	
+	/* decode audio frames into one buffer */
+	priv->audio_queued = v_codec_decode_batch (priv->audio->codec,
+			(VFrameRaw **) frames, count, priv->audio_frames, NULL);
+	
+	
+	/* send frames to the output device, which plays them in real time */
+	if (priv->paced)
+		write_audio (node, self);
+	
+	else
+		drop_audio (priv);
+	
+	
+	/* clean up */
+	for (i = 0; i < count; i++)
+		v_frame_free (frames[i]);
+}
 
 
-	while (true)
-	{
-		VFrame *frame = v_async_queue_dequeue_wait (priv->video_events);
 
-		if (frame == NULL)
-			continue;
+/*
+ * decode_video:
+ * @node: the video #VNode.
+ * @frames: the waiting raw video frames.
+ * @count: the amount of frames.
+ * @data: the #VEngine.
+ *
+ * Decodes a video frame for the following stages. Decoded pictures are
+ * shared with the decoder, so they are converted to the format of the
+ * video output only once they are displayed.
+ */
+static void
+decode_video (VNode *node, VFrame **frames, unsigned int count, void *data)
+{
+	VEngine *self = (VEngine *) data;
+	VEnginePriv *priv = self->priv;
+	
+	VFrame *frame = frames[0];
+	
+	
+	/* decoding restarts at a keyframe after a seek */
+	if (priv->need_keyframe)
+	{
+		if (!V_FRAME_RAW (frame)->key_frame)
+		{
+			v_frame_free (frame);
+			return;
+		}
 		
+		priv->need_keyframe = false;
+	}
 
-		/* decode video frame */
-		VFrame *vid_frame = v_codec_decode (priv->video->codec, frame, NULL);
-		
+
+	/* decode video frame */
+	VFrame *vid_frame = v_codec_decode (priv->video->codec, frame, NULL);
+	
+	
+	/* pictures leading up to the seek position are only decoded */
+	if (vid_frame && priv->video_seeking)
+	{
+		int64_t pts = V_FRAME_VIDEO (vid_frame)->pts;
 		
-		if (vid_frame)
+		if (before_seek (priv, pts))
 		{
-			/* timer prototype */
-			VFrameRaw *raw = (VFrameRaw *) frame;
-			double timeout = v_clock_get_timeout (priv->clock, raw);
-			
-			
-			VFrame *fin_frame = v_colorspace_convert (priv->colorspace, vid_frame);
-			
-			
-			/* timer prototype */
-//			if (timeout > 0.010)
-//				usleep (timeout * 1000000.0);
-			
-			
-	
-			/* send frame to the output device */
-			v_output_write (self->video_output, fin_frame);
-			
-			
-			/* clean up */
-			v_frame_free (fin_frame);
 			v_frame_free (vid_frame);
-			
+			vid_frame = NULL;
 		}
 		
-		
-		v_frame_free (frame);
+		else if (pts != V_NO_PTS)
+			reach_seek (priv, &priv->video_seeking);
 	}
 	
+	
+	if (vid_frame)
+		v_node_emit (node, vid_frame);
+	
+	
+	v_frame_free (frame);
 }
 
 
 
 /*
- * process_subpic:
- * @user_data: a #VEngine.
+ * deinterlace_video:
+ * @node: the deinterlace #VNode.
+ * @frames: the waiting pictures.
+ * @count: the amount of frames.
+ * @data: the #VEngine.
  *
- * Reads frames from an input and adds it to the appropriate
- * queue for decoding and output.
+ * Deinterlaces a picture when the decoder flagged it interlaced. The
+ * decoder may still predict from the picture, so it is deinterlaced in a
+ * converted or copied picture of its own. Other pictures are passed on
+ * untouched.
  */
-static void *
-process_subpic (void *user_data)
+static void
+deinterlace_video (VNode *node, VFrame **frames, unsigned int count, void *data)
 {
-	VEngine *self = (VEngine *) user_data;
+	VEngine *self = (VEngine *) data;
 	VEnginePriv *priv = self->priv;
+	
+	VFrame *frame = frames[0];
+	VFrameVideo *video = V_FRAME_VIDEO (frame);
+	
+	
+	if (!video->interlaced || priv->deinterlacer->mode == V_DEINTERLACE_MODE_NONE)
+	{
+		v_node_emit (node, frame);
+		return;
+	}
+	
+	
+	VFrame *fin_frame = v_colorspace_convert (priv->colorspace, frame);
+	
+	/* passed through pictures still belong to the decoder */
+	if (fin_frame == frame)
+	{
+		v_frame_free (fin_frame);
+		fin_frame = V_FRAME (v_frame_pool_copy (priv->video_pool, video));
+	}
+	
+	v_frame_free (frame);
+	video = V_FRAME_VIDEO (fin_frame);
+	
+	
+	v_deinterlacer_process (priv->deinterlacer, video->pixel_format,
+			video->data, video->linesize, video->width, video->height,
+			video->top_field_first);
+	
+	v_node_emit (node, fin_frame);
+}
 
 
-	while (true)
+
+/*
+ * show_video:
+ * @node: the display #VNode.
+ * @frames: the waiting pictures.
+ * @count: the amount of frames.
+ * @data: the #VEngine.
+ *
+ * Displays a finished picture at its presentation time. A picture that
+ * isn't due yet is kept while the node waits, so the worker is free to
+ * run other stages in the meantime. Decoded pictures are converted straight
+ * into the device buffer, pictures already in the output format are copied
+ * into it, so either way each picture is written once.
+ */
+static void
+show_video (VNode *node, VFrame **frames, unsigned int count, void *data)
+{
+	VEngine *self = (VEngine *) data;
+	VEnginePriv *priv = self->priv;
+	
+	VFrame *frame = count > 0 ? frames[0] : priv->pending;
+	VFrameVideo *video;
+	double delay;
+	
+	uint8_t *buffer[4];
+	int linesize[4];
+	
+	
+	priv->pending = NULL;
+	
+	if (frame == NULL)
+		return;
+	
+	video = V_FRAME_VIDEO (frame);
+	
+	
+	/* pace the picture by its display order timestamp */
+	if (priv->paced)
+	{
+		delay = v_clock_get_delay (priv->clock, video->pts);
+		
+		if (delay > 0)
+		{
+			priv->pending = frame;
+			v_node_wait (node, delay);
+			return;
+		}
+		
+		v_clock_present (priv->clock, video->pts);
+	}
+	
+	if (video->pixel_format == priv->video_format)
+		v_output_write (self->video_output, frame);
+	
+	else if (v_output_get_buffer (self->video_output, buffer, linesize))
+	{
+		v_colorspace_convert_into (priv->colorspace, frame, buffer, linesize);
+		v_output_present (self->video_output);
+	}
+	
+	else
 	{
-		VFrame *frame = v_async_queue_dequeue_wait (priv->subpic_events);
+		VFrame *fin_frame = v_colorspace_convert (priv->colorspace, frame);
+		
+		v_output_write (self->video_output, fin_frame);
+		v_frame_free (fin_frame);
+	}
+	
+	
+	priv->pictures++;
+	
+	if (priv->seek_timing)
+	{
+		VEngineStats *stats = &priv->stats;
+		double latency = get_time () - priv->seek_time;
+		
+		priv->seek_timing = false;
 		
-		if (frame == NULL)
-			continue;
+		stats->seeks++;
+		stats->seek_latency = latency;
+		stats->mean_seek_latency += (latency - stats->mean_seek_latency) / stats->seeks;
 		
+		if (latency > stats->max_seek_latency)
+			stats->max_seek_latency = latency;
 		
+		if (latency > V_ENGINE_SEEK_TARGET)
+			stats->slow_seeks++;
+	}
+	
+	
+	v_frame_free (frame);
+}
 
-		/* decode subtitle frame */
-		VFrame *sub_frame = v_codec_decode (priv->subpic->codec, frame, NULL);
 
+
+/*
+ * show_subpic:
+ * @node: the subpicture #VNode.
+ * @frames: the waiting raw subtitle frames.
+ * @count: the amount of frames.
+ * @data: the #VEngine.
+ *
+ * Decodes a subtitle frame and hands it to the video output.
+ */
+static void
+show_subpic (VNode *node, VFrame **frames, unsigned int count, void *data)
+{
+	VEngine *self = (VEngine *) data;
+	VEnginePriv *priv = self->priv;
+	
+	VFrame *frame = frames[0];
+	
+	
+	/* subtitles before the seek position are already over */
+	if (priv->subpic_seeking)
+	{
+		int64_t pts = V_FRAME_RAW (frame)->pts;
 		
-		if (sub_frame)
+		if (before_seek (priv, pts))
 		{
-			VFrameSubtitle *sub = V_FRAME_SUBTITLE (sub_frame);
-			
-			
-			VColorspace *col = v_colorspace_new (V_PIXEL_FORMAT_RGB32,
-					V_PIXEL_FORMAT_YUV420,
-					sub->w,
-					sub->h,
-					NULL);
-			
-			
-			VFrame *fin_frame = v_colorspace_convert (col, sub_frame);
-			
-			
-			v_output_write_sub (self->video_output, fin_frame);
-			
-			
-			v_frame_free (sub_frame);
+			v_frame_free (frame);
+			return;
 		}
 		
-		
+		if (pts != V_NO_PTS)
+			priv->subpic_seeking = false;
+	}
 
-		/* clean up */
-		v_frame_free (frame);
+
+	/* decode subtitle frame */
+	VFrame *sub_frame = v_codec_decode (priv->subpic->codec, frame, NULL);
+
+	
+	if (sub_frame)
+	{
+		/* the output blends the subpicture into the video */
+		v_output_write_sub (self->video_output, sub_frame);
+		v_frame_free (sub_frame);
 	}
 	
+	
+
+	/* clean up */
+	v_frame_free (frame);
 }
 
 
 
 
 /*
- * process_frames:
- * @user_data: a #VmeEngine.
+ * route_frame:
+ * @priv: a #VEnginePriv.
+ * @frame: a raw frame.
+ *
+ * Finds the node handling the stream @frame belongs to.
  *
- * Reads frames from an input and adds it to the appropriate
- * queue for decoding and output.
+ * Returns: the #VNode to pass @frame to, %NULL if no node handles it.
  */
-static void *
-process_frames (void *user_data)
+static VNode *
+route_frame (VEnginePriv *priv, VFrameRaw *frame)
 {
-	VEngine *self = (VEngine *) user_data;
+	/* audio frame */
+	if (priv->audio && frame->stream_id == priv->audio->id)
+		return priv->audio_node;
+
+	/* video frame */
+	else if (priv->video && frame->stream_id == priv->video->id)
+		return priv->video_node;
+
+	/* subpic frame */
+	else if (priv->subpic && frame->stream_id == priv->subpic->id)
+		return priv->subpic_node;
+	
+	
+	return NULL;
+}
+
+
+
+
+/*
+ * read_frames:
+ * @node: the demuxer #VNode.
+ * @data: the #VEngine.
+ *
+ * Reads a frame from the input and passes it to the node handling its
+ * stream for decoding and output.
+ *
+ * Returns: %false at the end of the input, %true otherwise.
+ */
+static bool
+read_frames (VNode *node, void *data)
+{
+	VEngine *self = (VEngine *) data;
 	VEnginePriv *priv = self->priv;
 	
+	VFrameRaw *frame = v_input_read_frame (self->input, NULL);
+	VNode *target;
 	
 	
-	/* process input events */
-	while (true)
-	{
-		VFrameRaw *frame = v_input_read_frame (self->input, NULL);
-		
-		if (frame == NULL)
-			break;
-		
-		
-		
-		/* audio frame */
-		if (priv->audio && frame->stream_id == priv->audio->id)
-			v_async_queue_enqueue_wait (priv->audio_events, frame);
+	/* end of the input */
+	if (frame == NULL)
+		return false;
+	
+	
+	target = route_frame (priv, frame);
+	
+	/* not a stream being played */
+	if (target == NULL)
+		v_frame_free (V_FRAME (frame));
+	
+	else
+		v_node_emit_to (node, target, V_FRAME (frame));
+	
+	
+	return true;
+}
 
-		/* video frame */
-		else if (priv->video && frame->stream_id == priv->video->id)
-			v_async_queue_enqueue_wait (priv->video_events, frame);
 
-		/* subpic frame */
-		else if (priv->subpic && frame->stream_id == priv->subpic->id)
-			v_async_queue_enqueue_wait (priv->subpic_events, frame);
 
-		
+
+
+/*
+ * stop_pipeline:
+ * @priv: a #VEnginePriv.
+ *
+ * Pauses the pipeline and drops every frame in it, including the picture
+ * the display was waiting to present and audio waiting for the device.
+ */
+static void
+stop_pipeline (VEnginePriv *priv)
+{
+	v_pipeline_pause (priv->pipeline);
+	v_pipeline_flush (priv->pipeline);
+	
+	if (priv->pending != NULL)
+	{
+		v_frame_free (priv->pending);
+		priv->pending = NULL;
 	}
+	
+	drop_audio (priv);
+}
+
+
+
 
+/*
+ * pipeline_eos:
+ * @pipeline: the engine #VPipeline.
+ * @data: the #VEngine.
+ *
+ * Handles the end of stream once every node is done. How fast the media
+ * was processed is left for the owner to read with v_engine_get_stats().
+ */
+static void
+pipeline_eos (VPipeline *pipeline, void *data)
+{
+	VEngine *self = (VEngine *) data;
+	VEnginePriv *priv = self->priv;
+	
+	if (priv->eos_handler != NULL)
+		priv->eos_handler (self, priv->eos_userdata);
 }
 
 
@@ -374,12 +859,41 @@ v_engine_new (void)
 	priv->audio = NULL;
 	priv->video = NULL;
 	priv->subpic = NULL;
+	priv->video_mode = V_CODEC_MODE_FULL;
+	priv->video_lowres = 0;
+	priv->audio_pts = V_NO_PTS;
+	priv->seek_pts = V_NO_PTS;
+	priv->paced = true;
 	
-	priv->audio_events = v_async_queue_new (10);
-	priv->video_events = v_async_queue_new (10);
-	priv->subpic_events = v_async_queue_new (10);
+	
+	/* build the pipeline */
+	priv->pipeline = v_pipeline_new ();
+	
+	priv->demux_node = v_pipeline_add_source (priv->pipeline, "demuxer", read_frames, ret);
+	priv->audio_node = v_pipeline_add_node (priv->pipeline, "audio", decode_audio, ret);
+	priv->video_node = v_pipeline_add_node (priv->pipeline, "video", decode_video, ret);
+	priv->deinterlace_node = v_pipeline_add_node (priv->pipeline, "deinterlace", deinterlace_video, ret);
+	priv->display_node = v_pipeline_add_node (priv->pipeline, "display", show_video, ret);
+	priv->subpic_node = v_pipeline_add_node (priv->pipeline, "subpicture", show_subpic, ret);
+	
+	v_node_link (priv->demux_node, priv->audio_node, QUEUE_DEPTH);
+	v_node_link (priv->demux_node, priv->video_node, QUEUE_DEPTH);
+	v_node_link (priv->demux_node, priv->subpic_node, QUEUE_DEPTH);
+	
+	v_node_link (priv->video_node, priv->deinterlace_node, PICTURE_DEPTH);
+	v_node_link (priv->deinterlace_node, priv->display_node, PICTURE_DEPTH);
+	
+	/* keep the pictures in the cache of the worker that decoded them */
+	v_node_set_hint (priv->deinterlace_node, priv->video_node->hint);
+	v_node_set_hint (priv->display_node, priv->video_node->hint);
+	
+	v_node_set_batch (priv->audio_node, AUDIO_BATCH);
+	
+	v_pipeline_set_eos_func (priv->pipeline, pipeline_eos, ret);
 
 	priv->clock = v_clock_new (NULL);
+	priv->deinterlacer = v_deinterlacer_new (V_DEINTERLACE_MODE_ADAPTIVE);
+	priv->colorspaces = v_colorspace_cache_new (COLORSPACE_CACHE);
 	
 	
 	ret->priv = priv;
@@ -406,10 +920,23 @@ v_engine_free (VEngine *engine)
 	VEnginePriv *priv = engine->priv;
 	
 	
-	/* destroy queues */
-	v_async_queue_free (priv->audio_events);
-	v_async_queue_free (priv->video_events);
-	v_async_queue_free (priv->subpic_events);
+	/* media still open */
+	if (engine->input != NULL)
+		v_engine_close (engine);
+	
+	
+	/* destroy the pipeline and its queues, once its nodes returned */
+	v_pipeline_free (priv->pipeline);
+	
+	v_clock_free (priv->clock);
+	v_deinterlacer_free (priv->deinterlacer);
+	v_colorspace_cache_free (priv->colorspaces);
+	
+	if (engine->audio_output != NULL)
+		v_output_free (engine->audio_output);
+	
+	if (engine->video_output != NULL)
+		v_output_free (engine->video_output);
 
 	v_free (engine->priv);
 	v_free (engine);
@@ -423,17 +950,71 @@ v_engine_free (VEngine *engine)
  * v_engine_close:
  * @engine: a #VEngine.
  *
- * Closes the engine media file and releases its resources.
+ * Closes the engine media file and releases its resources. Running stages
+ * are waited for and queued frames dropped, and the deinterlacer history
+ * and subpicture overlay are cleared, so the engine can open other media
+ * right after.
  */
 void
 v_engine_close (VEngine *engine)
 {
+	VEnginePriv *priv = engine->priv;
+	
+	
+	if (engine->input == NULL)
+		return;
+	
+	
+	/* stop the nodes before their input goes */
+	stop_pipeline (priv);
+	
+	priv->playing = false;
+	priv->play_time = 0;
+	priv->pictures = 0;
+	
+	priv->seek_pts = V_NO_PTS;
+	priv->audio_pts = V_NO_PTS;
+	priv->audio_seeking = false;
+	priv->video_seeking = false;
+	priv->subpic_seeking = false;
+	priv->seek_timing = false;
+	priv->need_keyframe = false;
+	
+	/* nothing of this title may show through in the next */
+	v_deinterlacer_reset (priv->deinterlacer);
+	
+	
+	/* the outputs were opened for the streams */
+	if (priv->audio != NULL)
+		v_output_close (engine->audio_output);
+	
+	if (priv->video != NULL)
+		v_output_close (engine->video_output);
+	
+	
+	/* the streams are free'd with the input */
+	priv->audio  = NULL;
+	priv->video  = NULL;
+	priv->subpic = NULL;
+	
+	
+	/* the video conversion context stays cached for the next title */
+	priv->colorspace = NULL;
+	
+	if (priv->video_pool != NULL)
+	{
+		v_frame_pool_free (priv->video_pool);
+		priv->video_pool = NULL;
+	}
+	
+	
 	/* unload components */
 	v_input_close (engine->input);
 
 
 	/* free components */
 	v_input_free (engine->input);
+	engine->input = NULL;
 }
 
 
@@ -495,17 +1076,202 @@ bool
 v_engine_play (VEngine *engine, VError *error)
 {
 	VEnginePriv *priv = engine->priv;
+	
+	
+	/* resume without rushing to catch up on the time paused */
+	v_clock_reset (priv->clock);
+	
+	if (priv->play_time == 0)
+		priv->play_time = get_time ();
+	
+	/* a seek made while paused is timed from here */
+	if (priv->seek_timing && !priv->playing)
+		priv->seek_time = get_time ();
+	
+	priv->playing = true;
+	
+	/* the other nodes are queued as frames arrive */
+	v_pipeline_start (priv->pipeline);
+
+	return true;
+}
+
+
+/**
+ * v_engine_set_video_mode:
+ * @engine: a #VEngine.
+ * @mode: the #VCodecMode to decode the video stream with.
+ *
+ * Sets the decoding mode of the video stream. Using %V_CODEC_MODE_KEYFRAMES
+ * only decodes key frames, which is useful for scrubbing and generating
+ * thumbnails. The mode can be set before or during playback.
+ */
+void
+v_engine_set_video_mode (VEngine *engine, VCodecMode mode)
+{
+	VEnginePriv *priv = engine->priv;
+	
+	priv->video_mode = mode;
+	
+	/* stream is already playing */
+	if (priv->video != NULL)
+		v_codec_set_mode (priv->video->codec, mode);
+}
 
 
-	pthread_create (&priv->frames_proc, NULL, process_frames, engine);
-	pthread_create (&priv->audio_proc, NULL, process_audio, engine);
-	pthread_create (&priv->video_proc, NULL, process_video, engine);
-	pthread_create (&priv->subpic_proc, NULL, process_subpic, engine);
 
-	return true;
+
+/**
+ * v_engine_set_deinterlace_mode:
+ * @engine: a #VEngine.
+ * @mode: the #VDeinterlaceMode to use.
+ *
+ * Sets how interlaced video is deinterlaced. Only pictures the decoder
+ * flags as interlaced are processed, so progressive video is unaffected.
+ * The default is %V_DEINTERLACE_MODE_ADAPTIVE.
+ */
+void
+v_engine_set_deinterlace_mode (VEngine *engine, VDeinterlaceMode mode)
+{
+	v_deinterlacer_set_mode (engine->priv->deinterlacer, mode);
 }
 
 
+
+
+/**
+ * v_engine_set_video_lowres:
+ * @engine: a #VEngine.
+ * @lowres: the scale factor, where 0 is full size, 1 is half size,
+ * 2 is quarter size and so on.
+ *
+ * Decodes the video stream at a reduced resolution, which is much cheaper
+ * for previews and thumbnails. This must be set before v_engine_open() as
+ * the output and colorspace conversion are set up with the reduced size.
+ */
+void
+v_engine_set_video_lowres (VEngine *engine, int lowres)
+{
+	VEnginePriv *priv = engine->priv;
+	priv->video_lowres = lowres;
+}
+
+
+
+
+/**
+ * v_engine_set_paced:
+ * @engine: a #VEngine.
+ * @paced: whether to play the media in real time.
+ *
+ * Sets whether frames are presented at their timestamps. Unpaced, every
+ * stage runs as fast as it can, which suits processing media rather than
+ * watching it. The audio device plays in real time so it is left out,
+ * though audio is still decoded. Completion is signalled by the handler
+ * set with v_engine_register_eos().
+ */
+void
+v_engine_set_paced (VEngine *engine, bool paced)
+{
+	engine->priv->paced = paced;
+}
+
+
+
+
+/**
+ * v_engine_set_queue_depth:
+ * @engine: a #VEngine.
+ * @min: the smallest amount of frames queued for each stream.
+ * @max: the largest amount of frames queued for each stream.
+ *
+ * Sets how many demuxed frames may wait for each stream. With @min below
+ * @max the queues adapt to the stream, growing when bursts of a high
+ * bitrate stream would stall the demuxer and shrinking back when idle, so
+ * at most @max frames are held per stream. Ignored while playing.
+ */
+void
+v_engine_set_queue_depth (VEngine *engine, unsigned int min, unsigned int max)
+{
+	VEnginePriv *priv = engine->priv;
+	
+	v_node_set_depth (priv->demux_node, priv->audio_node, min, max);
+	v_node_set_depth (priv->demux_node, priv->video_node, min, max);
+	v_node_set_depth (priv->demux_node, priv->subpic_node, min, max);
+}
+
+
+
+/**
+ * v_engine_register_eos:
+ * @engine: a #VEngine.
+ * @func: the #VEngineEosFunc to call.
+ * @userdata: user data to pass to @func.
+ *
+ * Sets the handler called once the end of the media has passed through
+ * every stage. It is called from a worker thread, and must not close the
+ * engine itself.
+ */
+void
+v_engine_register_eos (VEngine *engine, VEngineEosFunc *func, void *userdata)
+{
+	engine->priv->eos_handler = func;
+	engine->priv->eos_userdata = userdata;
+}
+
+
+
+
+/**
+ * v_engine_get_stats:
+ * @engine: a #VEngine.
+ * @stats: return location for the #VEngineStats.
+ *
+ * Fills @stats with how playback has performed since @engine was created,
+ * such as how long seeks took against %V_ENGINE_SEEK_TARGET, along with
+ * the pictures shown and the work of each stage of the current title.
+ */
+void
+v_engine_get_stats (VEngine *engine, VEngineStats *stats)
+{
+	VEnginePriv *priv = engine->priv;
+	
+	/* each stage and the stage feeding it */
+	VNode *stages[][2] = {
+		{ priv->demux_node, NULL },
+		{ priv->audio_node, priv->demux_node },
+		{ priv->video_node, priv->demux_node },
+		{ priv->deinterlace_node, priv->video_node },
+		{ priv->display_node, priv->deinterlace_node },
+		{ priv->subpic_node, priv->demux_node }
+	};
+	
+	unsigned int i;
+	
+	
+	*stats = priv->stats;
+	
+	stats->pictures = priv->pictures;
+	stats->elapsed = priv->play_time > 0 ? get_time () - priv->play_time : 0;
+	stats->frame_rate = stats->elapsed > 0 ? priv->pictures / stats->elapsed : 0;
+	
+	for (i = 0; i < V_ENGINE_STAGES; i++)
+	{
+		VEngineStageStats *stage = &stats->stages[i];
+		
+		stage->name = stages[i][0]->name;
+		v_node_get_stats (stages[i][0], &stage->node);
+		
+		if (stages[i][1] != NULL)
+			v_node_get_link_stats (stages[i][1], stages[i][0], &stage->input);
+		else
+			memset (&stage->input, 0, sizeof (VLinkStats));
+	}
+}
+
+
+
+
 /**
  * v_engine_pause:
  * @engine: a #VEngine.
@@ -515,7 +1281,12 @@ v_engine_play (VEngine *engine, VError *error)
 void
 v_engine_pause (VEngine *engine)
 {
-
+	VEnginePriv *priv = engine->priv;
+	
+	priv->playing = false;
+	
+	/* frames stay queued for when playback resumes */
+	v_pipeline_pause (priv->pipeline);
 }
 
 
@@ -528,7 +1299,74 @@ v_engine_pause (VEngine *engine)
 void
 v_engine_stop (VEngine *engine)
 {
+	v_engine_pause (engine);
+	v_engine_seek (engine, 0, NULL);
+}
+
+
+
 
+/**
+ * v_engine_seek:
+ * @engine: a #VEngine.
+ * @position: the position to move to, in seconds from the start.
+ * @error: a #VError, or %NULL.
+ *
+ * Moves playback of the media file to @position. All queued frames and
+ * decoder state are dropped, decoding restarts from the keyframe preceding
+ * @position and anything decoded before it is discarded rather than shown.
+ * Playback continues from the new position if the engine was playing.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+bool
+v_engine_seek (VEngine *engine, double position, VError *error)
+{
+	VEnginePriv *priv = engine->priv;
+	int64_t pts;
+	bool ret;
+	
+	
+	/* no media open */
+	if (engine->input == NULL)
+		return false;
+	
+	priv->seek_time = get_time ();
+	
+	/* nothing may touch the streams while they are repositioned */
+	stop_pipeline (priv);
+	
+	
+	ret = v_input_seek (engine->input, position, &pts, error);
+	
+	if (ret)
+	{
+		/* streams the title lacks never reach the position */
+		priv->seek_pts = pts;
+		priv->audio_seeking  = priv->audio  != NULL;
+		priv->video_seeking  = priv->video  != NULL;
+		priv->subpic_seeking = priv->subpic != NULL;
+		priv->seek_timing = true;
+		priv->need_keyframe = true;
+		
+		priv->audio_pts = V_NO_PTS;
+		priv->audio_samples = 0;
+		
+		/* motion is not looked for against a picture from before */
+		v_deinterlacer_reset (priv->deinterlacer);
+		
+		/* drop the audio still waiting in the device */
+		if (priv->audio != NULL)
+			v_output_flush (engine->audio_output);
+		v_clock_reset (priv->clock);
+	}
+	
+	
+	/* an unsuccessful seek carries on from where it was */
+	if (priv->playing)
+		v_pipeline_start (priv->pipeline);
+	
+	return ret;
 }
 
 
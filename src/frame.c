@@ -26,6 +26,82 @@
 
 #include "frame.h"
 #include "mem.h"
+#include <string.h>  /* memcpy */
+
+
+
+/* video planes start on cache lines so SIMD kernels get aligned rows */
+#define PLANE_ALIGN 64
+
+/* the most frames a pool keeps for recycling */
+#define POOL_SLOTS 32
+
+
+
+/*
+ * VFramePoolPriv:
+ *
+ * Private structure for #VFramePool. The free list is a stack of slot
+ * indices whose head packs a tag above the index so that a slot popped and
+ * pushed back in between can't be mistaken for an unchanged head.
+ */
+struct _VFramePoolPriv
+{
+	int ref_count;
+	int allocated;
+	
+	uint64_t free_list;
+	int next[POOL_SLOTS];
+	
+	VFrameVideo *frames[POOL_SLOTS];
+	
+	int linesize[4];
+	int offset[4];
+};
+
+
+
+
+/*
+ * get_layout:
+ * @format: the #VPixelFormat of the picture.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @linesize: return location for the size of each plane line.
+ * @offset: return location for the offset of each plane.
+ *
+ * Lays out the planes of a picture with aligned lines. Each plane is
+ * followed by padding so kernels can read a full vector past the last
+ * line.
+ *
+ * Returns: the size of all the planes.
+ */
+static int
+get_layout (VPixelFormat format,
+            int width,
+            int height,
+            int linesize[4],
+            int offset[4])
+{
+	int bytes, lines;
+	int size = 0;
+	int i;
+	
+	
+	memset (linesize, 0, 4 * sizeof (int));
+	memset (offset, 0, 4 * sizeof (int));
+	
+	for (i = 0; v_pixel_format_get_plane (format, i, width, height, &bytes, &lines); i++)
+	{
+		linesize[i] = (bytes + PLANE_ALIGN - 1) & ~(PLANE_ALIGN - 1);
+		offset[i] = size;
+		
+		size += linesize[i] * lines + PLANE_ALIGN;
+	}
+	
+	
+	return size;
+}
 
 
 
@@ -42,6 +118,7 @@ v_frame_raw_new (int size)
 	VFrameRaw *ret = v_new (VFrameRaw);
 
 	ret->parent.type = V_FRAME_TYPE_RAW;
+	ret->parent.ref_count = 1;
 	ret->length = size;
 	ret->data = v_mallocz (size);
 
@@ -64,6 +141,7 @@ v_frame_audio_new (int size)
 	VFrameAudio *ret = v_new (VFrameAudio);
 	
 	ret->parent.type = V_FRAME_TYPE_AUDIO;
+	ret->parent.ref_count = 1;
 	ret->length = size;
 	ret->samples = v_mallocz (size);
 	
@@ -86,6 +164,7 @@ v_frame_video_new (void)
 	VFrameVideo *ret = v_new (VFrameVideo);
 	
 	ret->parent.type = V_FRAME_TYPE_VIDEO;
+	ret->parent.ref_count = 1;
 	ret->length = 0;
 	//ret->data = NULL;
 	
@@ -95,6 +174,57 @@ v_frame_video_new (void)
 
 
 
+/**
+ * v_frame_video_copy:
+ * @frame: a #VFrameVideo to copy.
+ *
+ * Creates a deep copy of @frame which owns its picture data. This is needed
+ * to keep a decoded picture around since decoders reuse their buffers.
+ *
+ * Returns: a #VFrameVideo structure.
+ */
+VFrameVideo *
+v_frame_video_copy (VFrameVideo *frame)
+{
+	VFrameVideo *ret = v_frame_video_new ();
+	
+	int bytes, lines;
+	int offset[4];
+	int i, y;
+	
+	
+	ret->width  = frame->width;
+	ret->height = frame->height;
+	ret->pixel_format = frame->pixel_format;
+	ret->pts = frame->pts;
+	ret->interlaced = frame->interlaced;
+	ret->top_field_first = frame->top_field_first;
+	
+	
+	ret->length = get_layout (frame->pixel_format, frame->width, frame->height,
+			ret->linesize, offset);
+	ret->buffer = v_malloc_aligned (PLANE_ALIGN, ret->length);
+	
+	
+	/* copy each plane line by line */
+	for (i = 0; v_pixel_format_get_plane (frame->pixel_format, i,
+			frame->width, frame->height, &bytes, &lines); i++)
+	{
+		ret->data[i] = ret->buffer + offset[i];
+		
+		for (y = 0; y < lines; y++)
+			memcpy (ret->data[i] + y * ret->linesize[i],
+					frame->data[i] + y * frame->linesize[i],
+					bytes);
+	}
+	
+	
+	return ret;
+}
+
+
+
+
 /**
  * v_video_frame_new:
  *
@@ -108,6 +238,7 @@ v_frame_subtitle_new (void)
 	VFrameSubtitle *ret = v_new (VFrameSubtitle);
 	
 	ret->parent.type = V_FRAME_TYPE_SUBTITLE;
+	ret->parent.ref_count = 1;
 	//ret->data = NULL;
 	
 	return ret;
@@ -117,16 +248,115 @@ v_frame_subtitle_new (void)
 
 
 
+/**
+ * v_frame_subtitle_copy:
+ * @frame: a #VFrameSubtitle to copy.
+ *
+ * Creates a deep copy of @frame which owns its picture data. This is needed
+ * when @frame borrows its planes from a decoder or colorspace.
+ *
+ * Returns: a #VFrameSubtitle structure.
+ */
+VFrameSubtitle *
+v_frame_subtitle_copy (VFrameSubtitle *frame)
+{
+	VFrameSubtitle *ret = v_frame_subtitle_new ();
+	
+	int bytes, lines;
+	int size = 0;
+	int i, y;
+	
+	
+	ret->x = frame->x;
+	ret->y = frame->y;
+	ret->w = frame->w;
+	ret->h = frame->h;
+	ret->pixel_format = frame->pixel_format;
+	
+	
+	/* get the size of all the planes with 16 byte aligned lines */
+	for (i = 0; v_pixel_format_get_plane (frame->pixel_format, i,
+			frame->w, frame->h, &bytes, &lines); i++)
+	{
+		ret->linesize[i] = (bytes + 15) & ~15;
+		size += ret->linesize[i] * lines;
+	}
+	
+	ret->buffer = v_malloc (size);
+	
+	
+	/* copy each plane line by line */
+	uint8_t *dst = ret->buffer;
+	
+	for (i = 0; v_pixel_format_get_plane (frame->pixel_format, i,
+			frame->w, frame->h, &bytes, &lines); i++)
+	{
+		ret->data[i] = dst;
+		
+		for (y = 0; y < lines; y++)
+			memcpy (dst + y * ret->linesize[i],
+					frame->data[i] + y * frame->linesize[i],
+					bytes);
+		
+		dst += ret->linesize[i] * lines;
+	}
+	
+	
+	return ret;
+}
+
+
+
+
+
+
+/**
+ * v_frame_ref:
+ * @frame: a #VFrame.
+ *
+ * Adds a reference to @frame so that it can be shared without copying. Each
+ * reference is released with v_frame_free().
+ *
+ * Returns: @frame.
+ */
+VFrame *
+v_frame_ref (VFrame *frame)
+{
+	__sync_fetch_and_add (&frame->ref_count, 1);
+	return frame;
+}
+
+
+
+
+static void release_frame (VFrameVideo *frame);
+
+
+
 
 /**
  * v_frame_free:
  * @frame: a #VFrame to free.
  *
- * Free's @frame and its contents.
+ * Releases a reference to @frame. Once the last reference is released
+ * @frame and its contents are free'd, or handed back to the #VFramePool
+ * they came from.
  */
 void
 v_frame_free (VFrame *frame)
 {
+	/* still referenced elsewhere */
+	if (__sync_sub_and_fetch (&frame->ref_count, 1) > 0)
+		return;
+	
+	
+	/* pooled frames are kept whole for reuse */
+	if (frame->type == V_FRAME_TYPE_VIDEO && V_FRAME_VIDEO (frame)->pool != NULL)
+	{
+		release_frame (V_FRAME_VIDEO (frame));
+		return;
+	}
+	
 	
 	/* free frame data */
 	switch (frame->type)
@@ -140,10 +370,14 @@ v_frame_free (VFrame *frame)
 			break;
 			
 		case V_FRAME_TYPE_VIDEO:
-			//v_free (V_FRAME_VIDEO (frame)->data);
+			/* borrowed planes are owned by the decoder */
+			if (V_FRAME_VIDEO (frame)->buffer != NULL)
+				v_free (V_FRAME_VIDEO (frame)->buffer);
 			break;
 			
 		case V_FRAME_TYPE_SUBTITLE:
+			if (V_FRAME_SUBTITLE (frame)->buffer != NULL)
+				v_free (V_FRAME_SUBTITLE (frame)->buffer);
 			break;
 	}
 	
@@ -152,3 +386,302 @@ v_frame_free (VFrame *frame)
 	v_free (frame);
 }
 
+
+
+
+
+/*
+ * push_slot:
+ * @priv: a #VFramePoolPriv.
+ * @index: the slot to push.
+ *
+ * Pushes @index onto the free list.
+ */
+static void
+push_slot (VFramePoolPriv *priv, int index)
+{
+	uint64_t head, next;
+	
+	do
+	{
+		head = __atomic_load_n (&priv->free_list, __ATOMIC_ACQUIRE);
+		__atomic_store_n (&priv->next[index], (int) (head & 0xffffffff), __ATOMIC_RELAXED);
+		
+		/* bump the tag and store the index off by one, zero being empty */
+		next = (((head >> 32) + 1) << 32) | (uint64_t) (index + 1);
+	}
+	while (!__sync_bool_compare_and_swap (&priv->free_list, head, next));
+}
+
+
+
+
+/*
+ * pop_slot:
+ * @priv: a #VFramePoolPriv.
+ *
+ * Pops a slot off the free list.
+ *
+ * Returns: the slot index, -1 if the list is empty.
+ */
+static int
+pop_slot (VFramePoolPriv *priv)
+{
+	uint64_t head, next;
+	int index;
+	
+	do
+	{
+		head = __atomic_load_n (&priv->free_list, __ATOMIC_ACQUIRE);
+		
+		if ((head & 0xffffffff) == 0)
+			return -1;
+		
+		index = (int) (head & 0xffffffff) - 1;
+		next = (((head >> 32) + 1) << 32) | (uint64_t) __atomic_load_n (&priv->next[index], __ATOMIC_RELAXED);
+	}
+	while (!__sync_bool_compare_and_swap (&priv->free_list, head, next));
+	
+	
+	return index;
+}
+
+
+
+
+/*
+ * new_frame:
+ * @pool: a #VFramePool.
+ * @index: the slot of the frame, -1 if it isn't pooled.
+ *
+ * Allocates a frame laid out for @pool.
+ */
+static VFrameVideo *
+new_frame (VFramePool *pool, int index)
+{
+	VFramePoolPriv *priv = pool->priv;
+	VFrameVideo *ret = v_frame_video_new ();
+	int i;
+	
+	
+	ret->width  = pool->width;
+	ret->height = pool->height;
+	ret->pixel_format = pool->pixel_format;
+	
+	ret->length = pool->size;
+	ret->buffer = v_malloc_aligned (PLANE_ALIGN, pool->size);
+	
+	for (i = 0; i < 4; i++)
+	{
+		ret->linesize[i] = priv->linesize[i];
+		ret->data[i] = priv->linesize[i] ? ret->buffer + priv->offset[i] : NULL;
+	}
+	
+	
+	if (index >= 0)
+	{
+		ret->pool = pool;
+		ret->pool_index = index;
+	}
+	
+	
+	return ret;
+}
+
+
+
+
+/*
+ * unref_pool:
+ * @pool: a #VFramePool.
+ *
+ * Releases a reference to @pool, destroying it and its frames with the
+ * last one.
+ */
+static void
+unref_pool (VFramePool *pool)
+{
+	VFramePoolPriv *priv = pool->priv;
+	int i;
+	
+	if (__sync_sub_and_fetch (&priv->ref_count, 1) > 0)
+		return;
+	
+	
+	/* every frame is back on the free list by now */
+	for (i = 0; i < priv->allocated; i++)
+	{
+		v_free (priv->frames[i]->buffer);
+		v_free (priv->frames[i]);
+	}
+	
+	v_free (priv);
+	v_free (pool);
+}
+
+
+
+
+/*
+ * release_frame:
+ * @frame: a pooled #VFrameVideo.
+ *
+ * Hands a frame whose last reference was released back to its pool.
+ */
+static void
+release_frame (VFrameVideo *frame)
+{
+	VFramePool *pool = frame->pool;
+	
+	push_slot (pool->priv, frame->pool_index);
+	unref_pool (pool);
+}
+
+
+
+
+/**
+ * v_frame_pool_new:
+ * @pixel_format: the #VPixelFormat of the frames.
+ * @width: the picture width.
+ * @height: the picture height.
+ *
+ * Creates a pool of video frames with 64 byte aligned, padded planes.
+ * Frames are allocated on demand and recycled once released, so a steady
+ * stream of pictures stops allocating after the first few.
+ *
+ * Returns: a #VFramePool structure.
+ */
+VFramePool *
+v_frame_pool_new (VPixelFormat pixel_format, int width, int height)
+{
+	VFramePool *ret = v_new (VFramePool);
+	VFramePoolPriv *priv = v_new (VFramePoolPriv);
+	
+	
+	ret->pixel_format = pixel_format;
+	ret->width  = width;
+	ret->height = height;
+	ret->size = get_layout (pixel_format, width, height, priv->linesize, priv->offset);
+	
+	/* the owner holds the first reference, each frame in use another */
+	priv->ref_count = 1;
+	
+	ret->priv = priv;
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_frame_pool_free:
+ * @pool: a #VFramePool to free.
+ *
+ * Free's @pool. Frames still in use stay valid and the pool is destroyed
+ * once the last of them is released.
+ */
+void
+v_frame_pool_free (VFramePool *pool)
+{
+	unref_pool (pool);
+}
+
+
+
+
+/**
+ * v_frame_pool_get:
+ * @pool: a #VFramePool.
+ *
+ * Gets an unused frame from @pool, allocating one if none are free. The
+ * frame owns its planes and is handed back with v_frame_free(). Getting
+ * and releasing frames is lock-free.
+ *
+ * Returns: a #VFrameVideo structure.
+ */
+VFrameVideo *
+v_frame_pool_get (VFramePool *pool)
+{
+	VFramePoolPriv *priv = pool->priv;
+	VFrameVideo *ret;
+	int index = pop_slot (priv);
+	
+	
+	if (index >= 0)
+	{
+		ret = priv->frames[index];
+		
+		ret->parent.ref_count = 1;
+		ret->pts = 0;
+		ret->interlaced = false;
+		ret->top_field_first = false;
+	}
+	
+	else
+	{
+		/* claim a new slot while there are any left */
+		index = __atomic_load_n (&priv->allocated, __ATOMIC_RELAXED);
+		
+		while (index < POOL_SLOTS &&
+		       !__sync_bool_compare_and_swap (&priv->allocated, index, index + 1))
+			index = __atomic_load_n (&priv->allocated, __ATOMIC_RELAXED);
+		
+		
+		/* too many frames in flight, hand out one that isn't recycled */
+		if (index >= POOL_SLOTS)
+			return new_frame (pool, -1);
+		
+		
+		ret = new_frame (pool, index);
+		priv->frames[index] = ret;
+	}
+	
+	
+	__sync_fetch_and_add (&priv->ref_count, 1);
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_frame_pool_copy:
+ * @pool: a #VFramePool.
+ * @frame: the #VFrameVideo to copy, in the layout of @pool.
+ *
+ * Copies @frame into a frame from @pool. This detaches pictures whose
+ * planes belong to someone else, such as a decoder reusing its buffers,
+ * without allocating once the pool is warm.
+ *
+ * Returns: a #VFrameVideo structure.
+ */
+VFrameVideo *
+v_frame_pool_copy (VFramePool *pool, VFrameVideo *frame)
+{
+	VFrameVideo *ret = v_frame_pool_get (pool);
+	int bytes, lines;
+	int i, y;
+	
+	
+	ret->pts = frame->pts;
+	ret->interlaced = frame->interlaced;
+	ret->top_field_first = frame->top_field_first;
+	
+	
+	/* copy each plane line by line */
+	for (i = 0; v_pixel_format_get_plane (pool->pixel_format, i,
+			pool->width, pool->height, &bytes, &lines); i++)
+	{
+		for (y = 0; y < lines; y++)
+			memcpy (ret->data[i] + y * ret->linesize[i],
+					frame->data[i] + y * frame->linesize[i],
+					bytes);
+	}
+	
+	
+	return ret;
+}
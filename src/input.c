@@ -30,13 +30,36 @@
 #include "list.h"
 #include "stream.h"
 #include "demuxer.h"
+#include "clock.h"
 #include <string.h>  /* strdup */
 #include <stdlib.h>  /* free */
+#include <errno.h>
 
 #include <stdio.h>
 
 
 
+/* MPEG timestamps count a 90 kHz clock in 33 bits */
+#define PTS_RATE 90000
+#define PTS_WRAP (INT64_C (1) << 33)
+
+/* how far before the target to land, to reach the keyframe before it */
+#define SEEK_PREROLL (PTS_RATE / 2)
+
+/* the bytes read at the end of the input to find its last timestamp */
+#define SEEK_TAIL_SIZE (256 * 1024)
+
+/* packets read for a timestamp after landing */
+#define SEEK_PROBE_PACKETS 64
+
+/* packets read for a keyframe after landing, enough for a group of pictures */
+#define SEEK_KEYFRAME_PACKETS 4096
+
+/* attempts at landing shortly before the target */
+#define SEEK_ATTEMPTS 5
+
+
+
 
 /*
  * VInputPriv:
@@ -57,6 +80,12 @@ struct _VInputPriv
 	VQueue *frames;
 	
 	
+	/* byte size and timestamp range, found on the first seek */
+	int64_t size;
+	int64_t start_pts;
+	int64_t duration;
+	
+	
 	/* events */
 	VNewStreamFunc *new_stream_handler;
 	VEosFunc       *eos_handler;
@@ -238,6 +267,18 @@ void
 v_input_close (VInput *input)
 {
 	VInputPriv *priv = input->priv;
+	VListNode *node;
+	VFrameRaw *frame;
+	
+	
+	/* frames parsed but never read */
+	while ((frame = v_queue_dequeue (priv->frames)) != NULL)
+		v_frame_free (V_FRAME (frame));
+	
+	
+	/* free streams, which releases their codecs */
+	for (node = priv->streams->first; node; node = node->next)
+		v_stream_free ((VStream *) node->data);
 	
 	
 	/* free components */
@@ -344,6 +385,8 @@ v_input_read_frame (VInput *input, VError *error)
 			v_list_remove (priv->new_streams, node);
 			break;
 		}
+		
+		st = NULL;
 	}
 
 	
@@ -351,18 +394,7 @@ v_input_read_frame (VInput *input, VError *error)
 	/* load the stream properties */
 	if (st != NULL)
 	{
-		/* get stream info */
-		VCodecProperties *prop = v_codec_properties (st->codec);
-
-		/* FIXME: this is a really shitty way of doing this.
-		 * must find another way */
-		st->channels = prop->channels;
-		st->sample_rate = prop->sample_rate;
-		st->sample_format = prop->sample_format;
-
-		st->width = prop->width;
-		st->height = prop->height;
-		st->pixel_format = prop->pixel_format;
+		v_stream_update (st);
 		
 		
 		/* raise new stream event */
@@ -381,6 +413,357 @@ v_input_read_frame (VInput *input, VError *error)
 
 
 
+/*
+ * move_to:
+ * @input: a #VInput.
+ * @offset: the byte offset to move to.
+ *
+ * Moves @input to @offset and skips to the next packet.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+static bool
+move_to (VInput *input, int64_t offset)
+{
+	VInputPriv *priv = input->priv;
+	
+	
+	if (!input->seek (input, offset))
+		return false;
+	
+	v_buffer_reset (priv->buffer);
+	input->eos = false;
+	
+	/* offsets past the start land inside a packet */
+	if (offset > 0)
+		v_demuxer_resync (priv->demuxer);
+	
+	return true;
+}
+
+
+
+/*
+ * probe_pts:
+ * @input: a #VInput.
+ * @offset: the byte offset to probe at.
+ * @last: whether to look for the last timestamp up to the end of the input
+ * rather than the first one after @offset.
+ *
+ * Reads packets at @offset for a timestamp. Packets are looked at rather
+ * than parsed into frames, so no codec state or stream events are touched.
+ *
+ * Returns: the timestamp found, %V_NO_PTS if there is none.
+ */
+static int64_t
+probe_pts (VInput *input, int64_t offset, bool last)
+{
+	VInputPriv *priv = input->priv;
+	
+	int64_t ret = V_NO_PTS;
+	int i;
+	
+	
+	if (!move_to (input, offset))
+		return V_NO_PTS;
+	
+	
+	for (i = 0; last || i < SEEK_PROBE_PACKETS; i++)
+	{
+		if (priv->buffer->eos)
+			break;
+		
+		VPacket *packet = v_demuxer_read_packet (priv->demuxer, NULL);
+		
+		if (packet == NULL)
+			break;
+		
+		
+		/* keep the latest timestamp */
+		if (packet->length > 0 && packet->pts != V_NO_PTS &&
+		    (ret == V_NO_PTS || v_clock_pts_diff (packet->pts, ret) > 0))
+			ret = packet->pts;
+		
+		v_packet_free (packet);
+		
+		
+		if (ret != V_NO_PTS && !last)
+			break;
+	}
+	
+	
+	return ret;
+}
+
+
+
+/*
+ * probe_keyframe:
+ * @input: a #VInput.
+ * @offset: the byte offset to probe at.
+ *
+ * Parses the video packets at @offset for the first keyframe, which is
+ * where decoding restarts after a seek. Only streams already known are
+ * parsed and their parsers are flushed again afterwards. Inputs without
+ * video start decoding anywhere, so the first timestamp is taken instead.
+ *
+ * Returns: the timestamp of the keyframe, %V_NO_PTS if there is none.
+ */
+static int64_t
+probe_keyframe (VInput *input, int64_t offset)
+{
+	VInputPriv *priv = input->priv;
+	
+	VListNode *node;
+	VStream *stream;
+	VQueue *frames;
+	VFrameRaw *frame;
+	
+	int64_t ret = V_NO_PTS;
+	bool video = false;
+	int i;
+	
+	
+	for (node = priv->streams->first; node; node = node->next)
+		if (((VStream *) node->data)->codec->type == V_CODEC_TYPE_VIDEO)
+			video = true;
+	
+	if (!video)
+		return probe_pts (input, offset, false);
+	
+	if (!move_to (input, offset))
+		return V_NO_PTS;
+	
+	
+	frames = v_queue_new (0);
+	
+	for (i = 0; i < SEEK_KEYFRAME_PACKETS && ret == V_NO_PTS; i++)
+	{
+		if (priv->buffer->eos)
+			break;
+		
+		VPacket *packet = v_demuxer_read_packet (priv->demuxer, NULL);
+		
+		if (packet == NULL)
+			break;
+		
+		
+		/* parse the packet if it belongs to a known video stream */
+		for (node = priv->streams->first; node; node = node->next)
+		{
+			stream = (VStream *) node->data;
+			
+			if (stream->id == packet->id &&
+			    stream->codec->type == V_CODEC_TYPE_VIDEO)
+			{
+				v_codec_parse (stream->codec, packet, frames);
+				break;
+			}
+		}
+		
+		v_packet_free (packet);
+		
+		
+		while ((frame = v_queue_dequeue (frames)) != NULL)
+		{
+			if (ret == V_NO_PTS && frame->key_frame && frame->pts != V_NO_PTS)
+				ret = frame->pts;
+			
+			v_frame_free (V_FRAME (frame));
+		}
+	}
+	
+	v_queue_free (frames);
+	
+	
+	/* the parsers saw a cut off stream */
+	for (node = priv->streams->first; node; node = node->next)
+		v_codec_flush (((VStream *) node->data)->codec);
+	
+	return ret;
+}
+
+
+
+/*
+ * index_input:
+ * @input: a #VInput.
+ *
+ * Finds the size and timestamp range of @input, which gives its average
+ * byte rate. Only done once, on the first seek.
+ *
+ * Returns: %true if the range is known, %false otherwise.
+ */
+static bool
+index_input (VInput *input)
+{
+	VInputPriv *priv = input->priv;
+	int64_t end;
+	
+	
+	if (priv->duration > 0)
+		return true;
+	
+	
+	priv->size = input->get_size (input);
+	
+	if (priv->size <= 0)
+		return false;
+	
+	
+	priv->start_pts = probe_pts (input, 0, false);
+	end = probe_pts (input, priv->size > SEEK_TAIL_SIZE ?
+			priv->size - SEEK_TAIL_SIZE : 0, true);
+	
+	if (priv->start_pts == V_NO_PTS || end == V_NO_PTS)
+		return false;
+	
+	
+	priv->duration = v_clock_pts_diff (end, priv->start_pts);
+	return priv->duration > 0;
+}
+
+
+
+
+/**
+ * v_input_seek:
+ * @input: a #VInput.
+ * @position: the position to move to, in seconds from the start.
+ * @pts: return location for the timestamp of @position.
+ * @error: a #VError, or %NULL.
+ *
+ * Moves @input to shortly before @position, so that reading continues from
+ * the keyframe preceding it. The byte offset is estimated from the average
+ * byte rate, then corrected from the timestamps found where it lands. The
+ * landing is stepped back until the first keyframe after it comes at or
+ * before @position, so the picture at @position can always be decoded.
+ *
+ * Frames already parsed and all codec state are dropped, so the streams
+ * decode from a clean start. Frames before @pts should be discarded by the
+ * caller once decoded.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+bool
+v_input_seek (VInput *input, double position, int64_t *pts, VError *error)
+{
+	VInputPriv *priv = input->priv;
+	
+	VListNode *node;
+	VFrameRaw *frame;
+	
+	int64_t target, want, found, offset, back;
+	double rate;
+	int i;
+	
+	
+	/* needs a seekable source with timestamps */
+	if (input->seek == NULL || input->get_size == NULL || !index_input (input))
+	{
+		v_error_set (error,
+					 V_ERROR_DOMAIN_INPUT,
+					 -ESPIPE,
+					 "input",
+					 "The media source cannot be seeked.");
+		
+		return false;
+	}
+	
+	
+	target = position * PTS_RATE;
+	
+	if (target < 0)
+		target = 0;
+	
+	if (target > priv->duration)
+		target = priv->duration;
+	
+	
+	/* land before the target by the preroll */
+	want = target > SEEK_PREROLL ? target - SEEK_PREROLL : 0;
+	rate = (double) priv->size / priv->duration;
+	offset = want * rate;
+	
+	for (i = 0; i < SEEK_ATTEMPTS && offset > 0; i++)
+	{
+		found = probe_pts (input, offset, false);
+		
+		if (found == V_NO_PTS)
+			break;
+		
+		
+		/* off by this much from where we want to be */
+		found = v_clock_pts_diff (found, priv->start_pts) - want;
+		
+		if (found <= 0 && found > -SEEK_PREROLL)
+			break;
+		
+		offset -= (found + SEEK_PREROLL / 2) * rate;
+		
+		if (offset < 0)
+			offset = 0;
+	}
+	
+	
+	/* decoding restarts at the first keyframe, which must not be past the
+	 * target. Every miss steps back twice as far as the last, until the
+	 * start of the input, which always holds one */
+	for (back = SEEK_PREROLL; offset > 0; back *= 2)
+	{
+		found = probe_keyframe (input, offset);
+		
+		if (found != V_NO_PTS)
+		{
+			found = v_clock_pts_diff (found, priv->start_pts) - target;
+			
+			if (found <= 0)
+				break;
+		}
+		
+		/* no keyframe anywhere near counts as a miss by nothing */
+		else
+			found = 0;
+		
+		offset -= (found + back) * rate;
+		
+		if (offset < 0)
+			offset = 0;
+	}
+	
+	
+	if (offset >= priv->size)
+		offset = priv->size - 1;
+	
+	if (!move_to (input, offset))
+	{
+		v_error_set (error,
+					 V_ERROR_DOMAIN_INPUT,
+					 -EIO,
+					 "input",
+					 "Failed to move the media source position.");
+		
+		return false;
+	}
+	
+	
+	/* drop what was read from the old position */
+	while ((frame = v_queue_dequeue (priv->frames)) != NULL)
+		v_frame_free (V_FRAME (frame));
+	
+	for (node = priv->streams->first; node; node = node->next)
+		v_codec_flush (((VStream *) node->data)->codec);
+	
+	
+	*pts = (priv->start_pts + target) & (PTS_WRAP - 1);
+	return true;
+}
+
+
+
+
+
+
 void
 v_input_register_new_stream (VInput *input, VNewStreamFunc *func, void *userdata)
 {
@@ -416,8 +799,9 @@ void
 v_input_raise_eos (VInput *input)
 {
 	VInputPriv *priv = input->priv;
-	printf ("EOS!\n");
-	//priv->eos_handler (input, priv->eos_userdata);
+	
+	if (priv->eos_handler != NULL)
+		priv->eos_handler (input, priv->eos_userdata);
 }
 
 
@@ -28,6 +28,7 @@
 #include "mem.h"
 #include <errno.h>
 #include <fcntl.h>   /* O_RDONLY */
+#include <sys/stat.h> /* fstat */
 #include <unistd.h>  /* SEEK_CUR */
 #include <string.h>  /* strerror */
 
@@ -148,6 +149,47 @@ v_input_file_open (VInput *input, VError *error)
 
 
 
+/*
+ * v_input_file_seek:
+ * @input: a #VInput.
+ * @offset: the byte offset to move to.
+ *
+ * Moves the file position to @offset.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+static bool
+v_input_file_seek (VInput *input, int64_t offset)
+{
+	VInputFile *self = (VInputFile *) input;
+	return lseek (self->fd, offset, SEEK_SET) == offset;
+}
+
+
+
+/*
+ * v_input_file_get_size:
+ * @input: a #VInput.
+ *
+ * Gets the size of the file.
+ *
+ * Returns: the size in bytes, or -1 if unknown.
+ */
+static int64_t
+v_input_file_get_size (VInput *input)
+{
+	VInputFile *self = (VInputFile *) input;
+	struct stat st;
+	
+	if (fstat (self->fd, &st) < 0)
+		return -1;
+	
+	return st.st_size;
+}
+
+
+
+
 /*
  * v_input_file_close:
  * @input: a #VInput.
@@ -184,6 +226,9 @@ v_input_file_new (void)
 	input->open  = v_input_file_open;
 	input->close = v_input_file_close;
 	
+	input->seek     = v_input_file_seek;
+	input->get_size = v_input_file_get_size;
+	
 	
 	return input;
 }
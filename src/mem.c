@@ -74,6 +74,28 @@ v_realloc (void *ptr, size_t length)
 
 
 
+/**
+ * v_malloc_aligned:
+ * @alignment: the alignment of the memory block, a power of two.
+ *
+ * Creates a new memory block of size @length starting on an @alignment
+ * byte boundary. It is free'd with v_free() like any other block.
+ *
+ * Returns: a pointer to the new memory block, %NULL on failure.
+ */
+void *
+v_malloc_aligned (size_t alignment, size_t length)
+{
+	void *ptr;
+	
+	if (posix_memalign (&ptr, alignment, length) != 0)
+		return NULL;
+	
+	return ptr;
+}
+
+
+
 /**
  * v_free:
  *
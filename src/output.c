@@ -63,6 +63,9 @@ v_output_new (VOutputType output_type, VError *error)
 void
 v_output_free (VOutput *output)
 {
+	if (output->free != NULL)
+		output->free (output);
+	
 	v_free (output);
 }
 
@@ -103,9 +106,9 @@ v_output_open (VOutput *output, VStream *stream)
 /**
  * v_output_close:
  * @output: a #VOutput.
- * @frame: a #VFrame to write.
  *
- * Writes @frame to the output device.
+ * Closes the output device opened with v_output_open(), releasing what
+ * it allocated for the stream.
  */
 void
 v_output_close (VOutput *output)
@@ -115,7 +118,14 @@ v_output_close (VOutput *output)
 
 
 
-
+/**
+ * v_output_write_sub:
+ * @output: a #VOutput.
+ * @frame: a subtitle #VFrame to overlay.
+ *
+ * Sets the subpicture blended over the video. The output keeps its own
+ * copy so @frame still belongs to the caller.
+ */
 void
 v_output_write_sub (VOutput *output, VFrame *frame)
 {
@@ -126,6 +136,161 @@ v_output_write_sub (VOutput *output, VFrame *frame)
 
 
 
+/**
+ * v_output_write_partial:
+ * @output: a #VOutput.
+ * @frame: an audio #VFrame to write.
+ * @offset: the bytes of @frame already written.
+ *
+ * Writes as much of @frame from @offset as the device takes without
+ * blocking, so that the caller can come back for the rest rather than
+ * wait. Devices that can't write partially write all of @frame.
+ *
+ * Returns: the bytes of @frame written so far, its length once done.
+ */
+int
+v_output_write_partial (VOutput *output, VFrame *frame, int offset)
+{
+	if (output->write_partial == NULL)
+	{
+		output->write (output, frame);
+		return V_FRAME_AUDIO (frame)->length;
+	}
+	
+	return output->write_partial (output, frame, offset);
+}
+
+
+
+
+/**
+ * v_output_get_buffer:
+ * @output: a #VOutput.
+ * @data: return location for the YUV420 planes.
+ * @linesize: return location for the size of each plane line.
+ *
+ * Gets the device buffer of the next picture so that it can be written to
+ * directly, after which v_output_present() displays it.
+ *
+ * Returns: %true if the output supports direct writing, %false otherwise.
+ */
+bool
+v_output_get_buffer (VOutput *output, uint8_t *data[4], int linesize[4])
+{
+	if (output->get_buffer == NULL)
+		return false;
+	
+	return output->get_buffer (output, data, linesize);
+}
+
+
+
+
+/**
+ * v_output_present:
+ * @output: a #VOutput.
+ *
+ * Displays the picture written to the buffer from v_output_get_buffer().
+ */
+void
+v_output_present (VOutput *output)
+{
+	output->present (output);
+}
+
+
+
+
+/**
+ * v_output_negotiate_format:
+ * @output: a #VOutput.
+ * @source: the pixel format the decoder produces.
+ *
+ * Picks the pixel format video is written to @output in. The @source
+ * format is kept when the device accepts it so no conversion is needed,
+ * otherwise the device's most preferred format is used. This must be
+ * called before v_output_open().
+ *
+ * Returns: the negotiated #VPixelFormat.
+ */
+VPixelFormat
+v_output_negotiate_format (VOutput *output, VPixelFormat source)
+{
+	const VPixelFormat *formats;
+	VPixelFormat format;
+	int i;
+	
+	
+	/* outputs without a format list only take planar YUV */
+	if (output->get_formats == NULL)
+		return V_PIXEL_FORMAT_YUV420;
+	
+	
+	formats = output->get_formats (output);
+	format = formats[0];
+	
+	for (i = 0; formats[i] != V_PIXEL_FORMAT_UNKNOWN; i++)
+	{
+		if (formats[i] == source)
+		{
+			format = source;
+			break;
+		}
+	}
+	
+	
+	if (output->set_format != NULL && format != V_PIXEL_FORMAT_UNKNOWN)
+		output->set_format (output, format);
+	
+	return format;
+}
+
+
+
+
+
+/**
+ * v_output_get_delay:
+ * @output: a #VOutput.
+ * @delay: return location for the delay in seconds.
+ *
+ * Gets how long until the last sample written to @output is played out,
+ * which tells the position of the device itself rather than what was
+ * handed to it.
+ *
+ * Returns: %true if the output knows its delay, %false otherwise.
+ */
+bool
+v_output_get_delay (VOutput *output, double *delay)
+{
+	if (output->get_delay == NULL)
+		return false;
+	
+	return output->get_delay (output, delay);
+}
+
+
+
+
+
+/**
+ * v_output_flush:
+ * @output: a #VOutput.
+ *
+ * Drops whatever @output buffered but didn't play yet, such as when the
+ * position changes.
+ */
+void
+v_output_flush (VOutput *output)
+{
+	if (output->flush != NULL)
+		output->flush (output);
+}
+
+
+
+
+
 /**
  * v_output_type_string:
  * @id: the codec ID to convert.
@@ -26,6 +26,7 @@
 #include "output.h"
 #include "mem.h"
 #include <alsa/asoundlib.h>
+#include <stdlib.h>  /* getenv */
 
 
 
@@ -48,6 +49,7 @@ struct _VOutputAlsa
 	
 	const char *device;
 	size_t bps;
+	unsigned int rate;
 
 
 	snd_pcm_uframes_t buffer_size;
@@ -61,14 +63,18 @@ struct _VOutputAlsa
 
 
 /*
- * v_output_alsa_write:
+ * v_output_alsa_write_partial:
  * @output: a #VOutput.
  * @frame: a #VFrame to write.
+ * @offset: the bytes of @frame already written.
  *
- * Writes @frame to the ALSA buffer.
+ * Writes as much of @frame to the ALSA buffer as fits without waiting,
+ * the device being opened in non-blocking mode.
+ *
+ * Returns: the bytes of @frame written so far.
  */
-static void
-v_output_alsa_write (VOutput *output, VFrame *frame)
+static int
+v_output_alsa_write_partial (VOutput *output, VFrame *frame, int offset)
 {
 	VOutputAlsa *self  = (VOutputAlsa *) output;
 	VFrameAudio *audio = V_FRAME_AUDIO (frame);
@@ -78,16 +84,66 @@ v_output_alsa_write (VOutput *output, VFrame *frame)
 
 	
 	/* length of samples in frames */
-	int len = audio->length / self->bps;
+	int len = (audio->length - offset) / self->bps;
+	uint8_t *samples = (uint8_t *) audio->samples + offset;
+
+
+	/* large batches may only be partially written */
+	while (len > 0)
+	{
+		/* write to alsa buffer */
+		frames = snd_pcm_writei (self->pcm, samples, len);
+		
+		
+		/* the buffer is full, the rest goes once it drains */
+		if (frames == -EAGAIN)
+			break;
+		
+		
+		/* recover from buffer underrun, giving up if the device can't */
+		if (frames == -EPIPE)
+		{
+			if (snd_pcm_prepare (self->pcm) < 0)
+				return audio->length;
+			
+			continue;
+		}
+		
+		
+		/* unrecoverable error, the samples are dropped */
+		if (frames < 0)
+			return audio->length;
+		
+		
+		samples += frames * self->bps;
+		offset  += frames * self->bps;
+		len -= frames;
+	}
+	
+	
+	return offset;
+}
 
 
-	/* write to alsa buffer */
-	frames = snd_pcm_writei (self->pcm, audio->samples, len);
 
 
-	/* recover from buffer underrun */
-	if (frames == -EPIPE)
-		snd_pcm_prepare (self->pcm);
+/*
+ * v_output_alsa_write:
+ * @output: a #VOutput.
+ * @frame: a #VFrame to write.
+ *
+ * Writes @frame to the ALSA buffer, waiting for room when it is full.
+ */
+static void
+v_output_alsa_write (VOutput *output, VFrame *frame)
+{
+	VOutputAlsa *self = (VOutputAlsa *) output;
+	int offset = 0;
+	
+	
+	while ((offset = v_output_alsa_write_partial (output, frame, offset)) <
+	       V_FRAME_AUDIO (frame)->length)
+		snd_pcm_wait (self->pcm, 1000);
 }
 
 
@@ -125,6 +181,7 @@ v_output_alsa_open (VOutput *output, VStream *stream)
 	/* get the bytes per sample */
 	self->bps = snd_pcm_format_physical_width (SND_PCM_FORMAT_S16) / 8;
 	self->bps *= stream->channels;
+	self->rate = stream->sample_rate;
 
 
 
@@ -140,14 +197,74 @@ v_output_alsa_open (VOutput *output, VStream *stream)
 /*
  * v_output_alsa_close:
  * @output: a #VOutput.
- * @frame: a #VFrame to write.
  *
- * Writes @frame to the ALSA buffer.
+ * Closes the ALSA device, dropping any samples not played yet.
  */
 static void
 v_output_alsa_close (VOutput *output)
 {
+	VOutputAlsa *self = (VOutputAlsa *) output;
+	
+	if (self->pcm == NULL)
+		return;
+	
+	snd_pcm_drop (self->pcm);
+	snd_pcm_close (self->pcm);
+	
+	self->pcm = NULL;
+}
+
+
+
+
+/*
+ * v_output_alsa_get_delay:
+ * @output: a #VOutput.
+ * @delay: return location for the delay in seconds.
+ *
+ * Gets the delay from ALSA, which counts both the samples still in the
+ * buffer and the latency of the hardware behind it.
+ *
+ * Returns: %false if the device isn't running, %true otherwise.
+ */
+static bool
+v_output_alsa_get_delay (VOutput *output, double *delay)
+{
+	VOutputAlsa *self = (VOutputAlsa *) output;
+	snd_pcm_sframes_t frames;
+	
+	
+	if (self->pcm == NULL || self->rate == 0)
+		return false;
+	
+	/* fails on underruns, when the buffer tells nothing */
+	if (snd_pcm_delay (self->pcm, &frames) < 0)
+		return false;
+	
+	
+	*delay = (double) frames / self->rate;
+	return true;
+}
+
+
+
+
+/*
+ * v_output_alsa_flush:
+ * @output: a #VOutput.
+ *
+ * Drops the samples in the ALSA buffer and readies it for new ones.
+ */
+static void
+v_output_alsa_flush (VOutput *output)
+{
+	VOutputAlsa *self = (VOutputAlsa *) output;
+	
+	if (self->pcm == NULL)
+		return;
 	
+	snd_pcm_drop (self->pcm);
+	snd_pcm_prepare (self->pcm);
 }
 
 
@@ -173,9 +290,17 @@ v_output_alsa_new (void)
 	output->open  = v_output_alsa_open;
 	output->close = v_output_alsa_close;
 	
+	output->write_partial = v_output_alsa_write_partial;
+	
+	output->get_delay = v_output_alsa_get_delay;
+	output->flush     = v_output_alsa_flush;
+	
 	
+	/* the device can be swapped, such as for the "null" PCM in testing */
+	ret->device = getenv ("VILLANOVA_ALSA_DEVICE");
 	
-	ret->device = "default";
+	if (ret->device == NULL)
+		ret->device = "default";
 	
 	
 	
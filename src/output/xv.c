@@ -24,6 +24,7 @@
 
 
 #include "output.h"
+#include "compositor.h"
 #include "mem.h"
 #include <string.h>  /* memcpy */
 
@@ -39,7 +40,9 @@
 
 
 #define IMGFMT_YV12 (('2'<<24)|('1'<<16)|('V'<<8)|'Y')
+#define IMGFMT_NV12 (('2'<<24)|('1'<<16)|('V'<<8)|'N')
 #define IMGFMT_YUY2 (('2'<<24)|('Y'<<16)|('U'<<8)|'Y')
+#define IMGFMT_UYVY (('Y'<<24)|('V'<<16)|('Y'<<8)|'U')
 
 
 
@@ -71,7 +74,12 @@ struct _VOutputXv
 	VOutput parent;
 	
 	
-	VFrameSubtitle *subpic;
+	VCompositor *compositor;
+	
+	
+	/* supported formats by preference, zero terminated */
+	VPixelFormat formats[5];
+	VPixelFormat format;
 	
 	
 	/* X11 window stuff */
@@ -94,6 +102,77 @@ struct _VOutputXv
 
 
 
+/*
+ * get_fourcc:
+ * @format: a #VPixelFormat.
+ *
+ * Gets the Xvideo image format id for @format.
+ */
+static int
+get_fourcc (VPixelFormat format)
+{
+	switch (format)
+	{
+		case V_PIXEL_FORMAT_NV12: return IMGFMT_NV12;
+		case V_PIXEL_FORMAT_YUY2: return IMGFMT_YUY2;
+		case V_PIXEL_FORMAT_UYVY: return IMGFMT_UYVY;
+		default:                  return IMGFMT_YV12;
+	}
+}
+
+
+
+
+/*
+ * query_formats:
+ * @self: a #VOutputXv.
+ *
+ * Fills the format list with the image formats the port supports, planar
+ * YUV first since it needs no packing and blends subpictures fastest.
+ */
+static void
+query_formats (VOutputXv *self)
+{
+	static const VPixelFormat preferred[] = {
+		V_PIXEL_FORMAT_YUV420,
+		V_PIXEL_FORMAT_NV12,
+		V_PIXEL_FORMAT_YUY2,
+		V_PIXEL_FORMAT_UYVY,
+	};
+	
+	int count = 0;
+	int i, j, n = 0;
+	
+	XvImageFormatValues *values = XvListImageFormats (self->display, self->port, &count);
+	
+	
+	for (i = 0; i < 4; i++)
+	{
+		for (j = 0; j < count; j++)
+		{
+			if (values[j].id == get_fourcc (preferred[i]))
+			{
+				self->formats[n++] = preferred[i];
+				break;
+			}
+		}
+	}
+	
+	
+	/* assume YV12 if the port doesn't tell */
+	if (n == 0)
+		self->formats[n++] = V_PIXEL_FORMAT_YUV420;
+	
+	self->formats[n] = V_PIXEL_FORMAT_UNKNOWN;
+	
+	
+	if (values != NULL)
+		XFree (values);
+}
+
+
+
+
 /*
  * create_image:
  * @output: a #VOutput.
@@ -104,6 +183,7 @@ struct _VOutputXv
 static XvImage *
 create_image (Display *display,
 		XvPortID port,
+		int fourcc,
 		int width,
 		int height,
 		XShmSegmentInfo *shminfo)
@@ -112,7 +192,7 @@ create_image (Display *display,
 	/* create shared memory image */
 	XvImage *image = XvShmCreateImage (display,
 			port,
-			IMGFMT_YV12,
+			fourcc,
 			0,
 			width,
 			height,
@@ -143,39 +223,29 @@ create_image (Display *display,
 
 
 
+static bool v_output_xv_get_buffer (VOutput *output, uint8_t *data[4], int linesize[4]);
+
+
+
+
 /*
- * v_output_xv_write:
- * @output: a #VOutput.
- * @frame: a #VFrame to write.
+ * put_image:
+ * @self: a #VOutputXv.
  *
- * Writes @frame to the Xvideo image buffer.
+ * Blends the subpicture into the Xvideo image and displays it scaled to
+ * the window.
  */
 static void
-v_output_xv_write (VOutput *output, VFrame *frame)
+put_image (VOutputXv *self)
 {
-	VOutputXv *self = (VOutputXv *) output;
-	VFrameVideo *video = V_FRAME_VIDEO (frame);
-	
-	
-	
-	int height = self->image->height;
-	
+	uint8_t *data[4];
+	int linesize[4];
 	
-	memcpy (self->image->data + self->image->offsets[0], video->data[0], video->linesize[0] * height);
-	memcpy (self->image->data + self->image->offsets[1], video->data[2], video->linesize[2] * (height / 2));
-	memcpy (self->image->data + self->image->offsets[2], video->data[1], video->linesize[1] * (height / 2));
-	
-	
-	
-#if 0
-	if (self->subpic)
-	{
-		memcpy (self->image->data + self->image->offsets[0], self->subpic->data[0], self->subpic->linesize[0] * self->subpic->h);
-		memcpy (self->image->data + self->image->offsets[1], self->subpic->data[2], self->subpic->linesize[2] * (self->subpic->h / 2));
-		memcpy (self->image->data + self->image->offsets[2], self->subpic->data[1], self->subpic->linesize[1] * (self->subpic->h / 2));
-	}
-#endif
 	
+	/* overlay the subpicture on the finished picture */
+	v_output_xv_get_buffer ((VOutput *) self, data, linesize);
+	v_compositor_blend (self->compositor, self->format, data, linesize,
+			self->image->width, self->image->height);
 	
 	
 	Window root;
@@ -213,12 +283,152 @@ v_output_xv_write (VOutput *output, VFrame *frame)
 
 
 
+/*
+ * v_output_xv_write:
+ * @output: a #VOutput.
+ * @frame: a #VFrame to write.
+ *
+ * Writes @frame to the Xvideo image buffer.
+ */
+static void
+v_output_xv_write (VOutput *output, VFrame *frame)
+{
+	VOutputXv *self = (VOutputXv *) output;
+	VFrameVideo *video = V_FRAME_VIDEO (frame);
+	
+	uint8_t *data[4];
+	int linesize[4];
+	int plane, bytes, lines, row;
+	
+	
+	v_output_xv_get_buffer (output, data, linesize);
+	
+	
+	/* copy line by line since the image pitch can differ */
+	for (plane = 0; v_pixel_format_get_plane (self->format, plane,
+			self->image->width, self->image->height, &bytes, &lines); plane++)
+	{
+		for (row = 0; row < lines; row++)
+			memcpy (data[plane] + row * linesize[plane],
+					video->data[plane] + row * video->linesize[plane],
+					bytes);
+	}
+	
+	
+	put_image (self);
+}
+
+
+
+
+/*
+ * v_output_xv_get_buffer:
+ * @output: a #VOutput.
+ * @data: return location for the YUV420 planes.
+ * @linesize: return location for the size of each plane line.
+ *
+ * Gets the planes of the shared memory image in the negotiated format.
+ * YV12 stores the V plane before the U plane so they are swapped into
+ * YUV420 order.
+ */
+static bool
+v_output_xv_get_buffer (VOutput *output, uint8_t *data[4], int linesize[4])
+{
+	VOutputXv *self = (VOutputXv *) output;
+	uint8_t *image = (uint8_t *) self->image->data;
+	int i;
+	
+	
+	for (i = 0; i < 4; i++)
+	{
+		data[i] = i < self->image->num_planes ? image + self->image->offsets[i] : NULL;
+		linesize[i] = i < self->image->num_planes ? self->image->pitches[i] : 0;
+	}
+	
+	
+	if (self->format == V_PIXEL_FORMAT_YUV420)
+	{
+		data[1] = image + self->image->offsets[2];
+		data[2] = image + self->image->offsets[1];
+		
+		linesize[1] = self->image->pitches[2];
+		linesize[2] = self->image->pitches[1];
+	}
+	
+	
+	return true;
+}
+
+
+
+
+/*
+ * v_output_xv_present:
+ * @output: a #VOutput.
+ *
+ * Displays the shared memory image.
+ */
+static void
+v_output_xv_present (VOutput *output)
+{
+	put_image ((VOutputXv *) output);
+}
+
+
+
+
+
+/*
+ * v_output_xv_get_formats:
+ * @output: a #VOutput.
+ *
+ * Gets the image formats supported by the Xvideo port.
+ */
+static const VPixelFormat *
+v_output_xv_get_formats (VOutput *output)
+{
+	return ((VOutputXv *) output)->formats;
+}
+
+
+
+
+/*
+ * v_output_xv_set_format:
+ * @output: a #VOutput.
+ * @format: the #VPixelFormat to display.
+ *
+ * Sets the image format used when the output is opened.
+ */
+static bool
+v_output_xv_set_format (VOutput *output, VPixelFormat format)
+{
+	VOutputXv *self = (VOutputXv *) output;
+	int i;
+	
+	for (i = 0; self->formats[i] != V_PIXEL_FORMAT_UNKNOWN; i++)
+	{
+		if (self->formats[i] == format)
+		{
+			self->format = format;
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+
+
+
 
 static void
 v_output_xv_write_sub (VOutput *output, VFrame *frame)
 {
 	VOutputXv *self = (VOutputXv *) output;
-	self->subpic = V_FRAME_SUBTITLE (frame);
+	
+	/* the compositor keeps its own converted copy */
+	v_compositor_set_subpicture (self->compositor, V_FRAME_SUBTITLE (frame));
 }
 
 
@@ -241,6 +451,7 @@ v_output_xv_open (VOutput *output, VStream *stream)
 	/* create the shared video image */
 	self->image = create_image (self->display,
 			self->port,
+			get_fourcc (self->format),
 			stream->width,
 			stream->height,
 			&self->shminfo);
@@ -270,14 +481,62 @@ v_output_xv_open (VOutput *output, VStream *stream)
 /*
  * v_output_xv_close:
  * @output: a #VOutput.
- * @frame: a #VFrame to write.
  *
- * Writes @frame to the ALSA buffer.
+ * Destroys the window and the shared video image of the stream, and drops
+ * the subpicture overlay.
  */
 static void
 v_output_xv_close (VOutput *output)
 {
+	VOutputXv *self = (VOutputXv *) output;
+	
+	
+	if (self->image != NULL)
+	{
+		XShmDetach (self->display, &self->shminfo);
+		XFree (self->image);
+		
+		/* the segment was marked for removal once attached */
+		shmdt (self->shminfo.shmaddr);
+		self->image = NULL;
+	}
 	
+	if (self->gc != NULL)
+	{
+		XFreeGC (self->display, self->gc);
+		self->gc = NULL;
+	}
+	
+	if (self->window != 0)
+	{
+		XDestroyWindow (self->display, self->window);
+		self->window = 0;
+	}
+	
+	/* the subpicture belonged to the closed title */
+	v_compositor_set_subpicture (self->compositor, NULL);
+	
+	
+	XSync (self->display, False);
+}
+
+
+
+/*
+ * v_output_xv_free:
+ * @output: a #VOutput.
+ *
+ * Closes the display connection.
+ */
+static void
+v_output_xv_free (VOutput *output)
+{
+	VOutputXv *self = (VOutputXv *) output;
+	
+	v_output_xv_close (output);
+	
+	v_compositor_free (self->compositor);
+	XCloseDisplay (self->display);
 }
 
 
@@ -304,6 +563,8 @@ v_output_xv_new (void)
 	ret->window = 0;
 	ret->display = XOpenDisplay (NULL);
 	ret->gc = NULL;
+	ret->image = NULL;
+	ret->compositor = v_compositor_new ();
 
 
 	/* get the default adaptor port */
@@ -322,14 +583,25 @@ v_output_xv_new (void)
 	XvFreeAdaptorInfo(adaptors);
 	
 	
+	query_formats (ret);
+	ret->format = ret->formats[0];
+	
+	
 	
 	/* set interface methods */
 	output->write = v_output_xv_write;
 	output->open  = v_output_xv_open;
 	output->close = v_output_xv_close;
+	output->free  = v_output_xv_free;
 	
 	output->write_sub = v_output_xv_write_sub;
 	
+	output->get_buffer = v_output_xv_get_buffer;
+	output->present    = v_output_xv_present;
+	
+	output->get_formats = v_output_xv_get_formats;
+	output->set_format  = v_output_xv_set_format;
+	
 	
 	return output;
 }
@@ -0,0 +1,1543 @@
+/***************************************************************************
+ *            pipeline.c
+ *
+ *  Oct 19, 2026 7:19:18 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "pipeline.h"
+#include "mem.h"
+#include "list.h"
+#include "ring.h"
+#include "thread-pool.h"
+#include <pthread.h>
+#include <string.h>  /* strcmp */
+#include <time.h>    /* clock_gettime */
+
+
+
+/* the most calls a node gets before letting other tasks run */
+#define NODE_QUANTUM 8
+
+/* frames delivered on an adaptive link between depth changes */
+#define ADAPT_WINDOW 64
+
+
+
+typedef struct _Link Link;
+
+
+
+/*
+ * Link:
+ * @src: the node producing frames.
+ * @dest: the node consuming frames.
+ * @ring: the queue between both nodes.
+ * @held: frames emitted while @ring was full, in order.
+ * @eos: whether @src has ended and queued its last frame on @ring.
+ * @min_depth: the smallest depth @ring adapts to.
+ * @max_depth: the largest depth @ring adapts to.
+ *
+ * A bounded queue connecting two nodes. Each node only runs on one thread
+ * at a time, so every ring has exactly one producer and one consumer.
+ * Besides the consumer timing its waits, only the producer touches the
+ * rest.
+ */
+struct _Link
+{
+	VNode *src;
+	VNode *dest;
+	
+	VRing *ring;
+	VList *held;
+	
+	int eos;
+	
+	
+	unsigned int min_depth;
+	unsigned int max_depth;
+	
+	/* the frames, highest occupancy and stalls since the last change */
+	unsigned int window;
+	unsigned int peak;
+	unsigned int window_stalls;
+	
+	/* when frames started being held, or the consumer found none */
+	double held_since;
+	double empty_since;
+	
+	VLinkStats stats;
+};
+
+
+
+/*
+ * VNodePriv:
+ *
+ * Private structure for #VNode.
+ */
+struct _VNodePriv
+{
+	VPipeline *pipeline;
+	
+	VSourceFunc *source;
+	VNodeFunc *func;
+	void *data;
+	
+	
+	/* links to and from other nodes */
+	VList *inputs;
+	VList *outputs;
+	VListNode *next_input;
+	
+	/* frames taken off the inputs per call */
+	VFrame **frames;
+	
+	
+	/* whether the node is queued or running */
+	int scheduled;
+	
+	/* whether the node waits for room on an output */
+	int stalled;
+	
+	/* whether the node has nothing left to produce */
+	bool finished;
+	
+	/* whether the end of stream was passed on */
+	bool ended;
+	
+	
+	/* whether the node put off its work until @wake_at */
+	bool waiting;
+	double wake_at;
+	
+	/* whether the timer holds the node, and when it fires */
+	int armed;
+	double timer_at;
+	
+	
+	/* only written by the running node */
+	VNodeStats stats;
+};
+
+
+
+/*
+ * VPipelinePriv:
+ *
+ * Private structure for #VPipeline.
+ */
+struct _VPipelinePriv
+{
+	VList *nodes;
+	
+	/* node runs queued or in progress */
+	int active;
+	int paused;
+	
+	pthread_mutex_t mutex;
+	pthread_cond_t  idle;
+	
+	
+	/* nodes yet to reach the end of stream */
+	int remaining;
+	
+	VPipelineFunc *eos_func;
+	void *eos_data;
+};
+
+
+
+
+/* spreads nodes over the workers by default */
+static int next_hint = 0;
+
+
+/* wakes waiting nodes of every pipeline on time */
+static pthread_once_t timer_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timer_cond;
+static VList *timer_nodes;
+
+
+
+static void run_node (void *data);
+
+
+
+
+/*
+ * schedule_node:
+ * @node: a #VNode.
+ *
+ * Queues @node on the default thread pool unless it is already queued or
+ * running.
+ */
+static void
+schedule_node (VNode *node)
+{
+	VPipelinePriv *priv = node->priv->pipeline->priv;
+	
+	if (__sync_bool_compare_and_swap (&node->priv->scheduled, 0, 1))
+	{
+		pthread_mutex_lock (&priv->mutex);
+		priv->active++;
+		pthread_mutex_unlock (&priv->mutex);
+		
+		v_thread_pool_push_to (v_thread_pool_get_default (),
+				node->hint, run_node, node);
+	}
+}
+
+
+
+/*
+ * idle_node:
+ * @node: the running #VNode.
+ *
+ * Ends the current run of @node. Any check for more work must come after
+ * this, so that work added in between either finds the node idle and
+ * queues it, or is seen by the check.
+ */
+static void
+idle_node (VNode *node)
+{
+	__atomic_store_n (&node->priv->scheduled, 0, __ATOMIC_SEQ_CST);
+}
+
+
+
+/*
+ * get_time:
+ *
+ * Returns: the monotonic time in seconds.
+ */
+static double
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+
+/*
+ * run_timer:
+ * @data: unused.
+ *
+ * Queues each node on the timer once its time comes, sleeping until the
+ * earliest one in between. Nodes are queued with the timer locked, so
+ * v_pipeline_pause() can take them off for good.
+ */
+static void *
+run_timer (void *data)
+{
+	struct timespec ts;
+	VListNode *iter, *next;
+	
+	
+	pthread_mutex_lock (&timer_mutex);
+	
+	while (true)
+	{
+		double now = get_time ();
+		double earliest = 0;
+		
+		
+		for (iter = timer_nodes->first; iter; iter = next)
+		{
+			VNode *node = (VNode *) iter->data;
+			next = iter->next;
+			
+			if (node->priv->timer_at <= now)
+			{
+				v_list_remove (timer_nodes, iter);
+				
+				/* disarm first, a node going idle checks the flag after */
+				__atomic_store_n (&node->priv->armed, 0, __ATOMIC_SEQ_CST);
+				schedule_node (node);
+			}
+			
+			else if (earliest == 0 || node->priv->timer_at < earliest)
+				earliest = node->priv->timer_at;
+		}
+		
+		
+		if (earliest == 0)
+			pthread_cond_wait (&timer_cond, &timer_mutex);
+		
+		else
+		{
+			ts.tv_sec  = (time_t) earliest;
+			ts.tv_nsec = (long) ((earliest - ts.tv_sec) * 1000000000.0);
+			
+			pthread_cond_timedwait (&timer_cond, &timer_mutex, &ts);
+		}
+	}
+	
+	
+	return NULL;
+}
+
+
+
+/*
+ * start_timer:
+ *
+ * Starts the timer thread shared by every pipeline.
+ */
+static void
+start_timer (void)
+{
+	pthread_condattr_t attr;
+	pthread_t thread;
+	
+	
+	pthread_condattr_init (&attr);
+	pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+	pthread_cond_init (&timer_cond, &attr);
+	pthread_condattr_destroy (&attr);
+	
+	timer_nodes = v_list_new ();
+	
+	pthread_create (&thread, NULL, run_timer, NULL);
+	pthread_detach (thread);
+}
+
+
+
+/*
+ * sleep_node:
+ * @node: the running #VNode, waiting for a time still to come.
+ *
+ * Ends the current run of @node and hands it to the timer, which queues
+ * it again once its time comes. No worker is held meanwhile. A paused
+ * pipeline keeps the wait for when it is started again instead.
+ */
+static void
+sleep_node (VNode *node)
+{
+	VNodePriv *priv = node->priv;
+	
+	
+	pthread_once (&timer_once, start_timer);
+	
+	pthread_mutex_lock (&timer_mutex);
+	
+	if (!__atomic_load_n (&priv->pipeline->priv->paused, __ATOMIC_SEQ_CST))
+	{
+		priv->timer_at = priv->wake_at;
+		
+		if (!priv->armed)
+		{
+			__atomic_store_n (&priv->armed, 1, __ATOMIC_SEQ_CST);
+			v_list_append (timer_nodes, node);
+		}
+		
+		pthread_cond_signal (&timer_cond);
+	}
+	
+	pthread_mutex_unlock (&timer_mutex);
+	
+	
+	idle_node (node);
+	
+	/* the timer may have fired before the node went idle */
+	if (!__atomic_load_n (&priv->armed, __ATOMIC_SEQ_CST))
+		schedule_node (node);
+}
+
+
+
+/*
+ * cancel_timers:
+ * @pipeline: a #VPipeline being paused.
+ *
+ * Takes the nodes of @pipeline off the timer, so that it can't queue them
+ * once the pipeline stopped.
+ */
+static void
+cancel_timers (VPipeline *pipeline)
+{
+	VListNode *iter, *next;
+	
+	
+	pthread_once (&timer_once, start_timer);
+	
+	pthread_mutex_lock (&timer_mutex);
+	
+	for (iter = timer_nodes->first; iter; iter = next)
+	{
+		VNode *node = (VNode *) iter->data;
+		next = iter->next;
+		
+		if (node->priv->pipeline == pipeline)
+		{
+			v_list_remove (timer_nodes, iter);
+			__atomic_store_n (&node->priv->armed, 0, __ATOMIC_SEQ_CST);
+		}
+	}
+	
+	pthread_mutex_unlock (&timer_mutex);
+}
+
+
+
+
+/*
+ * adapt_depth:
+ * @link: an adaptive #Link.
+ *
+ * Resizes the ring of @link at the end of a window. A producer that had
+ * to hold frames back means bursts outgrow the ring, so it doubles, while
+ * a ring never more than a quarter full is halved to free the frames it
+ * would hold.
+ */
+static void
+adapt_depth (Link *link)
+{
+	unsigned int size = link->ring->size;
+	
+	
+	if (link->window_stalls > 0)
+		size = size * 2 < link->max_depth ? size * 2 : link->max_depth;
+	
+	else if (link->peak * 4 <= size)
+		size = size / 2 > link->min_depth ? size / 2 : link->min_depth;
+	
+	v_ring_set_size (link->ring, size);
+	
+	
+	link->stats.depth = link->ring->size;
+	
+	link->window = 0;
+	link->peak = 0;
+	link->window_stalls = 0;
+}
+
+
+
+/*
+ * deliver:
+ * @link: a #Link.
+ * @frame: the frame to queue.
+ *
+ * Queues @frame on @link, holding it back when the ring is full or older
+ * frames are still held. The occupancy each frame finds is recorded.
+ */
+static void
+deliver (Link *link, VFrame *frame)
+{
+	unsigned int size = link->ring->size;
+	unsigned int length = v_ring_length (link->ring);
+	
+	
+	if (length > size)
+		length = size;
+	
+	link->stats.frames++;
+	link->stats.histogram[length * (V_LINK_HISTOGRAM - 1) / size]++;
+	
+	if (length > link->peak)
+		link->peak = length;
+	
+	
+	if (link->held->length == 0 && v_ring_push (link->ring, frame))
+		schedule_node (link->dest);
+	
+	else
+	{
+		/* the producer is blocked until the ring has room */
+		if (link->held->length == 0)
+		{
+			link->held_since = get_time ();
+			link->stats.stalls++;
+			link->window_stalls++;
+		}
+		
+		v_list_append (link->held, frame);
+	}
+	
+	
+	if (link->min_depth < link->max_depth && ++link->window == ADAPT_WINDOW)
+		adapt_depth (link);
+}
+
+
+
+/*
+ * flush_outputs:
+ * @node: a #VNode.
+ *
+ * Moves held frames onto the output rings of @node.
+ *
+ * Returns: %true if no frames are held anymore, %false otherwise.
+ */
+static bool
+flush_outputs (VNode *node)
+{
+	VListNode *iter;
+	bool flushed = true;
+	
+	
+	for (iter = node->priv->outputs->first; iter; iter = iter->next)
+	{
+		Link *link = (Link *) iter->data;
+		bool pushed = false;
+		
+		while (link->held->first != NULL)
+		{
+			if (!v_ring_push (link->ring, link->held->first->data))
+				break;
+			
+			v_list_remove (link->held, link->held->first);
+			pushed = true;
+		}
+		
+		if (pushed)
+			schedule_node (link->dest);
+		
+		if (link->held->length > 0)
+			flushed = false;
+		
+		else if (pushed)
+			link->stats.producer_blocked += get_time () - link->held_since;
+	}
+	
+	
+	return flushed;
+}
+
+
+
+/*
+ * stall_node:
+ * @node: the running #VNode.
+ *
+ * Ends the current run of @node until a node it holds frames for takes
+ * some off its ring.
+ */
+static void
+stall_node (VNode *node)
+{
+	VNodePriv *priv = node->priv;
+	VListNode *iter;
+	
+	VRing *blocked[priv->outputs->length];
+	int i, count = 0;
+	
+	
+	/* the node may run elsewhere once idle, so note the outputs first */
+	for (iter = priv->outputs->first; iter; iter = iter->next)
+	{
+		Link *link = (Link *) iter->data;
+		
+		if (link->held->length > 0)
+			blocked[count++] = link->ring;
+	}
+	
+	
+	__atomic_store_n (&priv->stalled, 1, __ATOMIC_SEQ_CST);
+	idle_node (node);
+	
+	/* room may have been made before the flag was seen */
+	for (i = 0; i < count; i++)
+	{
+		if (v_ring_length (blocked[i]) < blocked[i]->size)
+		{
+			schedule_node (node);
+			return;
+		}
+	}
+}
+
+
+
+
+/*
+ * take_frames:
+ * @node: a #VNode.
+ *
+ * Takes up to a batch of frames off the next input with any waiting,
+ * restarting its producer if it stalled on the ring.
+ *
+ * Returns: the amount of frames taken.
+ */
+static unsigned int
+take_frames (VNode *node)
+{
+	VNodePriv *priv = node->priv;
+	unsigned int i, count;
+	
+	
+	for (i = 0; i < priv->inputs->length; i++)
+	{
+		Link *link;
+		
+		if (priv->next_input == NULL)
+			priv->next_input = priv->inputs->first;
+		
+		link = (Link *) priv->next_input->data;
+		priv->next_input = priv->next_input->next;
+		
+		
+		count = v_ring_pop_many (link->ring, (void **) priv->frames, node->batch);
+		
+		if (count > 0)
+		{
+			if (__atomic_load_n (&link->src->priv->stalled, __ATOMIC_SEQ_CST))
+				schedule_node (link->src);
+			
+			/* the wait for frames is over */
+			if (link->empty_since != 0)
+			{
+				link->stats.consumer_blocked += get_time () - link->empty_since;
+				link->empty_since = 0;
+			}
+			
+			return count;
+		}
+		
+		if (link->empty_since == 0)
+			link->empty_since = get_time ();
+	}
+	
+	
+	return 0;
+}
+
+
+
+/*
+ * inputs_ended:
+ * @node: a #VNode.
+ *
+ * Returns: %true if every node feeding @node has ended and all of their
+ * frames were taken.
+ */
+static bool
+inputs_ended (VNode *node)
+{
+	VListNode *iter;
+	
+	for (iter = node->priv->inputs->first; iter; iter = iter->next)
+	{
+		Link *link = (Link *) iter->data;
+		
+		/* the flag is set after the last frame was pushed */
+		if (!__atomic_load_n (&link->eos, __ATOMIC_SEQ_CST) ||
+		    v_ring_length (link->ring) > 0)
+			return false;
+	}
+	
+	return true;
+}
+
+
+
+/*
+ * end_node:
+ * @node: a finished #VNode with no frames held.
+ *
+ * Passes the end of stream on to the nodes fed by @node. Once every node
+ * of the pipeline has ended its EOS callback is called.
+ */
+static void
+end_node (VNode *node)
+{
+	VPipelinePriv *priv = node->priv->pipeline->priv;
+	VListNode *iter;
+	
+	
+	if (node->priv->ended)
+		return;
+	
+	node->priv->ended = true;
+	
+	for (iter = node->priv->outputs->first; iter; iter = iter->next)
+	{
+		Link *link = (Link *) iter->data;
+		
+		__atomic_store_n (&link->eos, 1, __ATOMIC_SEQ_CST);
+		schedule_node (link->dest);
+	}
+	
+	
+	if (__sync_sub_and_fetch (&priv->remaining, 1) == 0 && priv->eos_func)
+		priv->eos_func (node->priv->pipeline, priv->eos_data);
+}
+
+
+
+/*
+ * inputs_waiting:
+ * @node: a #VNode.
+ *
+ * Returns: %true if any input of @node has frames waiting.
+ */
+static bool
+inputs_waiting (VNode *node)
+{
+	VListNode *iter;
+	
+	for (iter = node->priv->inputs->first; iter; iter = iter->next)
+		if (v_ring_length (((Link *) iter->data)->ring) > 0)
+			return true;
+	
+	return false;
+}
+
+
+
+
+/*
+ * process_node:
+ * @node: a #VNode.
+ *
+ * Runs @node for a bounded amount of calls. Frames the node emitted
+ * without room on an output are flushed first, and the node stops until
+ * that room is made. A node that put off its work takes no frames until
+ * its time comes and it is called back. A finished node passes the end of
+ * stream on once its last frames are out.
+ */
+static void
+process_node (VNode *node)
+{
+	VNodePriv *priv = node->priv;
+	
+	unsigned int count;
+	double start;
+	int i;
+	
+	
+	__atomic_store_n (&priv->stalled, 0, __ATOMIC_SEQ_CST);
+	
+	
+	for (i = 0; ; i++)
+	{
+		if (!flush_outputs (node))
+		{
+			stall_node (node);
+			return;
+		}
+		
+		if (priv->finished)
+		{
+			end_node (node);
+			idle_node (node);
+			return;
+		}
+		
+		if (priv->waiting && get_time () < priv->wake_at)
+		{
+			sleep_node (node);
+			return;
+		}
+		
+		if (i == NODE_QUANTUM)
+			break;
+		
+		
+		/* carry on with the work put off */
+		if (priv->waiting)
+		{
+			priv->waiting = false;
+			start = get_time ();
+			
+			if (priv->source != NULL)
+			{
+				if (!priv->source (node, priv->data))
+					priv->finished = true;
+			}
+			
+			else
+				priv->func (node, priv->frames, 0, priv->data);
+		}
+		
+		/* produce frames */
+		else if (priv->source != NULL)
+		{
+			start = get_time ();
+			
+			if (!priv->source (node, priv->data))
+				priv->finished = true;
+		}
+		
+		/* process frames */
+		else
+		{
+			count = take_frames (node);
+			
+			if (count == 0)
+			{
+				/* nothing more will arrive */
+				if (inputs_ended (node))
+				{
+					priv->finished = true;
+					continue;
+				}
+				
+				break;
+			}
+			
+			start = get_time ();
+			priv->func (node, priv->frames, count, priv->data);
+			
+			priv->stats.frames_in += count;
+		}
+		
+		
+		priv->stats.calls++;
+		priv->stats.busy += get_time () - start;
+	}
+	
+	
+	/* let other tasks run before going on */
+	idle_node (node);
+	
+	if (priv->source != NULL || priv->waiting ||
+	    inputs_waiting (node) || inputs_ended (node))
+		schedule_node (node);
+}
+
+
+
+/*
+ * run_node:
+ * @data: a #VNode.
+ *
+ * Runs @node on a worker thread, unless the pipeline is paused in which
+ * case the node goes idle until it is started again.
+ */
+static void
+run_node (void *data)
+{
+	VNode *node = (VNode *) data;
+	VPipelinePriv *priv = node->priv->pipeline->priv;
+	
+	
+	if (__atomic_load_n (&priv->paused, __ATOMIC_SEQ_CST))
+		idle_node (node);
+	
+	else
+		process_node (node);
+	
+	
+	/* the node is done with the pipeline until queued again. A waiting
+	 * v_pipeline_pause() only sees the count drop once the mutex is
+	 * released, so the pipeline may be freed right after */
+	pthread_mutex_lock (&priv->mutex);
+	
+	if (--priv->active == 0)
+		pthread_cond_broadcast (&priv->idle);
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+
+/**
+ * v_pipeline_new:
+ *
+ * Creates a new empty #VPipeline.
+ *
+ * Returns: a #VPipeline structure.
+ */
+VPipeline *
+v_pipeline_new (void)
+{
+	VPipeline *ret = v_new (VPipeline);
+	VPipelinePriv *priv = v_new (VPipelinePriv);
+	
+	priv->nodes = v_list_new ();
+	
+	/* nothing runs until started */
+	priv->paused = 1;
+	
+	pthread_mutex_init (&priv->mutex, NULL);
+	pthread_cond_init  (&priv->idle,  NULL);
+	
+	ret->priv = priv;
+	return ret;
+}
+
+
+
+/*
+ * free_link:
+ * @link: a #Link.
+ *
+ * Frees @link along with the frames still queued on it.
+ */
+static void
+free_link (Link *link)
+{
+	VFrame *frame;
+	VListNode *iter;
+	
+	
+	while ((frame = v_ring_pop (link->ring)) != NULL)
+		v_frame_free (frame);
+	
+	for (iter = link->held->first; iter; iter = iter->next)
+		v_frame_free ((VFrame *) iter->data);
+	
+	
+	v_ring_free (link->ring);
+	v_list_free (link->held);
+	v_free (link);
+}
+
+
+
+/**
+ * v_pipeline_free:
+ * @pipeline: a #VPipeline to free.
+ *
+ * Destroys @pipeline, its nodes and any frames still queued between them.
+ * Nodes still running are waited for first, so no task outlives it.
+ */
+void
+v_pipeline_free (VPipeline *pipeline)
+{
+	VListNode *iter;
+	VListNode *link;
+	
+	
+	v_pipeline_pause (pipeline);
+	
+	for (iter = pipeline->priv->nodes->first; iter; iter = iter->next)
+	{
+		VNode *node = (VNode *) iter->data;
+		
+		/* each link is freed by the node it starts from */
+		for (link = node->priv->outputs->first; link; link = link->next)
+			free_link ((Link *) link->data);
+		
+		v_list_free (node->priv->inputs);
+		v_list_free (node->priv->outputs);
+		
+		v_free (node->priv->frames);
+		v_free (node->priv);
+		v_free (node);
+	}
+	
+	
+	v_list_free (pipeline->priv->nodes);
+	
+	pthread_mutex_destroy (&pipeline->priv->mutex);
+	pthread_cond_destroy  (&pipeline->priv->idle);
+	
+	v_free (pipeline->priv);
+	v_free (pipeline);
+}
+
+
+
+
+/*
+ * add_node:
+ * @pipeline: a #VPipeline.
+ * @name: the name of the node.
+ *
+ * Creates a node without any links and adds it to @pipeline.
+ *
+ * Returns: the new #VNode.
+ */
+static VNode *
+add_node (VPipeline *pipeline, const char *name)
+{
+	VNode *ret = v_new (VNode);
+	VNodePriv *priv = v_new (VNodePriv);
+	
+	
+	ret->name = name;
+	ret->hint = __sync_fetch_and_add (&next_hint, 1);
+	ret->batch = 1;
+	
+	priv->pipeline = pipeline;
+	priv->inputs = v_list_new ();
+	priv->outputs = v_list_new ();
+	priv->frames = v_malloc (sizeof (VFrame *));
+	
+	ret->priv = priv;
+	
+	
+	v_list_append (pipeline->priv->nodes, ret);
+	pipeline->priv->remaining++;
+	
+	return ret;
+}
+
+
+
+/**
+ * v_pipeline_add_source:
+ * @pipeline: a #VPipeline.
+ * @name: the name of the node, which must stay valid with the node.
+ * @func: the #VSourceFunc producing frames.
+ * @data: user data to pass to @func.
+ *
+ * Adds a node producing frames to @pipeline. Sources start running with
+ * v_pipeline_start() and keep running until @func returns %false.
+ *
+ * Returns: the new #VNode.
+ */
+VNode *
+v_pipeline_add_source (VPipeline   *pipeline,
+                       const char  *name,
+                       VSourceFunc *func,
+                       void        *data)
+{
+	VNode *ret = add_node (pipeline, name);
+	
+	ret->priv->source = func;
+	ret->priv->data = data;
+	
+	return ret;
+}
+
+
+
+/**
+ * v_pipeline_add_node:
+ * @pipeline: a #VPipeline.
+ * @name: the name of the node, which must stay valid with the node.
+ * @func: the #VNodeFunc processing frames.
+ * @data: user data to pass to @func.
+ *
+ * Adds a node processing frames to @pipeline. The node runs whenever
+ * frames arrive on one of its inputs.
+ *
+ * Returns: the new #VNode.
+ */
+VNode *
+v_pipeline_add_node (VPipeline  *pipeline,
+                     const char *name,
+                     VNodeFunc  *func,
+                     void       *data)
+{
+	VNode *ret = add_node (pipeline, name);
+	
+	ret->priv->func = func;
+	ret->priv->data = data;
+	
+	return ret;
+}
+
+
+
+/**
+ * v_pipeline_get_node:
+ * @pipeline: a #VPipeline.
+ * @name: the name of the node.
+ *
+ * Finds a node by name, for instance to link another sink to it.
+ *
+ * Returns: the #VNode called @name, %NULL if there is none.
+ */
+VNode *
+v_pipeline_get_node (VPipeline *pipeline, const char *name)
+{
+	VListNode *iter;
+	
+	for (iter = pipeline->priv->nodes->first; iter; iter = iter->next)
+	{
+		VNode *node = (VNode *) iter->data;
+		
+		if (strcmp (node->name, name) == 0)
+			return node;
+	}
+	
+	return NULL;
+}
+
+
+
+
+/**
+ * v_pipeline_start:
+ * @pipeline: a #VPipeline.
+ *
+ * Starts the sources of @pipeline, or resumes it after v_pipeline_pause().
+ * The other nodes are queued as frames reach them.
+ */
+void
+v_pipeline_start (VPipeline *pipeline)
+{
+	VListNode *iter;
+	
+	
+	__atomic_store_n (&pipeline->priv->paused, 0, __ATOMIC_SEQ_CST);
+	
+	for (iter = pipeline->priv->nodes->first; iter; iter = iter->next)
+	{
+		VNode *node = (VNode *) iter->data;
+		
+		if (node->priv->source != NULL || node->priv->waiting ||
+		    inputs_waiting (node) || inputs_ended (node))
+			schedule_node (node);
+	}
+}
+
+
+
+/**
+ * v_pipeline_pause:
+ * @pipeline: a #VPipeline.
+ *
+ * Stops @pipeline from running any node, waiting for the nodes already
+ * running to return. Queued frames are kept until v_pipeline_start()
+ * resumes the pipeline, or v_pipeline_flush() drops them. Nodes waiting
+ * after v_node_wait() are called back as soon as the pipeline starts.
+ */
+void
+v_pipeline_pause (VPipeline *pipeline)
+{
+	VPipelinePriv *priv = pipeline->priv;
+	VListNode *iter;
+	VListNode *link;
+	
+	
+	__atomic_store_n (&priv->paused, 1, __ATOMIC_SEQ_CST);
+	
+	/* waiting nodes hold no worker, so there is nothing to wait out */
+	cancel_timers (pipeline);
+	
+	pthread_mutex_lock (&priv->mutex);
+	
+	while (priv->active > 0)
+		pthread_cond_wait (&priv->idle, &priv->mutex);
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	/* the time waited for has gone by the time playback resumes, and no
+	 * consumer is blocked on frames while paused */
+	for (iter = priv->nodes->first; iter; iter = iter->next)
+	{
+		VNode *node = (VNode *) iter->data;
+		
+		node->priv->wake_at = 0;
+		
+		for (link = node->priv->outputs->first; link; link = link->next)
+			((Link *) link->data)->empty_since = 0;
+	}
+}
+
+
+
+/**
+ * v_pipeline_flush:
+ * @pipeline: a paused #VPipeline.
+ *
+ * Frees every frame queued between the nodes of @pipeline, and lets the
+ * sources produce frames again once started. Used when the position of
+ * the input changes, which also takes back any end of stream.
+ */
+void
+v_pipeline_flush (VPipeline *pipeline)
+{
+	VListNode *iter;
+	VListNode *link;
+	VListNode *held;
+	
+	
+	for (iter = pipeline->priv->nodes->first; iter; iter = iter->next)
+	{
+		VNode *node = (VNode *) iter->data;
+		
+		for (link = node->priv->outputs->first; link; link = link->next)
+		{
+			Link *l = (Link *) link->data;
+			VFrame *frame;
+			
+			while ((frame = v_ring_pop (l->ring)) != NULL)
+				v_frame_free (frame);
+			
+			while ((held = l->held->first) != NULL)
+			{
+				v_frame_free ((VFrame *) held->data);
+				v_list_remove (l->held, held);
+			}
+			
+			l->eos = 0;
+			l->empty_since = 0;
+		}
+		
+		node->priv->stalled = 0;
+		node->priv->finished = false;
+		node->priv->ended = false;
+		node->priv->waiting = false;
+	}
+	
+	
+	pipeline->priv->remaining = pipeline->priv->nodes->length;
+}
+
+
+
+/**
+ * v_pipeline_set_eos_func:
+ * @pipeline: a #VPipeline.
+ * @func: the #VPipelineFunc to call, or %NULL.
+ * @data: user data to pass to @func.
+ *
+ * Sets the function called once every node of @pipeline has processed its
+ * last frame, after the sources ran out and the end of stream was passed
+ * through each queue. It is called from a worker thread, which must not
+ * pause the pipeline.
+ */
+void
+v_pipeline_set_eos_func (VPipeline *pipeline, VPipelineFunc *func, void *data)
+{
+	pipeline->priv->eos_func = func;
+	pipeline->priv->eos_data = data;
+}
+
+
+
+
+
+/**
+ * v_node_link:
+ * @src: the #VNode emitting frames.
+ * @dest: the #VNode receiving frames.
+ * @depth: the most frames queued between both nodes.
+ *
+ * Connects @src to @dest with a queue of @depth frames. Once the queue is
+ * full @src stops running until @dest takes frames off it. Nodes must be
+ * linked before the pipeline starts.
+ */
+void
+v_node_link (VNode *src, VNode *dest, unsigned int depth)
+{
+	Link *link = v_new (Link);
+	
+	if (depth == 0)
+		depth = 1;
+	
+	link->src = src;
+	link->dest = dest;
+	link->ring = v_ring_new (depth);
+	link->held = v_list_new ();
+	
+	link->min_depth = depth;
+	link->max_depth = depth;
+	link->stats.depth = depth;
+	
+	v_list_append (src->priv->outputs, link);
+	v_list_append (dest->priv->inputs, link);
+
+}
+
+
+
+/*
+ * find_link:
+ * @src: the #VNode emitting frames.
+ * @dest: the #VNode receiving frames.
+ *
+ * Returns: the #Link from @src to @dest, %NULL if they aren't linked.
+ */
+static Link *
+find_link (VNode *src, VNode *dest)
+{
+	VListNode *iter;
+	
+	for (iter = src->priv->outputs->first; iter; iter = iter->next)
+		if (((Link *) iter->data)->dest == dest)
+			return (Link *) iter->data;
+	
+	return NULL;
+}
+
+
+
+/**
+ * v_node_set_depth:
+ * @src: the #VNode emitting frames.
+ * @dest: the #VNode receiving frames.
+ * @min: the smallest amount of frames queued between both nodes.
+ * @max: the largest amount of frames queued between both nodes.
+ *
+ * Lets the queue from @src to @dest adapt its depth between @min and
+ * @max. The depth doubles when bursts fill the queue and halves when it
+ * stays mostly empty, so memory stays bounded by @max frames. Equal
+ * bounds give a fixed depth. The pipeline must not be running, and frames
+ * already queued are kept, held back if they no longer fit.
+ *
+ * Returns: %true if the depth was set, %false if the nodes are not linked
+ * or the pipeline is running.
+ */
+bool
+v_node_set_depth (VNode *src, VNode *dest, unsigned int min, unsigned int max)
+{
+	Link *link = find_link (src, dest);
+	VRing *ring;
+	VList *held;
+	VFrame *frame;
+	unsigned int depth;
+	
+	
+	if (link == NULL)
+		return false;
+	
+	/* the ring has one producer and one consumer, neither of them us */
+	if (!__atomic_load_n (&src->priv->pipeline->priv->paused, __ATOMIC_SEQ_CST))
+		return false;
+	
+	if (min == 0)
+		min = 1;
+	
+	if (max < min)
+		max = min;
+	
+	
+	/* start from the current depth where it fits */
+	depth = link->ring->size;
+	
+	if (depth < min)
+		depth = min;
+	
+	if (depth > max)
+		depth = max;
+	
+	
+	ring = v_ring_new (max);
+	v_ring_set_size (ring, depth);
+	
+	
+	/* move the queued frames over in order, holding back what does not
+	 * fit ahead of the frames already held */
+	held = v_list_new ();
+	
+	while ((frame = v_ring_pop (link->ring)) != NULL)
+		if (held->length > 0 || !v_ring_push (ring, frame))
+			v_list_append (held, frame);
+	
+	/* the consumer restarts the producer once it makes room */
+	if (held->length > 0 && link->held->length == 0)
+	{
+		link->held_since = get_time ();
+		__atomic_store_n (&src->priv->stalled, 1, __ATOMIC_SEQ_CST);
+	}
+	
+	while (link->held->first != NULL)
+	{
+		v_list_append (held, link->held->first->data);
+		v_list_remove (link->held, link->held->first);
+	}
+	
+	v_ring_free (link->ring);
+	v_list_free (link->held);
+	
+	link->ring = ring;
+	link->held = held;
+	
+	link->min_depth = min;
+	link->max_depth = max;
+	link->stats.depth = depth;
+	
+	return true;
+}
+
+
+
+/**
+ * v_node_get_link_stats:
+ * @src: the #VNode emitting frames.
+ * @dest: the #VNode receiving frames.
+ * @stats: return location for the #VLinkStats.
+ *
+ * Gets the occupancy and blocking of the queue from @src to @dest, which
+ * tells whether the producer or the consumer holds the pipeline back. Like
+ * v_node_get_stats() the counters are only exact once the pipeline is
+ * paused or has ended.
+ *
+ * Returns: %true if the nodes are linked, %false otherwise.
+ */
+bool
+v_node_get_link_stats (VNode *src, VNode *dest, VLinkStats *stats)
+{
+	Link *link = find_link (src, dest);
+	
+	if (link == NULL)
+		return false;
+	
+	*stats = link->stats;
+	return true;
+}
+
+
+
+/**
+ * v_node_set_hint:
+ * @node: a #VNode.
+ * @hint: the index of the worker to prefer.
+ *
+ * Binds @node to a worker of the default thread pool. Idle workers can
+ * still steal it, so this is a preference. Nodes passing frames along can
+ * share a worker to keep the frames in its cache.
+ */
+void
+v_node_set_hint (VNode *node, int hint)
+{
+	node->hint = hint;
+}
+
+
+
+/**
+ * v_node_set_batch:
+ * @node: a #VNode.
+ * @batch: the most frames handed to the node per call.
+ *
+ * Lets @node process several waiting frames at once, such as decoding a
+ * run of audio frames into one buffer. Must be set before the pipeline
+ * starts.
+ */
+void
+v_node_set_batch (VNode *node, unsigned int batch)
+{
+	if (batch == 0)
+		batch = 1;
+	
+	node->batch = batch;
+	node->priv->frames = v_realloc (node->priv->frames, batch * sizeof (VFrame *));
+}
+
+
+
+/**
+ * v_node_get_stats:
+ * @node: a #VNode.
+ * @stats: return location for the #VNodeStats.
+ *
+ * Gets the work done by @node so far. The counters are updated by the
+ * node while it runs, so they are only exact once the pipeline is paused
+ * or has ended.
+ */
+void
+v_node_get_stats (VNode *node, VNodeStats *stats)
+{
+	*stats = node->priv->stats;
+}
+
+
+
+
+/**
+ * v_node_wait:
+ * @node: the running #VNode.
+ * @delay: the seconds to wait.
+ *
+ * Puts off the work of @node, such as presenting a picture that isn't due
+ * yet, without holding a worker while waiting. Once the node function
+ * returns the node takes no frames for @delay, then its function is
+ * called with no frames to carry on. The node keeps what it was working
+ * on itself. v_pipeline_pause() cuts the wait short and
+ * v_pipeline_flush() drops it. Only @node itself may call this while it
+ * runs.
+ */
+void
+v_node_wait (VNode *node, double delay)
+{
+	node->priv->waiting = true;
+	node->priv->wake_at = get_time () + delay;
+}
+
+
+
+/**
+ * v_node_emit:
+ * @node: the running #VNode.
+ * @frame: the frame to pass on.
+ *
+ * Passes @frame to every node linked to @node, taking ownership of it.
+ * Each node gets a reference to the same frame rather than a copy, so
+ * fanned out frames must be treated as read only. Only @node itself may
+ * call this while it runs.
+ */
+void
+v_node_emit (VNode *node, VFrame *frame)
+{
+	VList *outputs = node->priv->outputs;
+	VListNode *iter;
+	unsigned int i;
+	
+	
+	node->priv->stats.frames_out++;
+	
+	/* nobody to pass it to */
+	if (outputs->length == 0)
+	{
+		v_frame_free (frame);
+		return;
+	}
+	
+	
+	/* reference the frame before any node can release it */
+	for (i = 1; i < outputs->length; i++)
+		v_frame_ref (frame);
+	
+	for (iter = outputs->first; iter; iter = iter->next)
+		deliver ((Link *) iter->data, frame);
+}
+
+
+
+/**
+ * v_node_emit_to:
+ * @node: the running #VNode.
+ * @dest: a #VNode linked to @node.
+ * @frame: the frame to pass on.
+ *
+ * Passes @frame to @dest only, taking ownership of it. This routes frames
+ * such as demuxed packets to the node handling their stream. The frame is
+ * dropped if @dest isn't linked to @node.
+ */
+void
+v_node_emit_to (VNode *node, VNode *dest, VFrame *frame)
+{
+	VListNode *iter;
+	
+	node->priv->stats.frames_out++;
+	
+	for (iter = node->priv->outputs->first; iter; iter = iter->next)
+	{
+		Link *link = (Link *) iter->data;
+		
+		if (link->dest == dest)
+		{
+			deliver (link, frame);
+			return;
+		}
+	}
+	
+	
+	v_frame_free (frame);
+}
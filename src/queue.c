@@ -148,6 +148,7 @@ v_queue_free (VQueue *queue)
 	
 	
 	/* free the queue */
+	v_free (priv);
 	v_free (queue);
 }
 
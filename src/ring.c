@@ -0,0 +1,450 @@
+/***************************************************************************
+ *            ring.c
+ *
+ *  Oct 19, 2026 7:01:06 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "ring.h"
+#include "mem.h"
+#include <string.h>  /* memset */
+#include <stdint.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <sched.h>
+#endif
+
+
+
+/* the alignment keeping each side on its own cache line */
+#define CACHE_LINE 64
+
+/* polls of the other side before going to sleep */
+#define SPIN_COUNT 128
+
+
+
+/*
+ * VRingPriv:
+ *
+ * Private structure for #VRing. The producer only writes @tail and the
+ * consumer only writes @head, each keeping a stale copy of the other side
+ * so the shared line is only read when the ring looks full or empty.
+ */
+struct _VRingPriv
+{
+	/* consumer side */
+	unsigned int head __attribute__ ((aligned (CACHE_LINE)));
+	unsigned int cached_tail;
+	
+	/* producer side */
+	unsigned int tail __attribute__ ((aligned (CACHE_LINE)));
+	unsigned int cached_head;
+	
+	/* set by a side before it sleeps */
+	int consumer_waiting __attribute__ ((aligned (CACHE_LINE)));
+	int producer_waiting __attribute__ ((aligned (CACHE_LINE)));
+	
+	unsigned int mask;
+	void **slots;
+	
+	/* the most entries the ring can be sized to */
+	unsigned int capacity;
+};
+
+
+
+
+/*
+ * park:
+ * @waiting: the waiting flag of the sleeping side.
+ *
+ * Sleeps while @waiting is still set.
+ */
+static void
+park (int *waiting)
+{
+#ifdef __linux__
+	syscall (SYS_futex, waiting, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+#else
+	sched_yield ();
+#endif
+}
+
+
+
+/*
+ * unpark:
+ * @waiting: the waiting flag of the other side.
+ *
+ * Wakes the other side if it is sleeping.
+ */
+static void
+unpark (int *waiting)
+{
+	if (__atomic_load_n (waiting, __ATOMIC_SEQ_CST) == 0)
+		return;
+	
+	__atomic_store_n (waiting, 0, __ATOMIC_SEQ_CST);
+	
+#ifdef __linux__
+	syscall (SYS_futex, waiting, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#endif
+}
+
+
+
+
+/**
+ * v_ring_new:
+ * @size: the amount of entries the ring can hold.
+ *
+ * Creates an empty #VRing.
+ *
+ * Returns: a #VRing structure.
+ */
+VRing *
+v_ring_new (unsigned int size)
+{
+	VRing *ret = v_new (VRing);
+	VRingPriv *priv = v_malloc_aligned (CACHE_LINE, sizeof (VRingPriv));
+	
+	unsigned int slots = 1;
+	
+	
+	memset (priv, 0, sizeof (VRingPriv));
+	
+	if (size == 0)
+		size = 1;
+	
+	/* slots are indexed with a mask but only @size are ever used */
+	while (slots < size)
+		slots <<= 1;
+	
+	priv->mask = slots - 1;
+	priv->slots = v_mallocz (slots * sizeof (void *));
+	
+	priv->capacity = size;
+	
+	ret->size = size;
+	ret->priv = priv;
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_ring_free:
+ * @ring: a #VRing to free.
+ *
+ * Free's @ring. Entries still in the ring are not free'd.
+ */
+void
+v_ring_free (VRing *ring)
+{
+	v_free (ring->priv->slots);
+	v_free (ring->priv);
+	v_free (ring);
+}
+
+
+
+
+
+/**
+ * v_ring_set_size:
+ * @ring: a #VRing.
+ * @size: the amount of entries the ring should hold.
+ *
+ * Changes how many entries @ring holds, up to the size it was created
+ * with. Entries beyond a reduced size stay queued, the producer can only
+ * add more once the consumer took them. Only the producer thread may call
+ * this.
+ */
+void
+v_ring_set_size (VRing *ring, unsigned int size)
+{
+	if (size == 0)
+		size = 1;
+	
+	if (size > ring->priv->capacity)
+		size = ring->priv->capacity;
+	
+	ring->size = size;
+}
+
+
+
+
+
+/**
+ * v_ring_length:
+ * @ring: a #VRing.
+ *
+ * Gets the amount of entries in @ring. Either thread may call this, but
+ * the other side can change the amount right after.
+ *
+ * Returns: the amount of entries.
+ */
+unsigned int
+v_ring_length (VRing *ring)
+{
+	VRingPriv *priv = ring->priv;
+	
+	/* the head first, as the tail can only have moved further since */
+	unsigned int head = __atomic_load_n (&priv->head, __ATOMIC_SEQ_CST);
+	unsigned int tail = __atomic_load_n (&priv->tail, __ATOMIC_SEQ_CST);
+	
+	return tail - head;
+}
+
+
+
+
+/**
+ * v_ring_push:
+ * @ring: a #VRing.
+ * @data: the data to add, must not be %NULL.
+ *
+ * Adds @data to the end of @ring. Only the producer thread may call this.
+ *
+ * Returns: %true if added, %false if the ring is full.
+ */
+bool
+v_ring_push (VRing *ring, void *data)
+{
+	VRingPriv *priv = ring->priv;
+	unsigned int tail = priv->tail;
+	
+	
+	/* only look at the consumer when the ring seems full */
+	if (tail - priv->cached_head >= ring->size)
+	{
+		priv->cached_head = __atomic_load_n (&priv->head, __ATOMIC_ACQUIRE);
+		
+		if (tail - priv->cached_head >= ring->size)
+			return false;
+	}
+	
+	
+	priv->slots[tail & priv->mask] = data;
+	__atomic_store_n (&priv->tail, tail + 1, __ATOMIC_SEQ_CST);
+	
+	unpark (&priv->consumer_waiting);
+	
+	
+	return true;
+}
+
+
+
+
+/**
+ * v_ring_pop:
+ * @ring: a #VRing.
+ *
+ * Gets the next data from @ring. Only the consumer thread may call this.
+ *
+ * Returns: the next void* casted data in the ring, %NULL if empty.
+ */
+void *
+v_ring_pop (VRing *ring)
+{
+	VRingPriv *priv = ring->priv;
+	unsigned int head = priv->head;
+	void *data;
+	
+	
+	/* only look at the producer when the ring seems empty */
+	if (head == priv->cached_tail)
+	{
+		priv->cached_tail = __atomic_load_n (&priv->tail, __ATOMIC_ACQUIRE);
+		
+		if (head == priv->cached_tail)
+			return NULL;
+	}
+	
+	
+	data = priv->slots[head & priv->mask];
+	__atomic_store_n (&priv->head, head + 1, __ATOMIC_SEQ_CST);
+	
+	unpark (&priv->producer_waiting);
+	
+	
+	return data;
+}
+
+
+
+
+
+/**
+ * v_ring_push_wait:
+ * @ring: a #VRing.
+ * @data: the data to add, must not be %NULL.
+ *
+ * Adds @data to the end of @ring, sleeping until there is space.
+ */
+void
+v_ring_push_wait (VRing *ring, void *data)
+{
+	VRingPriv *priv = ring->priv;
+	int spins = 0;
+	
+	
+	while (!v_ring_push (ring, data))
+	{
+		if (++spins < SPIN_COUNT)
+			continue;
+		
+		
+		/* announce the sleep, then check again so a pop in between isn't missed */
+		__atomic_store_n (&priv->producer_waiting, 1, __ATOMIC_SEQ_CST);
+		
+		if (__atomic_load_n (&priv->tail, __ATOMIC_SEQ_CST) -
+		    __atomic_load_n (&priv->head, __ATOMIC_SEQ_CST) >= ring->size)
+			park (&priv->producer_waiting);
+		
+		__atomic_store_n (&priv->producer_waiting, 0, __ATOMIC_SEQ_CST);
+		spins = 0;
+	}
+}
+
+
+
+
+/**
+ * v_ring_pop_wait:
+ * @ring: a #VRing.
+ *
+ * Gets the next data from @ring, sleeping until there is some.
+ *
+ * Returns: the next void* casted data in the ring.
+ */
+void *
+v_ring_pop_wait (VRing *ring)
+{
+	VRingPriv *priv = ring->priv;
+	void *data;
+	int spins = 0;
+	
+	
+	while ((data = v_ring_pop (ring)) == NULL)
+	{
+		if (++spins < SPIN_COUNT)
+			continue;
+		
+		
+		/* announce the sleep, then check again so a push in between isn't missed */
+		__atomic_store_n (&priv->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+		
+		if (__atomic_load_n (&priv->tail, __ATOMIC_SEQ_CST) ==
+		    __atomic_load_n (&priv->head, __ATOMIC_SEQ_CST))
+			park (&priv->consumer_waiting);
+		
+		__atomic_store_n (&priv->consumer_waiting, 0, __ATOMIC_SEQ_CST);
+		spins = 0;
+	}
+	
+	
+	return data;
+}
+
+
+
+
+/**
+ * v_ring_pop_many:
+ * @ring: a #VRing.
+ * @data: return location for the data.
+ * @max: the most data to get.
+ *
+ * Gets up to @max entries from @ring, releasing their slots to the
+ * producer in one go. Only the consumer thread may call this.
+ *
+ * Returns: the amount of data stored in @data, 0 if empty.
+ */
+unsigned int
+v_ring_pop_many (VRing *ring, void **data, unsigned int max)
+{
+	VRingPriv *priv = ring->priv;
+	unsigned int head = priv->head;
+	unsigned int count, i;
+	
+	
+	priv->cached_tail = __atomic_load_n (&priv->tail, __ATOMIC_ACQUIRE);
+	
+	count = priv->cached_tail - head;
+	
+	if (count > max)
+		count = max;
+	
+	if (count == 0)
+		return 0;
+	
+	
+	for (i = 0; i < count; i++)
+		data[i] = priv->slots[(head + i) & priv->mask];
+	
+	__atomic_store_n (&priv->head, head + count, __ATOMIC_SEQ_CST);
+	
+	unpark (&priv->producer_waiting);
+	
+	
+	return count;
+}
+
+
+
+
+/**
+ * v_ring_pop_many_wait:
+ * @ring: a #VRing.
+ * @data: return location for the data.
+ * @max: the most data to get.
+ *
+ * Sleeps until @ring has data and then gets everything available, up to
+ * @max entries.
+ *
+ * Returns: the amount of data stored in @data, at least one.
+ */
+unsigned int
+v_ring_pop_many_wait (VRing *ring, void **data, unsigned int max)
+{
+	unsigned int count = v_ring_pop_many (ring, data, max);
+	
+	if (count > 0 || max == 0)
+		return count;
+	
+	
+	/* sleep for the first entry, then take whatever came with it */
+	data[0] = v_ring_pop_wait (ring);
+	
+	return 1 + v_ring_pop_many (ring, data + 1, max - 1);
+}
+
@@ -79,3 +79,57 @@ v_stream_free (VStream *stream)
 	v_free (stream);
 }
 
+
+
+
+/**
+ * v_stream_update:
+ * @stream: a #VStream.
+ *
+ * Loads the stream properties detected by the stream's codec.
+ */
+void
+v_stream_update (VStream *stream)
+{
+	VCodecProperties *prop = v_codec_properties (stream->codec);
+	
+	
+	/* audio properties */
+	stream->channels = prop->channels;
+	stream->sample_rate = prop->sample_rate;
+	stream->sample_format = prop->sample_format;
+	
+	/* video properties */
+	stream->width = prop->width;
+	stream->height = prop->height;
+	stream->pixel_format = prop->pixel_format;
+	stream->lowres = prop->lowres;
+	
+	
+	v_free (prop);
+}
+
+
+
+
+/**
+ * v_stream_set_lowres:
+ * @stream: a #VStream.
+ * @lowres: the scale factor, where 0 is full size, 1 is half size,
+ * 2 is quarter size and so on.
+ *
+ * Decodes @stream at a reduced resolution. The reduced dimensions are
+ * loaded into @stream so that any component set up afterwards, such as
+ * a #VColorspace or #VOutput, works at the smaller size.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+bool
+v_stream_set_lowres (VStream *stream, int lowres)
+{
+	if (v_codec_set_lowres (stream->codec, lowres) == false)
+		return false;
+	
+	v_stream_update (stream);
+	return true;
+}
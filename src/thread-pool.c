@@ -0,0 +1,508 @@
+/***************************************************************************
+ *            thread-pool.c
+ *
+ *  Oct 19, 2026 6:38:24 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+#include "thread-pool.h"
+#include "mem.h"
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>  /* sysconf */
+
+
+typedef struct _VTask  VTask;
+typedef struct _Worker Worker;
+
+
+
+/* the fewest workers in the shared pool, as stages can block on devices */
+#define DEFAULT_MIN_THREADS 4
+
+
+
+/*
+ * VTask:
+ * @func: the task callback.
+ * @data: the data passed to @func.
+ *
+ * A queued task.
+ */
+struct _VTask
+{
+	VTaskFunc *func;
+	void *data;
+};
+
+
+
+/*
+ * Worker:
+ * @pool: the pool the worker belongs to.
+ * @thread: the worker thread.
+ * @lock: protects the task queue.
+ * @tasks: the queued tasks, a circular array.
+ * @capacity: the size of @tasks.
+ * @first: the index of the oldest task.
+ * @length: the amount of queued tasks.
+ *
+ * A worker thread with its own task queue. Idle workers steal the oldest
+ * tasks from the queues of busy workers.
+ */
+struct _Worker
+{
+	VThreadPool *pool;
+	pthread_t thread;
+	
+	pthread_mutex_t lock;
+	VTask *tasks;
+	int capacity;
+	int first;
+	int length;
+};
+
+
+
+/*
+ * VThreadPoolPriv:
+ * @workers: the worker threads.
+ * @mutex: protects @stopping and sleeping on @wake.
+ * @wake: signalled when tasks are pushed.
+ * @pending: the amount of queued tasks across all workers, raised with
+ * @mutex held before the task is queued so sleeping workers can't miss it
+ * and it never drops below zero.
+ * @next: the worker unhinted tasks from outside the pool go to.
+ * @stopping: whether the workers should exit once idle.
+ *
+ * Private structure for #VThreadPool.
+ */
+struct _VThreadPoolPriv
+{
+	Worker *workers;
+	
+	pthread_mutex_t mutex;
+	pthread_cond_t  wake;
+	
+	int pending;
+	unsigned int next;
+	bool stopping;
+};
+
+
+
+/* the worker running on the current thread, if any */
+static __thread Worker *current = NULL;
+
+
+static VThreadPool *default_pool = NULL;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+
+
+
+
+/*
+ * queue_task:
+ * @worker: a #Worker.
+ * @func: the task callback.
+ * @data: the data passed to @func.
+ *
+ * Adds a task to the end of the worker queue.
+ */
+static void
+queue_task (Worker *worker, VTaskFunc *func, void *data)
+{
+	pthread_mutex_lock (&worker->lock);
+	
+	
+	/* grow the queue, unwrapping the tasks into the new space */
+	if (worker->length == worker->capacity)
+	{
+		int capacity = worker->capacity ? worker->capacity * 2 : 16;
+		VTask *tasks = v_malloc (capacity * sizeof (VTask));
+		int i;
+		
+		for (i = 0; i < worker->length; i++)
+			tasks[i] = worker->tasks[(worker->first + i) % worker->capacity];
+		
+		v_free (worker->tasks);
+		
+		worker->tasks = tasks;
+		worker->capacity = capacity;
+		worker->first = 0;
+	}
+	
+	
+	VTask *task = &worker->tasks[(worker->first + worker->length) % worker->capacity];
+	
+	task->func = func;
+	task->data = data;
+	worker->length++;
+	
+	
+	pthread_mutex_unlock (&worker->lock);
+}
+
+
+
+
+/*
+ * take_task:
+ * @worker: a #Worker.
+ * @task: return location for the task.
+ *
+ * Takes the oldest task off the worker queue. This is used both by the
+ * worker itself and by idle workers stealing from it.
+ *
+ * Returns: %true if a task was taken, %false if the queue is empty.
+ */
+static bool
+take_task (Worker *worker, VTask *task)
+{
+	bool ret = false;
+	
+	
+	pthread_mutex_lock (&worker->lock);
+	
+	if (worker->length > 0)
+	{
+		*task = worker->tasks[worker->first];
+		
+		worker->first = (worker->first + 1) % worker->capacity;
+		worker->length--;
+		
+		ret = true;
+	}
+	
+	pthread_mutex_unlock (&worker->lock);
+	
+	
+	return ret;
+}
+
+
+
+
+/*
+ * find_task:
+ * @worker: a #Worker.
+ * @task: return location for the task.
+ *
+ * Gets the next task of the worker, stealing one from the other workers
+ * when its own queue is empty.
+ *
+ * Returns: %true if a task was found, %false otherwise.
+ */
+static bool
+find_task (Worker *worker, VTask *task)
+{
+	VThreadPool *pool = worker->pool;
+	int self = worker - pool->priv->workers;
+	int i;
+	
+	
+	if (take_task (worker, task))
+		return true;
+	
+	
+	/* start with the neighbour to spread thieves over the victims */
+	for (i = 1; i < pool->threads; i++)
+	{
+		Worker *victim = &pool->priv->workers[(self + i) % pool->threads];
+		
+		if (take_task (victim, task))
+			return true;
+	}
+	
+	
+	return false;
+}
+
+
+
+
+/*
+ * run_worker:
+ * @user_data: a #Worker.
+ *
+ * Runs tasks until the pool is stopping and no tasks are left.
+ */
+static void *
+run_worker (void *user_data)
+{
+	Worker *worker = (Worker *) user_data;
+	VThreadPoolPriv *priv = worker->pool->priv;
+	VTask task;
+	
+	
+	current = worker;
+	
+	while (true)
+	{
+		if (find_task (worker, &task))
+		{
+			__sync_fetch_and_sub (&priv->pending, 1);
+			task.func (task.data);
+			
+			continue;
+		}
+		
+		
+		/* sleep until there is something to run */
+		pthread_mutex_lock (&priv->mutex);
+		
+		while (__atomic_load_n (&priv->pending, __ATOMIC_RELAXED) == 0 && !priv->stopping)
+			pthread_cond_wait (&priv->wake, &priv->mutex);
+		
+		bool done = __atomic_load_n (&priv->pending, __ATOMIC_RELAXED) == 0 && priv->stopping;
+		
+		pthread_mutex_unlock (&priv->mutex);
+		
+		
+		if (done)
+			break;
+	}
+	
+	
+	current = NULL;
+	
+	return NULL;
+}
+
+
+
+
+
+/**
+ * v_thread_pool_new:
+ * @threads: the amount of worker threads, or 0 to use one per processor.
+ *
+ * Creates a new #VThreadPool and starts its worker threads. Each worker
+ * has its own task queue and steals from the others when it runs dry.
+ *
+ * Returns: a #VThreadPool structure.
+ */
+VThreadPool *
+v_thread_pool_new (int threads)
+{
+	VThreadPool *ret = v_new (VThreadPool);
+	VThreadPoolPriv *priv = v_new (VThreadPoolPriv);
+	
+	
+	if (threads <= 0)
+		threads = v_thread_pool_cpu_count ();
+	
+	
+	/* default values */
+	ret->threads = threads;
+	ret->priv = priv;
+	
+	pthread_mutex_init (&priv->mutex, NULL);
+	pthread_cond_init  (&priv->wake,  NULL);
+	
+	priv->workers = v_mallocz (threads * sizeof (Worker));
+	
+	
+	/* start workers */
+	int i;
+	
+	for (i = 0; i < threads; i++)
+	{
+		priv->workers[i].pool = ret;
+		pthread_mutex_init (&priv->workers[i].lock, NULL);
+	}
+	
+	for (i = 0; i < threads; i++)
+		pthread_create (&priv->workers[i].thread, NULL, run_worker, &priv->workers[i]);
+	
+	
+	return ret;
+}
+
+
+
+
+/**
+ * v_thread_pool_free:
+ * @pool: a #VThreadPool to free.
+ *
+ * Waits for all pushed tasks to finish, then stops the worker threads and
+ * destroys @pool.
+ */
+void
+v_thread_pool_free (VThreadPool *pool)
+{
+	VThreadPoolPriv *priv = pool->priv;
+	int i;
+	
+	
+	/* workers exit once every queue is empty */
+	pthread_mutex_lock (&priv->mutex);
+	
+	priv->stopping = true;
+	pthread_cond_broadcast (&priv->wake);
+	
+	pthread_mutex_unlock (&priv->mutex);
+	
+	
+	for (i = 0; i < pool->threads; i++)
+		pthread_join (priv->workers[i].thread, NULL);
+	
+	for (i = 0; i < pool->threads; i++)
+	{
+		pthread_mutex_destroy (&priv->workers[i].lock);
+		v_free (priv->workers[i].tasks);
+	}
+	
+	
+	pthread_mutex_destroy (&priv->mutex);
+	pthread_cond_destroy  (&priv->wake);
+	
+	v_free (priv->workers);
+	v_free (priv);
+	v_free (pool);
+}
+
+
+
+
+/**
+ * v_thread_pool_push:
+ * @pool: a #VThreadPool.
+ * @func: the task callback.
+ * @data: void* casted data to pass to @func.
+ *
+ * Queues a task to be run by the next free worker thread. Tasks pushed
+ * from a worker of @pool are queued on that worker.
+ */
+void
+v_thread_pool_push (VThreadPool *pool, VTaskFunc *func, void *data)
+{
+	v_thread_pool_push_to (pool, -1, func, data);
+}
+
+
+
+
+/**
+ * v_thread_pool_push_to:
+ * @pool: a #VThreadPool.
+ * @hint: the preferred worker, or -1 for none.
+ * @func: the task callback.
+ * @data: void* casted data to pass to @func.
+ *
+ * Queues a task on the worker @hint maps to, so that tasks pushed with the
+ * same hint tend to run on the same thread and keep their data in its
+ * cache. Idle workers may still steal the task.
+ */
+void
+v_thread_pool_push_to (VThreadPool *pool, int hint, VTaskFunc *func, void *data)
+{
+	VThreadPoolPriv *priv = pool->priv;
+	Worker *worker;
+	
+	
+	if (hint >= 0)
+		worker = &priv->workers[hint % pool->threads];
+	
+	else if (current != NULL && current->pool == pool)
+		worker = current;
+	
+	else
+		worker = &priv->workers[__sync_fetch_and_add (&priv->next, 1) % pool->threads];
+	
+	
+	/* count the task before any worker can take it, or the count would
+	 * dip below zero and keep idle workers from sleeping */
+	pthread_mutex_lock (&priv->mutex);
+	
+	__sync_fetch_and_add (&priv->pending, 1);
+	queue_task (worker, func, data);
+	
+	/* wake a sleeping worker */
+	pthread_cond_signal (&priv->wake);
+	
+	pthread_mutex_unlock (&priv->mutex);
+}
+
+
+
+
+
+/*
+ * init_default:
+ *
+ * Creates the shared pool.
+ */
+static void
+init_default (void)
+{
+	int threads = v_thread_pool_cpu_count ();
+	
+	if (threads < DEFAULT_MIN_THREADS)
+		threads = DEFAULT_MIN_THREADS;
+	
+	default_pool = v_thread_pool_new (threads);
+}
+
+
+
+
+/**
+ * v_thread_pool_get_default:
+ *
+ * Gets the pool shared by the whole process. It has a worker per
+ * processor, but at least four since pipeline stages may block on output
+ * devices. It is never free'd.
+ *
+ * Returns: the shared #VThreadPool.
+ */
+VThreadPool *
+v_thread_pool_get_default (void)
+{
+	pthread_once (&default_once, init_default);
+	
+	return default_pool;
+}
+
+
+
+
+/**
+ * v_thread_pool_cpu_count:
+ *
+ * Gets the amount of online processors.
+ *
+ * Returns: the processor count, at least 1.
+ */
+int
+v_thread_pool_cpu_count (void)
+{
+	long count = sysconf (_SC_NPROCESSORS_ONLN);
+	
+	if (count < 1)
+		return 1;
+	
+	return (int) count;
+}
+
+
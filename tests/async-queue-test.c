@@ -0,0 +1,356 @@
+/***************************************************************************
+ *            async-queue-test.c
+ *
+ *  Mon Oct 19 17:12:40 2026
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <villanova-engine/async-queue.h>
+
+
+
+/* the capacity of the queues tested */
+#define QUEUE_SIZE 8
+
+/* the entries streamed between threads */
+#define STREAM_COUNT 20000
+
+/* the timeout given to timed calls, and how late they may return */
+#define TIMEOUT 0.05
+#define TIMEOUT_SLACK 0.5
+
+
+
+/* entries are counted from 1 since an empty queue returns NULL */
+#define ENTRY(i) ((void *) (uintptr_t) ((i) + 1))
+#define INDEX(p) ((unsigned int) (uintptr_t) (p) - 1)
+
+
+
+static int failures = 0;
+static unsigned int destroyed = 0;
+
+
+
+#define CHECK(cond, ...) \
+	do { \
+		if (!(cond)) \
+		{ \
+			printf ("FAIL - " __VA_ARGS__); \
+			printf ("\n"); \
+			failures++; \
+		} \
+	} while (0)
+
+
+
+
+static double
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+
+static void
+sleep_for (double seconds)
+{
+	struct timespec ts = { 0, seconds * 1000000000 };
+	nanosleep (&ts, NULL);
+}
+
+
+
+
+static void
+destroy (void *data)
+{
+	destroyed++;
+}
+
+
+
+
+/*
+ * test_batches:
+ *
+ * Checks batched calls take as much as fits or is there, in order.
+ */
+static void
+test_batches (void)
+{
+	VAsyncQueue *queue = v_async_queue_new (QUEUE_SIZE);
+	void *in[QUEUE_SIZE + 4];
+	void *out[QUEUE_SIZE + 4];
+	unsigned int i, count;
+	
+	
+	for (i = 0; i < QUEUE_SIZE + 4; i++)
+		in[i] = ENTRY (i);
+	
+	count = v_async_queue_enqueue_many (queue, in, QUEUE_SIZE + 4);
+	CHECK (count == QUEUE_SIZE, "enqueued %u of %u into a queue of %u",
+			count, QUEUE_SIZE + 4, QUEUE_SIZE);
+	
+	count = v_async_queue_dequeue_many (queue, out, 5);
+	CHECK (count == 5, "dequeued %u, asked for 5", count);
+	
+	count += v_async_queue_dequeue_many (queue, out + count, QUEUE_SIZE + 4);
+	CHECK (count == QUEUE_SIZE, "dequeued %u in all, expected %u", count, QUEUE_SIZE);
+	
+	for (i = 0; i < count; i++)
+		CHECK (out[i] == in[i], "entry %u came out as %u", i, INDEX (out[i]));
+	
+	count = v_async_queue_dequeue_many (queue, out, QUEUE_SIZE);
+	CHECK (count == 0, "dequeued %u from an empty queue", count);
+	
+	
+	/* draining releases everything and leaves room again */
+	v_async_queue_enqueue_many (queue, in, 5);
+	
+	count = v_async_queue_drain (queue, destroy);
+	CHECK (count == 5 && destroyed == 5, "drained %u, released %u, expected 5",
+			count, destroyed);
+	
+	count = v_async_queue_enqueue_many (queue, in, QUEUE_SIZE);
+	CHECK (count == QUEUE_SIZE, "enqueued %u after draining", count);
+	
+	v_async_queue_drain (queue, NULL);
+	v_async_queue_free (queue);
+}
+
+
+
+
+/*
+ * test_max_zero:
+ *
+ * Checks asking for no entries returns at once and leaves the queue be,
+ * rather than waiting forever on an empty one.
+ */
+static void
+test_max_zero (void)
+{
+	VAsyncQueue *queue = v_async_queue_new (QUEUE_SIZE);
+	void *out[1];
+	unsigned int count;
+	double start;
+	
+	
+	start = get_time ();
+	
+	count = v_async_queue_dequeue_many_wait (queue, out, 0);
+	CHECK (count == 0, "waiting for 0 entries gave %u", count);
+	
+	count = v_async_queue_dequeue_many_timed (queue, out, 0, 10);
+	CHECK (count == 0, "waiting for 0 entries with a timeout gave %u", count);
+	
+	CHECK (get_time () - start < TIMEOUT_SLACK, "asking for 0 entries waited");
+	
+	
+	v_async_queue_enqueue (queue, ENTRY (0));
+	
+	count = v_async_queue_dequeue_many_timed (queue, out, 0, 10);
+	CHECK (count == 0 && v_async_queue_peek (queue) == ENTRY (0),
+			"asking for 0 entries took one");
+	
+	v_async_queue_drain (queue, NULL);
+	v_async_queue_free (queue);
+}
+
+
+
+
+/*
+ * enqueue_later:
+ * @data: a #VAsyncQueue.
+ *
+ * Adds an entry once the other side had time to start waiting.
+ */
+static void *
+enqueue_later (void *data)
+{
+	sleep_for (TIMEOUT / 2);
+	v_async_queue_enqueue_wait ((VAsyncQueue *) data, ENTRY (0));
+	
+	return NULL;
+}
+
+
+
+
+/*
+ * test_timeouts:
+ *
+ * Checks timed calls give up after their timeout, and return as soon as
+ * the other side shows up.
+ */
+static void
+test_timeouts (void)
+{
+	VAsyncQueue *queue = v_async_queue_new (1);
+	pthread_t thread;
+	void *out[2];
+	double start, elapsed;
+	unsigned int count;
+	
+	
+	start = get_time ();
+	CHECK (v_async_queue_dequeue_timed (queue, TIMEOUT) == NULL,
+			"got an entry from an empty queue");
+	
+	elapsed = get_time () - start;
+	CHECK (elapsed >= TIMEOUT * 0.9 && elapsed < TIMEOUT + TIMEOUT_SLACK,
+			"an empty dequeue gave up after %.3f s, timeout %.3f s", elapsed, TIMEOUT);
+	
+	start = get_time ();
+	count = v_async_queue_dequeue_many_timed (queue, out, 2, TIMEOUT);
+	
+	elapsed = get_time () - start;
+	CHECK (count == 0 && elapsed >= TIMEOUT * 0.9 && elapsed < TIMEOUT + TIMEOUT_SLACK,
+			"an empty batch gave %u after %.3f s", count, elapsed);
+	
+	
+	v_async_queue_enqueue (queue, ENTRY (0));
+	
+	start = get_time ();
+	CHECK (!v_async_queue_enqueue_timed (queue, ENTRY (1), TIMEOUT),
+			"enqueued into a full queue");
+	
+	elapsed = get_time () - start;
+	CHECK (elapsed >= TIMEOUT * 0.9 && elapsed < TIMEOUT + TIMEOUT_SLACK,
+			"a full enqueue gave up after %.3f s", elapsed);
+	
+	v_async_queue_dequeue (queue);
+	
+	
+	/* an entry arriving within the timeout is taken straight away */
+	pthread_create (&thread, NULL, enqueue_later, queue);
+	
+	start = get_time ();
+	count = v_async_queue_dequeue_many_timed (queue, out, 2, 10);
+	
+	elapsed = get_time () - start;
+	CHECK (count == 1 && out[0] == ENTRY (0) && elapsed < TIMEOUT_SLACK,
+			"waiting for an entry gave %u after %.3f s", count, elapsed);
+	
+	pthread_join (thread, NULL);
+	v_async_queue_free (queue);
+}
+
+
+
+
+/*
+ * produce:
+ * @data: a #VAsyncQueue.
+ *
+ * Streams entries in batches of varying size, waiting on a full queue.
+ */
+static void *
+produce (void *data)
+{
+	VAsyncQueue *queue = (VAsyncQueue *) data;
+	void *batch[QUEUE_SIZE * 2];
+	unsigned int i = 0, j, count;
+	
+	
+	while (i < STREAM_COUNT)
+	{
+		count = 1 + i % (QUEUE_SIZE * 2);
+		
+		if (count > STREAM_COUNT - i)
+			count = STREAM_COUNT - i;
+		
+		for (j = 0; j < count; j++)
+			batch[j] = ENTRY (i + j);
+		
+		v_async_queue_enqueue_many_wait (queue, batch, count);
+		i += count;
+	}
+	
+	return NULL;
+}
+
+
+
+
+/*
+ * test_stream:
+ *
+ * Checks batches larger than the queue get through whole and in order
+ * between two threads.
+ */
+static void
+test_stream (void)
+{
+	VAsyncQueue *queue = v_async_queue_new (QUEUE_SIZE);
+	pthread_t thread;
+	void *out[3];
+	unsigned int next = 0, count, i;
+	bool ordered = true;
+	
+	
+	pthread_create (&thread, NULL, produce, queue);
+	
+	while (next < STREAM_COUNT)
+	{
+		count = v_async_queue_dequeue_many_wait (queue, out, 3);
+		
+		for (i = 0; i < count; i++)
+			if (INDEX (out[i]) != next++)
+				ordered = false;
+	}
+	
+	pthread_join (thread, NULL);
+	
+	CHECK (ordered, "entries streamed out of order");
+	CHECK (v_async_queue_dequeue (queue) == NULL, "entries left after the stream");
+	
+	v_async_queue_free (queue);
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	test_batches ();
+	test_max_zero ();
+	test_timeouts ();
+	test_stream ();
+	
+	printf ("%d failures\n", failures);
+	
+	return failures > 0;
+}
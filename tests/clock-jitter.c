@@ -0,0 +1,446 @@
+/***************************************************************************
+ *            clock-jitter.c
+ *
+ *  Oct 19, 2026 1:26:51 PM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <villanova-engine/pipeline.h>
+#include <villanova-engine/clock.h>
+#include <villanova-engine/thread-pool.h>
+
+
+
+/* the spin of each background task, in seconds */
+#define LOAD_TASK 0.001
+
+/* the presentation error allowed on average and at worst, in microseconds */
+#define MEAN_BOUND 2000
+#define LATE_BOUND 20000
+
+/* how long a pause may take with a picture seconds away, in seconds */
+#define PAUSE_BOUND 0.1
+
+/* the fake audio device runs this much fast, reporting at this interval */
+#define AUDIO_DRIFT 1.005
+#define AUDIO_PERIOD 0.01
+#define AUDIO_TIME 2.0
+
+/* the samples written ahead of the one heard, in seconds */
+#define AUDIO_DELAY 0.1
+
+/* how far the timeline may lag the fast device, in microseconds */
+#define AUDIO_BOUND 2000
+
+/* MPEG timestamps wrap at 33 bits */
+#define PTS_WRAP (INT64_C (1) << 33)
+
+
+
+typedef struct _Harness Harness;
+
+
+
+/*
+ * Harness:
+ * @clock: the #VClock pacing the sink.
+ * @frames: the amount of pictures to present.
+ * @step: the timestamp step between pictures, in 90 kHz units.
+ * @pending: the picture the sink waits to present.
+ *
+ * A source timestamping empty pictures and a sink presenting them at
+ * their time, with nothing to display them on.
+ */
+struct _Harness
+{
+	VClock *clock;
+	
+	unsigned int frames;
+	unsigned int sent;
+	int64_t step;
+	
+	VFrame *pending;
+	
+	
+	/* background tasks keep the workers busy while set */
+	int loading;
+	
+	pthread_mutex_t mutex;
+	pthread_cond_t  done;
+	bool ended;
+};
+
+
+
+
+static double
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+
+static bool
+produce (VNode *node, void *data)
+{
+	Harness *harness = (Harness *) data;
+	VFrameVideo *video;
+	
+	
+	if (harness->sent == harness->frames)
+		return false;
+	
+	video = v_frame_video_new ();
+	video->pts = harness->sent++ * harness->step;
+	
+	v_node_emit (node, V_FRAME (video));
+	
+	return true;
+}
+
+
+
+static void
+present (VNode *node, VFrame **frames, unsigned int count, void *data)
+{
+	Harness *harness = (Harness *) data;
+	
+	VFrame *frame = count > 0 ? frames[0] : harness->pending;
+	double delay;
+	
+	
+	harness->pending = NULL;
+	
+	delay = v_clock_get_delay (harness->clock, V_FRAME_VIDEO (frame)->pts);
+	
+	if (delay > 0)
+	{
+		harness->pending = frame;
+		v_node_wait (node, delay);
+		return;
+	}
+	
+	v_clock_present (harness->clock, V_FRAME_VIDEO (frame)->pts);
+	v_frame_free (frame);
+}
+
+
+
+static void
+ended (VPipeline *pipeline, void *data)
+{
+	Harness *harness = (Harness *) data;
+	
+	pthread_mutex_lock (&harness->mutex);
+	
+	harness->ended = true;
+	pthread_cond_signal (&harness->done);
+	
+	pthread_mutex_unlock (&harness->mutex);
+}
+
+
+
+/*
+ * check_delay:
+ * @clock: a #VClock.
+ * @pts: the timestamp to check.
+ * @expected: the delay expected until @pts, in seconds.
+ *
+ * Returns: the amount of failures, 0 or 1.
+ */
+static int
+check_delay (VClock *clock, int64_t pts, double expected)
+{
+	double delay = v_clock_get_delay (clock, pts);
+	
+	if (delay < expected - 0.05 || delay > expected + 0.05)
+	{
+		printf ("FAIL - pts %lld is due in %.3f s, expected %.3f s\n",
+				(long long) pts, delay, expected);
+		return 1;
+	}
+	
+	return 0;
+}
+
+
+
+
+/*
+ * check_wrap:
+ * @clock: a #VClock.
+ *
+ * Checks that timestamps crossing the 33 bit wrap carry on the timeline
+ * instead of restarting it, including a reordered one from before the
+ * wrap arriving after it.
+ *
+ * Returns: the amount of failures.
+ */
+static int
+check_wrap (VClock *clock)
+{
+	int failures = 0;
+	
+	v_clock_reset (clock);
+	
+	/* a second before the wrap starts the timeline */
+	failures += check_delay (clock, PTS_WRAP - 90000, 0);
+	failures += check_delay (clock, 45000, 1.5);
+	failures += check_delay (clock, PTS_WRAP - 45000, 0.5);
+	failures += check_delay (clock, 90000, 2);
+	
+	if (v_clock_pts_diff (100, PTS_WRAP - 100) != 200)
+	{
+		printf ("FAIL - the distance across the wrap is %lld\n",
+				(long long) v_clock_pts_diff (100, PTS_WRAP - 100));
+		failures++;
+	}
+	
+	v_clock_reset (clock);
+	
+	return failures;
+}
+
+
+
+
+/*
+ * check_audio_drift:
+ * @clock: a #VClock.
+ *
+ * Reports the position of a fake audio device running faster than the
+ * system clock, as a sound card off its own crystal would, and checks the
+ * timeline follows it closely instead of drifting off.
+ *
+ * Returns: the amount of failures.
+ */
+static int
+check_audio_drift (VClock *clock)
+{
+	struct timespec period = { 0, AUDIO_PERIOD * 1000000000 };
+	VClockStats stats;
+	
+	double start = get_time ();
+	double played = 0, delay;
+	int64_t heard = 0;
+	int failures = 0;
+	
+	
+	v_clock_reset (clock);
+	
+	/* the device has played further than the time passed */
+	while (played < AUDIO_TIME * AUDIO_DRIFT)
+	{
+		played = (get_time () - start) * AUDIO_DRIFT;
+		heard = (int64_t) (played * 90000);
+		
+		v_clock_set_audio (clock, heard + (int64_t) (AUDIO_DELAY * 90000), AUDIO_DELAY);
+		nanosleep (&period, NULL);
+	}
+	
+	
+	/* a picture timestamped with the sample heard now is due now */
+	v_clock_get_stats (clock, &stats);
+	
+	heard = (int64_t) ((get_time () - start) * AUDIO_DRIFT * 90000);
+	delay = v_clock_get_delay (clock, heard);
+	
+	printf ("audio %.1f%% fast, error %.1f us, picture with the audio due in %.1f us\n",
+			(AUDIO_DRIFT - 1) * 100, stats.audio_error, delay * 1000000);
+	
+	if (stats.audio_error > AUDIO_BOUND || stats.audio_error < -AUDIO_BOUND)
+	{
+		printf ("FAIL - audio error over %d us\n", AUDIO_BOUND);
+		failures++;
+	}
+	
+	if (delay * 1000000 > AUDIO_BOUND || delay * 1000000 < -AUDIO_BOUND)
+	{
+		printf ("FAIL - pictures drift off the audio\n");
+		failures++;
+	}
+	
+	v_clock_reset (clock);
+	
+	return failures;
+}
+
+
+
+
+/*
+ * load:
+ * @data: a #Harness.
+ *
+ * Spins for a while and queues itself again, standing in for the stages
+ * of other pipelines sharing the workers.
+ */
+static void
+load (void *data)
+{
+	Harness *harness = (Harness *) data;
+	double end = get_time () + LOAD_TASK;
+	
+	
+	while (get_time () < end);
+	
+	if (__atomic_load_n (&harness->loading, __ATOMIC_SEQ_CST))
+		v_thread_pool_push (v_thread_pool_get_default (), load, harness);
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	unsigned int frames = argc > 1 ? atoi (argv[1]) : 120;
+	double fps = argc > 2 ? atof (argv[2]) : 60;
+	int tasks = argc > 3 ? atoi (argv[3]) : v_thread_pool_cpu_count () * 2;
+	
+	Harness harness = { 0 };
+	VPipeline *pipeline = v_pipeline_new ();
+	VNode *source, *sink;
+	VClockStats stats;
+	
+	double start, elapsed;
+	int i, failures = 0;
+	
+	
+	harness.clock = v_clock_new (NULL);
+	harness.frames = frames;
+	harness.step = (int64_t) (90000 / fps);
+	
+	pthread_mutex_init (&harness.mutex, NULL);
+	pthread_cond_init  (&harness.done,  NULL);
+	
+	source = v_pipeline_add_source (pipeline, "source", produce, &harness);
+	sink = v_pipeline_add_node (pipeline, "sink", present, &harness);
+	
+	v_node_link (source, sink, 3);
+	v_pipeline_set_eos_func (pipeline, ended, &harness);
+	
+	
+	/* keep every worker busy, so a sink holding one would show up late */
+	harness.loading = 1;
+	
+	for (i = 0; i < tasks; i++)
+		v_thread_pool_push (v_thread_pool_get_default (), load, &harness);
+	
+	
+	printf ("%u pictures at %.1f frames/s, %d background tasks\n", frames, fps, tasks);
+	
+	start = get_time ();
+	v_pipeline_start (pipeline);
+	
+	pthread_mutex_lock (&harness.mutex);
+	
+	while (!harness.ended)
+		pthread_cond_wait (&harness.done, &harness.mutex);
+	
+	pthread_mutex_unlock (&harness.mutex);
+	
+	
+	v_clock_get_stats (harness.clock, &stats);
+	
+	printf ("took %.2f s, presented %u, late %u, early %u\n",
+			get_time () - start, stats.presented, stats.late, stats.early);
+	printf ("error mean %.1f us, max late %.1f us, max early %.1f us\n",
+			stats.mean_error, stats.max_late, stats.max_early);
+	
+	if (stats.presented != frames)
+	{
+		printf ("FAIL - %u of %u pictures presented\n", stats.presented, frames);
+		failures++;
+	}
+	
+	if (stats.mean_error > MEAN_BOUND || stats.max_late > LATE_BOUND)
+	{
+		printf ("FAIL - presentation error over %d us on average or %d us at worst\n",
+				MEAN_BOUND, LATE_BOUND);
+		failures++;
+	}
+	
+	
+	/* a sink waiting on a picture seconds away mustn't hold up a pause */
+	v_pipeline_pause (pipeline);
+	v_pipeline_flush (pipeline);
+	v_clock_reset (harness.clock);
+	
+	harness.sent = 0;
+	harness.frames = 2;
+	harness.step = 5 * 90000;
+	harness.ended = false;
+	
+	v_pipeline_start (pipeline);
+	
+	/* until the sink holds the second picture */
+	while (__atomic_load_n (&harness.pending, __ATOMIC_SEQ_CST) == NULL)
+	{
+		struct timespec ts = { 0, 1000000 };
+		nanosleep (&ts, NULL);
+	}
+	
+	start = get_time ();
+	v_pipeline_pause (pipeline);
+	elapsed = get_time () - start;
+	
+	printf ("pause with a picture due in 5 s took %.3f ms\n", elapsed * 1000);
+	
+	if (elapsed > PAUSE_BOUND)
+	{
+		printf ("FAIL - pause waited on the picture\n");
+		failures++;
+	}
+	
+	
+	__atomic_store_n (&harness.loading, 0, __ATOMIC_SEQ_CST);
+	
+	v_pipeline_flush (pipeline);
+	
+	if (harness.pending != NULL)
+		v_frame_free (harness.pending);
+	
+	v_pipeline_free (pipeline);
+	
+	
+	failures += check_wrap (harness.clock);
+	failures += check_audio_drift (harness.clock);
+	
+	v_clock_free (harness.clock);
+	
+	printf ("%d failures\n", failures);
+	
+	return failures > 0;
+}
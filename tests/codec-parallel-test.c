@@ -0,0 +1,374 @@
+/***************************************************************************
+ *            codec-parallel-test.c
+ *
+ *  Mon Oct 19 16:05:12 2026
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#ifdef HAVE_LIBAVCODEC_AVCODEC_H
+	#include <libavcodec/avcodec.h>
+#else
+	#include <ffmpeg/avcodec.h>
+#endif
+
+#include <villanova-engine/engine.h>
+#include <villanova-engine/codec.h>
+#include <villanova-engine/codec-parallel.h>
+#include <villanova-engine/demuxer.h>
+#include <villanova-engine/queue.h>
+
+
+
+/* the encoded test stream, long enough to be split into several segments */
+#define WIDTH  176
+#define HEIGHT 144
+#define FRAMES 400
+#define GOP    12
+
+/* the room for one encoded picture */
+#define OUTPUT_SIZE (1024 * 1024)
+
+/* the timestamp step between pictures, in 90 kHz units */
+#define PTS_STEP 3600
+
+
+
+typedef struct _Decoded Decoded;
+
+
+
+/*
+ * Decoded:
+ * @pts: the timestamp of each picture, in display order.
+ * @hash: a hash of the planes of each picture.
+ * @count: the amount of pictures.
+ *
+ * What came out of one of the decoders.
+ */
+struct _Decoded
+{
+	int64_t pts[FRAMES * 2];
+	uint32_t hash[FRAMES * 2];
+	int count;
+};
+
+
+
+
+static uint32_t
+hash_picture (VFrameVideo *video)
+{
+	uint32_t hash = 2166136261u;
+	int plane, x, y;
+	
+	for (plane = 0; plane < 3; plane++)
+	{
+		int w = plane ? (video->width + 1) / 2 : video->width;
+		int h = plane ? (video->height + 1) / 2 : video->height;
+		
+		for (y = 0; y < h; y++)
+			for (x = 0; x < w; x++)
+				hash = (hash ^ video->data[plane][y * video->linesize[plane] + x]) * 16777619u;
+	}
+	
+	return hash;
+}
+
+
+
+static void
+record (Decoded *decoded, VFrameVideo *video)
+{
+	if (decoded->count < FRAMES * 2)
+	{
+		decoded->pts[decoded->count] = video->pts;
+		decoded->hash[decoded->count] = hash_picture (video);
+	}
+	
+	decoded->count++;
+}
+
+
+
+static VFrameRaw *
+copy_raw (VFrameRaw *src)
+{
+	VFrameRaw *dst = v_frame_raw_new (src->length);
+	
+	memcpy (dst->data, src->data, src->length);
+	dst->stream_id = src->stream_id;
+	dst->pts = src->pts;
+	dst->dts = src->dts;
+	dst->key_frame = src->key_frame;
+	
+	return dst;
+}
+
+
+
+
+/*
+ * parse:
+ * @parser: the #VCodec parsing the stream.
+ * @data: encoded stream data.
+ * @length: the size of @data.
+ * @pts: the timestamp of the picture starting in @data.
+ * @frames: the queue of parsed frames.
+ *
+ * Passes encoder output through the parser the engine uses, which splits
+ * it into frames the way they come off a demuxed stream.
+ */
+static void
+parse (VCodec *parser, uint8_t *data, int length, int64_t pts, VQueue *frames)
+{
+	VPacket *packet = v_packet_new ();
+	
+	packet->codec_id = V_CODEC_ID_MPEG2;
+	packet->data = data;
+	packet->length = length;
+	packet->pts = pts;
+	packet->dts = pts;
+	
+	v_codec_parse (parser, packet, frames);
+	v_packet_free (packet);
+}
+
+
+
+
+/*
+ * encode_stream:
+ * @frames: the queue to add the parsed frames to.
+ *
+ * Encodes a moving picture into MPEG-2 with B pictures and open GOPs, so
+ * that segments after the first need priming with the GOP before them.
+ *
+ * Returns: %true if successful, %false otherwise.
+ */
+static bool
+encode_stream (VQueue *frames)
+{
+	static uint8_t end_code[] = { 0x00, 0x00, 0x01, 0xb7 };
+	
+	AVCodec *encoder = avcodec_find_encoder (CODEC_ID_MPEG2VIDEO);
+	AVCodecContext *ctx;
+	AVFrame *picture;
+	VCodec *parser;
+	
+	uint8_t *buffer, *output;
+	int i, x, y, size;
+	
+	
+	if (encoder == NULL)
+		return false;
+	
+	ctx = avcodec_alloc_context ();
+	
+	ctx->width = WIDTH;
+	ctx->height = HEIGHT;
+	ctx->time_base.num = 1;
+	ctx->time_base.den = 25;
+	ctx->gop_size = GOP;
+	ctx->max_b_frames = 2;
+	ctx->bit_rate = 1000000;
+	ctx->pix_fmt = PIX_FMT_YUV420P;
+	
+	if (avcodec_open (ctx, encoder) < 0)
+	{
+		av_free (ctx);
+		return false;
+	}
+	
+	
+	parser = v_codec_new (V_CODEC_ID_MPEG2, NULL);
+	picture = avcodec_alloc_frame ();
+	
+	buffer = malloc (avpicture_get_size (PIX_FMT_YUV420P, WIDTH, HEIGHT));
+	output = malloc (OUTPUT_SIZE);
+	
+	avpicture_fill ((AVPicture *) picture, buffer, PIX_FMT_YUV420P, WIDTH, HEIGHT);
+	
+	
+	for (i = 0; i <= FRAMES; i++)
+	{
+		/* no more pictures, drain the delayed ones */
+		AVFrame *input = NULL;
+		
+		if (i < FRAMES)
+		{
+			for (y = 0; y < HEIGHT; y++)
+				for (x = 0; x < WIDTH; x++)
+					picture->data[0][y * picture->linesize[0] + x] = x + y + i * 3;
+			
+			for (y = 0; y < HEIGHT / 2; y++)
+				for (x = 0; x < WIDTH / 2; x++)
+				{
+					picture->data[1][y * picture->linesize[1] + x] = 128 + y + i * 2;
+					picture->data[2][y * picture->linesize[2] + x] = 64 + x + i * 5;
+				}
+			
+			picture->pts = i;
+			input = picture;
+		}
+		
+		while ((size = avcodec_encode_video (ctx, output, OUTPUT_SIZE, input)) > 0)
+		{
+			parse (parser, output, size, ctx->coded_frame->pts * PTS_STEP, frames);
+			
+			if (input != NULL)
+				break;
+		}
+	}
+	
+	/* the end code completes the last picture in the parser */
+	parse (parser, end_code, sizeof (end_code), V_NO_PTS, frames);
+	
+	
+	v_codec_free (parser);
+	avcodec_close (ctx);
+	av_free (ctx);
+	av_free (picture);
+	free (buffer);
+	free (output);
+	
+	return true;
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	static Decoded serial, parallel;
+	
+	VQueue *frames = v_queue_new (0);
+	VFrameRaw **stream = NULL;
+	VFrameRaw *raw;
+	
+	VCodec *codec;
+	VCodecParallel *decoder;
+	VFrameVideo *video;
+	VFrame *out;
+	
+	int count = 0, i, failures = 0;
+	
+	
+	v_engine_init ();
+	avcodec_register_all ();
+	
+	if (!encode_stream (frames))
+	{
+		printf ("FAIL - could not encode an MPEG-2 test stream\n");
+		return 1;
+	}
+	
+	while ((raw = v_queue_dequeue (frames)) != NULL)
+	{
+		stream = realloc (stream, (count + 1) * sizeof (VFrameRaw *));
+		stream[count++] = raw;
+	}
+	
+	
+	/* decode on a single decoder, as the engine does */
+	codec = v_codec_new (V_CODEC_ID_MPEG2, NULL);
+	
+	for (i = 0; i <= count; i++)
+	{
+		/* an empty frame returns the last delayed picture */
+		VFrameRaw *end = v_frame_raw_new (0);
+		VFrameRaw *in = i < count ? stream[i] : end;
+		
+		end->pts = -1;
+		out = v_codec_decode (codec, V_FRAME (in), NULL);
+		
+		if (out != NULL)
+		{
+			record (&serial, V_FRAME_VIDEO (out));
+			v_frame_free (out);
+		}
+		
+		v_frame_free (V_FRAME (end));
+	}
+	
+	v_codec_free (codec);
+	
+	
+	/* decode the same frames split into segments on several decoders */
+	decoder = v_codec_parallel_new (V_CODEC_ID_MPEG2, 3, NULL);
+	
+	for (i = 0; i < count; i++)
+		v_codec_parallel_push (decoder, copy_raw (stream[i]));
+	
+	v_codec_parallel_finish (decoder);
+	
+	while ((video = v_codec_parallel_pop (decoder)) != NULL)
+	{
+		record (&parallel, video);
+		v_frame_free (V_FRAME (video));
+	}
+	
+	v_codec_parallel_free (decoder);
+	
+	
+	/* same pictures, same timestamps, same order */
+	if (serial.count != FRAMES)
+	{
+		printf ("FAIL - %d of %d pictures decoded serially\n", serial.count, FRAMES);
+		failures++;
+	}
+	
+	if (parallel.count != serial.count)
+	{
+		printf ("FAIL - %d pictures decoded in parallel, %d serially\n",
+				parallel.count, serial.count);
+		failures++;
+	}
+	
+	for (i = 0; i < serial.count && i < parallel.count && i < FRAMES * 2; i++)
+	{
+		if (serial.pts[i] != parallel.pts[i] || serial.hash[i] != parallel.hash[i])
+		{
+			printf ("FAIL - picture %d differs: pts %lld/%lld, hash %08x/%08x\n", i,
+					(long long) serial.pts[i], (long long) parallel.pts[i],
+					serial.hash[i], parallel.hash[i]);
+			failures++;
+		}
+	}
+	
+	
+	for (i = 0; i < count; i++)
+		v_frame_free (V_FRAME (stream[i]));
+	
+	free (stream);
+	v_queue_free (frames);
+	
+	printf ("%d frames, %d pictures decoded, %d failures\n", count, parallel.count, failures);
+	
+	return failures > 0;
+}
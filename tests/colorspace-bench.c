@@ -0,0 +1,120 @@
+/***************************************************************************
+ *            colorspace-bench.c
+ *
+ *  Oct 19, 2026 11:12:37 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <villanova-engine/colorspace.h>
+
+
+
+/* frames converted per measurement */
+#define FRAMES 50
+
+
+
+static double
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	static const char *names[] = { "fast-bilinear", "area", "bicubic" };
+	static const VScalePreset presets[] = { V_SCALE_PRESET_FAST_BILINEAR,
+	                                        V_SCALE_PRESET_AREA,
+	                                        V_SCALE_PRESET_BICUBIC };
+	
+	int width  = argc > 4 ? atoi (argv[1]) : 1920;
+	int height = argc > 4 ? atoi (argv[2]) : 1080;
+	int dest_width  = argc > 4 ? atoi (argv[3]) : 1280;
+	int dest_height = argc > 4 ? atoi (argv[4]) : 720;
+	
+	VFramePool  *pool  = v_frame_pool_new (V_PIXEL_FORMAT_YUV420, width, height);
+	VFrameVideo *frame = v_frame_pool_get (pool);
+	
+	uint8_t *dest[4] = { NULL, NULL, NULL, NULL };
+	int dest_linesize[4] = { dest_width * 4, 0, 0, 0 };
+	
+	int p, i;
+	
+	
+	/* a gradient gives the filters something to work on */
+	for (i = 0; i < height; i++)
+		memset (frame->data[0] + i * frame->linesize[0], i & 0xff, width);
+	
+	for (i = 0; i < (height + 1) / 2; i++)
+	{
+		memset (frame->data[1] + i * frame->linesize[1], 0x80, (width + 1) / 2);
+		memset (frame->data[2] + i * frame->linesize[2], i & 0xff, (width + 1) / 2);
+	}
+	
+	dest[0] = malloc (dest_linesize[0] * dest_height);
+	
+	
+	printf ("%dx%d yuv420 -> %dx%d rgb32, ms/frame\n",
+			width, height, dest_width, dest_height);
+	
+	for (p = 0; p < 3; p++)
+	{
+		VColorspace *colorspace = v_colorspace_new_scaled (V_PIXEL_FORMAT_YUV420,
+				V_PIXEL_FORMAT_RGB32, width, height, dest_width, dest_height,
+				presets[p], NULL);
+		
+		double start;
+		
+		
+		/* the first frame sets up the filters */
+		v_colorspace_convert_into (colorspace, V_FRAME (frame), dest, dest_linesize);
+		
+		start = get_time ();
+		
+		for (i = 0; i < FRAMES; i++)
+			v_colorspace_convert_into (colorspace, V_FRAME (frame), dest, dest_linesize);
+		
+		printf ("%-14s%8.3f\n", names[p], (get_time () - start) * 1000 / FRAMES);
+		
+		v_colorspace_free (colorspace);
+	}
+	
+	
+	free (dest[0]);
+	
+	v_frame_free (V_FRAME (frame));
+	v_frame_pool_free (pool);
+	
+	return 0;
+}
@@ -0,0 +1,273 @@
+/***************************************************************************
+ *            compositor-test.c
+ *
+ *  Oct 19, 2026 11:31:04 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <villanova-engine/compositor.h>
+#include <villanova-engine/mem.h>
+
+#include "picture.h"
+
+
+
+/* kernels checked against the scalar one */
+static const char *kernels[] = { "sse2" };
+
+
+
+/*
+ * picture_convert:
+ * @format: the #VPixelFormat to convert to.
+ *
+ * Converts a YUV420 picture into a fresh picture in @format.
+ */
+static void
+picture_convert (Picture *dest, Picture *src, VPixelFormat format)
+{
+	picture_alloc (dest, format, src->width, src->height);
+	
+	switch (format)
+	{
+		case V_PIXEL_FORMAT_NV12:
+			v_convert_yuv420_to_nv12 (src->data, src->linesize,
+					dest->data, dest->linesize, src->width, src->height);
+			break;
+			
+		case V_PIXEL_FORMAT_YUY2:
+			v_convert_yuv420_to_yuy2 (src->data, src->linesize,
+					dest->data, dest->linesize, src->width, src->height);
+			break;
+			
+		case V_PIXEL_FORMAT_UYVY:
+			v_convert_yuv420_to_uyvy (src->data, src->linesize,
+					dest->data, dest->linesize, src->width, src->height);
+			break;
+			
+		default:
+			break;
+	}
+}
+
+
+
+
+/*
+ * subpicture_new:
+ * @pal8: whether to create a palette subpicture rather than RGB32.
+ *
+ * Creates a random subpicture. A quarter of the pixels are transparent
+ * and a quarter opaque, so that the kernel skips and blends whole spans.
+ */
+static VFrameSubtitle *
+subpicture_new (bool pal8, int x, int y, int w, int h)
+{
+	VFrameSubtitle *sub = v_frame_subtitle_new ();
+	int linesize = pal8 ? w : w * 4;
+	int i;
+	
+	
+	sub->x = x;
+	sub->y = y;
+	sub->w = w;
+	sub->h = h;
+	sub->pixel_format = pal8 ? V_PIXEL_FORMAT_PAL8 : V_PIXEL_FORMAT_RGB32;
+	
+	/* the palette follows the indices, aligned for 32 bit reads */
+	int palette = (linesize * h + 3) & ~3;
+	
+	sub->buffer = v_malloc (palette + 256 * 4);
+	sub->linesize[0] = linesize;
+	sub->data[0] = sub->buffer;
+	sub->data[1] = pal8 ? sub->buffer + palette : NULL;
+	
+	
+	uint32_t *pixels = pal8 ? (uint32_t *) sub->data[1] : (uint32_t *) sub->data[0];
+	int count = pal8 ? 256 : w * h;
+	
+	for (i = 0; i < count; i++)
+	{
+		uint32_t alpha;
+		
+		switch (rand () % 4)
+		{
+		case 0:  alpha = 0;            break;
+		case 1:  alpha = 255;          break;
+		default: alpha = rand () % 256; break;
+		}
+		
+		pixels[i] = (alpha << 24) | (rand () & 0xffffff);
+	}
+	
+	if (pal8)
+		for (i = 0; i < w * h; i++)
+			sub->data[0][i] = rand ();
+	
+	
+	return sub;
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	int k, run, failures = 0, checked = 0;
+	
+	
+	srand (1);
+	
+	for (k = 0; k < sizeof (kernels) / sizeof (kernels[0]); k++)
+	{
+		if (!v_compositor_set_kernel (kernels[k]))
+		{
+			printf ("%-5s not supported, skipped\n", kernels[k]);
+			continue;
+		}
+		
+		
+		for (run = 0; run < 500; run++)
+		{
+			/* odd sizes and offsets exercise the chroma alignment and the
+			 * scalar tails, and some overlays hang off the picture */
+			int width  = run < 2 ? 1920 : 1 + rand () % 161;
+			int height = run < 2 ? 1080 : 1 + rand () % 41;
+			
+			int w = 1 + rand () % (width + 8);
+			int h = 1 + rand () % (height + 8);
+			int x = rand () % (width + 4);
+			int y = rand () % (height + 4);
+			
+			VFrameSubtitle *sub = subpicture_new (run % 2, x, y, w, h);
+			VCompositor *compositor = v_compositor_new ();
+			Picture src, ref, out;
+			
+			
+			v_compositor_set_matrix (compositor,
+					run % 4 < 2 ? V_COLOR_MATRIX_BT601 : V_COLOR_MATRIX_BT709);
+			v_compositor_set_subpicture (compositor, sub);
+			
+			picture_alloc (&src, V_PIXEL_FORMAT_YUV420, width, height);
+			picture_fill (&src);
+			
+			picture_copy (&ref, &src);
+			picture_copy (&out, &src);
+			
+			
+			v_compositor_set_kernel ("c");
+			v_compositor_blend (compositor, V_PIXEL_FORMAT_YUV420,
+					ref.data, ref.linesize, width, height);
+			
+			v_compositor_set_kernel (kernels[k]);
+			v_compositor_blend (compositor, V_PIXEL_FORMAT_YUV420,
+					out.data, out.linesize, width, height);
+			
+			if (!picture_equal (&ref, &out))
+			{
+				printf ("FAIL - %s %dx%d overlay at %d,%d differs on a %dx%d picture\n",
+						kernels[k], w, h, x, y, width, height);
+				failures++;
+			}
+			
+			checked++;
+			
+			
+			picture_free (&src);
+			picture_free (&ref);
+			picture_free (&out);
+			
+			v_compositor_free (compositor);
+			v_frame_free (V_FRAME (sub));
+		}
+		
+		printf ("%-5s checked against c\n", kernels[k]);
+	}
+	
+	
+	/* blending into another layout must match blending into YUV420 and
+	 * converting afterwards, as the conversions only move samples around */
+	for (k = 0; k < 3; k++)
+	{
+		static const char *names[] = { "nv12", "yuy2", "uyvy" };
+		static const VPixelFormat formats[] = { V_PIXEL_FORMAT_NV12,
+		                                        V_PIXEL_FORMAT_YUY2,
+		                                        V_PIXEL_FORMAT_UYVY };
+		
+		for (run = 0; run < 200; run++)
+		{
+			int width  = 1 + rand () % 161;
+			int height = 1 + rand () % 41;
+			
+			int w = 1 + rand () % (width + 8);
+			int h = 1 + rand () % (height + 8);
+			int x = rand () % (width + 4);
+			int y = rand () % (height + 4);
+			
+			VFrameSubtitle *sub = subpicture_new (run % 2, x, y, w, h);
+			VCompositor *compositor = v_compositor_new ();
+			Picture src, ref, out;
+			
+			
+			v_compositor_set_subpicture (compositor, sub);
+			
+			picture_alloc (&src, V_PIXEL_FORMAT_YUV420, width, height);
+			picture_fill (&src);
+			
+			picture_convert (&out, &src, formats[k]);
+			v_compositor_blend (compositor, formats[k], out.data, out.linesize, width, height);
+			
+			v_compositor_blend (compositor, V_PIXEL_FORMAT_YUV420,
+					src.data, src.linesize, width, height);
+			picture_convert (&ref, &src, formats[k]);
+			
+			if (!picture_equal (&ref, &out))
+			{
+				printf ("FAIL - %dx%d overlay at %d,%d differs on a %dx%d %s picture\n",
+						w, h, x, y, width, height, names[k]);
+				failures++;
+			}
+			
+			checked++;
+			
+			
+			picture_free (&src);
+			picture_free (&ref);
+			picture_free (&out);
+			
+			v_compositor_free (compositor);
+			v_frame_free (V_FRAME (sub));
+		}
+		
+		printf ("%-5s checked against yuv420\n", names[k]);
+	}
+	
+	
+	printf ("%d blends, %d failures\n", checked, failures);
+	
+	return failures > 0;
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+ *            convert-bench.c
+ *
+ *  Oct 19, 2026 7:52:41 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <villanova-engine/convert.h>
+
+
+
+/* frames converted per measurement */
+#define FRAMES 100
+
+
+
+static double
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	static const char *kernels[] = { "c", "sse2", "avx2" };
+	static const char *names[] = { "yuv420->rgb32", "rgb32->yuv420",
+	                               "yuv420->nv12", "yuv420->yuy2",
+	                               "yuv420->uyvy" };
+	
+	int width  = argc > 2 ? atoi (argv[1]) : 1920;
+	int height = argc > 2 ? atoi (argv[2]) : 1080;
+	
+	uint8_t *yuv[4], *rgb[4], *out[4];
+	int yuv_linesize[4] = { width, (width + 1) / 2, (width + 1) / 2, 0 };
+	int rgb_linesize[4] = { width * 4, 0, 0, 0 };
+	int out_linesize[4] = { width * 2, width + 1, 0, 0 };
+	
+	int k, type, i;
+	
+	
+	yuv[0] = calloc (width, height);
+	yuv[1] = calloc (yuv_linesize[1], (height + 1) / 2);
+	yuv[2] = calloc (yuv_linesize[2], (height + 1) / 2);
+	yuv[3] = NULL;
+	
+	rgb[0] = calloc (rgb_linesize[0], height);
+	rgb[1] = rgb[2] = rgb[3] = NULL;
+	
+	/* big enough for any of the YUV outputs */
+	out[0] = calloc (out_linesize[0], height);
+	out[1] = calloc (out_linesize[1], (height + 1) / 2);
+	out[2] = calloc (yuv_linesize[2], (height + 1) / 2);
+	out[3] = NULL;
+	
+	
+	printf ("%dx%d, ms/frame\n", width, height);
+	printf ("%-14s", "");
+	
+	for (k = 0; k < 3; k++)
+		printf ("%8s", kernels[k]);
+	
+	printf ("\n");
+	
+	
+	for (type = 0; type < 5; type++)
+	{
+		printf ("%-14s", names[type]);
+		
+		for (k = 0; k < 3; k++)
+		{
+			double start;
+			
+			if (!v_convert_set_kernel (kernels[k]))
+			{
+				printf ("%8s", "-");
+				continue;
+			}
+			
+			
+			start = get_time ();
+			
+			for (i = 0; i < FRAMES; i++)
+			{
+				switch (type)
+				{
+				case 0:
+					v_convert_yuv420_to_rgb32 (yuv, yuv_linesize, rgb, rgb_linesize,
+							width, height, V_COLOR_MATRIX_BT601);
+					break;
+					
+				case 1:
+					v_convert_rgb32_to_yuv420 (rgb, rgb_linesize, out, yuv_linesize,
+							width, height, V_COLOR_MATRIX_BT601);
+					break;
+					
+				case 2:
+					v_convert_yuv420_to_nv12 (yuv, yuv_linesize, out, out_linesize,
+							width, height);
+					break;
+					
+				case 3:
+					v_convert_yuv420_to_yuy2 (yuv, yuv_linesize, out, out_linesize,
+							width, height);
+					break;
+					
+				case 4:
+					v_convert_yuv420_to_uyvy (yuv, yuv_linesize, out, out_linesize,
+							width, height);
+					break;
+				}
+			}
+			
+			printf ("%8.3f", (get_time () - start) * 1000 / FRAMES);
+		}
+		
+		printf ("\n");
+	}
+	
+	
+	for (i = 0; i < 3; i++)
+	{
+		free (yuv[i]);
+		free (out[i]);
+	}
+	
+	free (rgb[0]);
+	
+	return 0;
+}
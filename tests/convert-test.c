@@ -0,0 +1,155 @@
+/***************************************************************************
+ *            convert-test.c
+ *
+ *  Oct 19, 2026 7:45:08 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <villanova-engine/convert.h>
+
+#include "picture.h"
+
+
+
+/* kernels checked against the scalar one */
+static const char *kernels[] = { "sse2", "avx2" };
+
+
+
+/*
+ * convert:
+ * @kernel: the kernel to use.
+ * @type: the conversion to run.
+ *
+ * Runs one of the conversions with @kernel into a fresh picture.
+ */
+static void
+convert (const char *kernel, int type, Picture *src, Picture *dest,
+         int width, int height, VColorMatrix matrix)
+{
+	v_convert_set_kernel (kernel);
+	
+	switch (type)
+	{
+	case 0:
+		picture_alloc (dest, V_PIXEL_FORMAT_RGB32, width, height);
+		v_convert_yuv420_to_rgb32 (src->data, src->linesize,
+				dest->data, dest->linesize, width, height, matrix);
+		break;
+		
+	case 1:
+		picture_alloc (dest, V_PIXEL_FORMAT_YUV420, width, height);
+		v_convert_rgb32_to_yuv420 (src->data, src->linesize,
+				dest->data, dest->linesize, width, height, matrix);
+		break;
+		
+	case 2:
+		picture_alloc (dest, V_PIXEL_FORMAT_NV12, width, height);
+		v_convert_yuv420_to_nv12 (src->data, src->linesize,
+				dest->data, dest->linesize, width, height);
+		break;
+		
+	case 3:
+		picture_alloc (dest, V_PIXEL_FORMAT_YUY2, width, height);
+		v_convert_yuv420_to_yuy2 (src->data, src->linesize,
+				dest->data, dest->linesize, width, height);
+		break;
+		
+	case 4:
+		picture_alloc (dest, V_PIXEL_FORMAT_UYVY, width, height);
+		v_convert_yuv420_to_uyvy (src->data, src->linesize,
+				dest->data, dest->linesize, width, height);
+		break;
+	}
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	static const char *names[] = { "yuv420->rgb32", "rgb32->yuv420",
+	                               "yuv420->nv12", "yuv420->yuy2",
+	                               "yuv420->uyvy" };
+	
+	int k, type, run, failures = 0, checked = 0;
+	
+	
+	srand (1);
+	
+	for (k = 0; k < sizeof (kernels) / sizeof (kernels[0]); k++)
+	{
+		if (!v_convert_set_kernel (kernels[k]))
+		{
+			printf ("%-5s not supported, skipped\n", kernels[k]);
+			continue;
+		}
+		
+		
+		for (run = 0; run < 200; run++)
+		{
+			/* odd sizes exercise the scalar tails of each row */
+			int width  = run < 2 ? 1920 : 1 + rand () % 131;
+			int height = run < 2 ? 1080 : 1 + rand () % 23;
+			VColorMatrix matrix = run % 2 ? V_COLOR_MATRIX_BT709 : V_COLOR_MATRIX_BT601;
+			
+			
+			for (type = 0; type < 5; type++)
+			{
+				Picture src, ref, out;
+				
+				picture_alloc (&src, type == 1 ? V_PIXEL_FORMAT_RGB32 :
+						V_PIXEL_FORMAT_YUV420, width, height);
+				picture_fill (&src);
+				
+				convert ("c", type, &src, &ref, width, height, matrix);
+				convert (kernels[k], type, &src, &out, width, height, matrix);
+				
+				
+				if (!picture_equal (&ref, &out))
+				{
+					printf ("FAIL - %s %s differs at %dx%d\n",
+							kernels[k], names[type], width, height);
+					failures++;
+				}
+				
+				checked++;
+				
+				picture_free (&src);
+				picture_free (&ref);
+				picture_free (&out);
+			}
+		}
+		
+		printf ("%-5s checked against c\n", kernels[k]);
+	}
+	
+	
+	printf ("%d conversions, %d failures\n", checked, failures);
+	
+	return failures > 0;
+}
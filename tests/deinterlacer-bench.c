@@ -0,0 +1,122 @@
+/***************************************************************************
+ *            deinterlacer-bench.c
+ *
+ *  Oct 19, 2026 11:48:22 AM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <villanova-engine/deinterlacer.h>
+
+
+
+/* frames deinterlaced per measurement */
+#define FRAMES 100
+
+
+
+static double
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	static const char *names[] = { "bob", "blend", "adaptive" };
+	static const VDeinterlaceMode modes[] = { V_DEINTERLACE_MODE_BOB,
+	                                          V_DEINTERLACE_MODE_BLEND,
+	                                          V_DEINTERLACE_MODE_ADAPTIVE };
+	
+	static const char *format_names[] = { "yuv420", "rgb32" };
+	static const VPixelFormat formats[] = { V_PIXEL_FORMAT_YUV420,
+	                                        V_PIXEL_FORMAT_RGB32 };
+	
+	int width  = argc > 2 ? atoi (argv[1]) : 1920;
+	int height = argc > 2 ? atoi (argv[2]) : 1080;
+	
+	int f, m, i, j;
+	
+	
+	printf ("%dx%d\n", width, height);
+	printf ("%-16s%10s%10s\n", "", "ms/frame", "frames/s");
+	
+	for (f = 0; f < 2; f++)
+	{
+		uint8_t *data[4] = { NULL, NULL, NULL, NULL };
+		int linesize[4] = { 0, 0, 0, 0 };
+		int size[4] = { 0, 0, 0, 0 };
+		int bytes, lines;
+		
+		
+		for (i = 0; v_pixel_format_get_plane (formats[f], i, width, height, &bytes, &lines); i++)
+		{
+			linesize[i] = bytes;
+			size[i] = bytes * lines;
+			data[i] = calloc (size[i], 1);
+		}
+		
+		
+		for (m = 0; m < 3; m++)
+		{
+			VDeinterlacer *deinterlacer = v_deinterlacer_new (modes[m]);
+			double start, elapsed = 0;
+			
+			
+			for (j = 0; j < FRAMES; j++)
+			{
+				/* fresh content each frame keeps the adaptive mode from
+				 * seeing a still picture */
+				for (i = 0; i < 4; i++)
+					if (data[i] != NULL)
+						data[i][(j * 7919) % size[i]] = rand ();
+				
+				start = get_time ();
+				v_deinterlacer_process (deinterlacer, formats[f], data, linesize,
+						width, height, j % 2 == 0);
+				elapsed += get_time () - start;
+			}
+			
+			printf ("%-6s %-9s%10.3f%10.1f\n", format_names[f], names[m],
+					elapsed * 1000 / FRAMES, FRAMES / elapsed);
+			
+			v_deinterlacer_free (deinterlacer);
+		}
+		
+		
+		for (i = 0; i < 4; i++)
+			free (data[i]);
+	}
+	
+	
+	return 0;
+}
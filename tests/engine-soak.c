@@ -0,0 +1,215 @@
+/***************************************************************************
+ *            engine-soak.c
+ *
+ *  Oct 19, 2026 3:12:40 PM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <villanova-engine/error.h>
+#include <villanova-engine/engine.h>
+
+
+
+/* the titles opened and closed by default */
+#define SOAK_TITLES 10000
+
+/* where each title is seeked to once playing, in seconds */
+#define SOAK_SEEK 1.0
+
+/* how long to wait for the first picture after a seek, in seconds */
+#define SOAK_PICTURE_TIMEOUT 1.0
+
+/* titles between progress reports */
+#define SOAK_REPORT 1000
+
+/* how much resident memory may grow past the first title, in KiB, allowing
+ * for the decoders, conversions and pictures kept for reuse */
+#define SOAK_RESIDENT_GROWTH 8192
+
+
+
+
+static double
+get_time (void)
+{
+	struct timespec ts;
+	
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+
+/*
+ * get_resident:
+ *
+ * Returns: the resident memory of the process in KiB, 0 if unknown.
+ */
+static long
+get_resident (void)
+{
+	FILE *file = fopen ("/proc/self/statm", "r");
+	long size = 0, resident = 0;
+	
+	if (file == NULL)
+		return 0;
+	
+	if (fscanf (file, "%ld %ld", &size, &resident) != 2)
+		resident = 0;
+	
+	fclose (file);
+	return resident * (sysconf (_SC_PAGESIZE) / 1024);
+}
+
+
+
+
+/*
+ * play_title:
+ * @engine: a #VEngine.
+ * @protocol: the input protocol.
+ * @uri: the media to open.
+ * @err: a #VError.
+ *
+ * Opens the media as a new title, plays it, seeks into it and waits for
+ * the first picture after the seek before closing it again.
+ *
+ * Returns: %true if the title opened and played, %false otherwise.
+ */
+static bool
+play_title (VEngine *engine, const char *protocol, const char *uri, VError *err)
+{
+	VEngineStats stats;
+	unsigned int seeks;
+	double start;
+	bool ret = false;
+	
+	
+	if (!v_engine_open (engine, protocol, uri, err))
+		return false;
+	
+	if (v_engine_play (engine, err))
+	{
+		v_engine_get_stats (engine, &stats);
+		seeks = stats.seeks;
+		
+		if (v_engine_seek (engine, SOAK_SEEK, err))
+		{
+			start = get_time ();
+			
+			do
+			{
+				usleep (1000);
+				v_engine_get_stats (engine, &stats);
+			}
+			while (stats.seeks == seeks && get_time () - start < SOAK_PICTURE_TIMEOUT);
+		}
+		
+		ret = true;
+	}
+	
+	v_engine_close (engine);
+	return ret;
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		printf ("usage: %s protocol uri [titles] [--unpaced]\n", argv[0]);
+		return 1;
+	}
+	
+	
+	const char *protocol = argv[1];
+	const char *uri = argv[2];
+	
+	unsigned int titles = argc > 3 ? strtoul (argv[3], NULL, 10) : SOAK_TITLES;
+	unsigned int i, failed = 0;
+	
+	VEngineStats stats;
+	long resident = 0, first = 0;
+	bool leaked;
+	double start;
+	
+	
+	v_engine_init ();
+	
+	VError *err = v_error_new ();
+	VEngine *engine = v_engine_new ();
+	
+	/* decode as fast as possible, leaving the time to the first picture */
+	if (argc > 4 && strcmp (argv[4], "--unpaced") == 0)
+		v_engine_set_paced (engine, false);
+	
+	
+	start = get_time ();
+	
+	for (i = 1; i <= titles; i++)
+	{
+		if (!play_title (engine, protocol, uri, err))
+			failed++;
+		
+		
+		/* resident memory settles after the first title */
+		if (i == 1)
+			first = get_resident ();
+		
+		if (i % SOAK_REPORT == 0 || i == titles)
+		{
+			resident = get_resident ();
+			
+			printf ("%6u titles  %6.1f s  resident=%ld KiB (%+ld KiB since the first title)\n",
+					i, get_time () - start, resident, resident - first);
+		}
+	}
+	
+	
+	v_engine_get_stats (engine, &stats);
+	
+	/* memory stays flat once the caches are filled */
+	leaked = first > 0 && resident - first > SOAK_RESIDENT_GROWTH;
+	
+	printf ("failed titles=%u\n", failed);
+	printf ("resident growth=%ld KiB, bound=%d KiB%s\n", resident - first,
+			SOAK_RESIDENT_GROWTH, leaked ? " - FAIL" : "");
+	printf ("seeks=%u, over %.0f ms=%u, last=%.1f ms, mean=%.1f ms, max=%.1f ms\n",
+			stats.seeks, V_ENGINE_SEEK_TARGET * 1000, stats.slow_seeks,
+			stats.seek_latency * 1000, stats.mean_seek_latency * 1000,
+			stats.max_seek_latency * 1000);
+	
+	
+	v_error_free (err);
+	v_engine_free (engine);
+	
+	return failed > 0 || stats.slow_seeks > 0 || leaked;
+}
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *            picture.c
+ *
+ *  Mon Oct 19 16:41:27 2026
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include "picture.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+
+/**
+ * picture_alloc:
+ * @pic: the #Picture to set up.
+ * @format: the #VPixelFormat of the picture.
+ * @width: the picture width.
+ * @height: the picture height.
+ *
+ * Allocates zeroed, padded planes for a picture in @format.
+ */
+void
+picture_alloc (Picture *pic, VPixelFormat format, int width, int height)
+{
+	int bytes, lines, i;
+	
+	memset (pic, 0, sizeof (Picture));
+	
+	pic->format = format;
+	pic->width = width;
+	pic->height = height;
+	
+	for (i = 0; v_pixel_format_get_plane (format, i, width, height, &bytes, &lines); i++)
+	{
+		pic->linesize[i] = bytes + 16 + i * 4;
+		pic->size[i] = pic->linesize[i] * lines;
+		pic->data[i] = calloc (pic->size[i], 1);
+	}
+}
+
+
+
+
+/**
+ * picture_free:
+ * @pic: a #Picture.
+ *
+ * Frees the planes of @pic.
+ */
+void
+picture_free (Picture *pic)
+{
+	int i;
+	
+	for (i = 0; i < 4; i++)
+		free (pic->data[i]);
+}
+
+
+
+
+/**
+ * picture_fill:
+ * @pic: a #Picture.
+ *
+ * Fills every plane of @pic with random samples, padding included.
+ */
+void
+picture_fill (Picture *pic)
+{
+	int i, j;
+	
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < pic->size[i]; j++)
+			pic->data[i][j] = rand ();
+}
+
+
+
+
+/**
+ * picture_copy:
+ * @dest: the #Picture to set up.
+ * @src: the #Picture to copy.
+ *
+ * Allocates @dest like @src and copies its planes over.
+ */
+void
+picture_copy (Picture *dest, Picture *src)
+{
+	int i;
+	
+	picture_alloc (dest, src->format, src->width, src->height);
+	
+	for (i = 0; i < 4; i++)
+		if (src->size[i])
+			memcpy (dest->data[i], src->data[i], src->size[i]);
+}
+
+
+
+
+/**
+ * picture_equal:
+ * @a: a #Picture.
+ * @b: another #Picture of the same format and size.
+ *
+ * Returns: %true if every plane of @a and @b matches, padding included.
+ */
+bool
+picture_equal (Picture *a, Picture *b)
+{
+	int i;
+	
+	for (i = 0; i < 4; i++)
+		if (a->size[i] != b->size[i] ||
+		    (a->size[i] && memcmp (a->data[i], b->data[i], a->size[i]) != 0))
+			return false;
+	
+	return true;
+}
@@ -0,0 +1,76 @@
+/***************************************************************************
+ *            picture.h
+ *
+ *  Mon Oct 19 16:41:27 2026
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#ifndef V_TEST_PICTURE_H_
+#define V_TEST_PICTURE_H_
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <villanova-engine/codec-types.h>
+
+
+
+typedef struct _Picture Picture;
+
+
+/**
+ * Picture:
+ * @format: the #VPixelFormat of the planes.
+ * @width: the picture width.
+ * @height: the picture height.
+ * @data: the picture planes.
+ * @linesize: the size of a line for each plane.
+ * @size: the size of each plane, including the line padding.
+ *
+ * A test picture whose lines are padded differently on each plane, so that
+ * kernels reading or writing past the picture width show up as differences
+ * when two pictures are compared.
+ */
+struct _Picture
+{
+	VPixelFormat format;
+	int width;
+	int height;
+	
+	uint8_t *data[4];
+	int linesize[4];
+	int size[4];
+};
+
+
+
+void picture_alloc (Picture *pic, VPixelFormat format, int width, int height);
+void picture_free  (Picture *pic);
+
+void picture_fill  (Picture *pic);
+void picture_copy  (Picture *dest, Picture *src);
+bool picture_equal (Picture *a, Picture *b);
+
+
+
+#endif /* V_TEST_PICTURE_H_ */
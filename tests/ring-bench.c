@@ -0,0 +1,199 @@
+/***************************************************************************
+ *            ring-bench.c
+ *
+ *  Oct 19, 2026 12:07:45 PM
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <villanova-engine/ring.h>
+#include <villanova-engine/async-queue.h>
+
+
+
+typedef struct _Bench Bench;
+
+
+
+/*
+ * Bench:
+ * @ring: the ring under test, or %NULL when testing @queue.
+ * @queue: the queue under test.
+ * @count: the amount of items passed through.
+ * @sent: the time each item was pushed, indexed by item.
+ *
+ * A single producer and consumer run over one of the queues.
+ */
+struct _Bench
+{
+	VRing *ring;
+	VAsyncQueue *queue;
+	
+	unsigned int count;
+	uint64_t *sent;
+};
+
+
+
+
+static uint64_t
+get_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+
+static int
+compare (const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+	
+	return x < y ? -1 : x > y;
+}
+
+
+
+
+static void *
+produce (void *data)
+{
+	Bench *bench = (Bench *) data;
+	uintptr_t i;
+	
+	/* items start at 1 since a NULL item can't be queued */
+	for (i = 1; i <= bench->count; i++)
+	{
+		bench->sent[i] = get_time ();
+		
+		if (bench->ring != NULL)
+			v_ring_push_wait (bench->ring, (void *) i);
+		else
+			v_async_queue_enqueue_wait (bench->queue, (void *) i);
+	}
+	
+	return NULL;
+}
+
+
+
+
+/*
+ * run:
+ * @name: the name to report.
+ *
+ * Passes the items from a producer thread to this one, and prints the
+ * throughput and the percentiles of the time each item spent queued.
+ * Exits if an item arrives out of order.
+ */
+static void
+run (const char *name, Bench *bench)
+{
+	uint64_t *latency = malloc (bench->count * sizeof (uint64_t));
+	uint64_t start, end;
+	uintptr_t i, item;
+	pthread_t thread;
+	
+	
+	start = get_time ();
+	pthread_create (&thread, NULL, produce, bench);
+	
+	for (i = 1; i <= bench->count; i++)
+	{
+		if (bench->ring != NULL)
+			item = (uintptr_t) v_ring_pop_wait (bench->ring);
+		else
+			item = (uintptr_t) v_async_queue_dequeue_wait (bench->queue);
+		
+		if (item != i)
+		{
+			printf ("FAIL - %s got item %lu, expected %lu\n", name,
+					(unsigned long) item, (unsigned long) i);
+			
+			/* the producer can't finish once the order is lost */
+			exit (1);
+		}
+		
+		latency[i - 1] = get_time () - bench->sent[i];
+	}
+	
+	end = get_time ();
+	pthread_join (thread, NULL);
+	
+	
+	qsort (latency, bench->count, sizeof (uint64_t), compare);
+	
+	printf ("%-12s%10.2f%10lu%10lu%10lu\n", name,
+			bench->count / ((end - start) / 1000.0),
+			(unsigned long) latency[bench->count / 2],
+			(unsigned long) latency[(uint64_t) bench->count * 99 / 100],
+			(unsigned long) latency[(uint64_t) bench->count * 999 / 1000]);
+	
+	free (latency);
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	unsigned int count = argc > 1 ? atoi (argv[1]) : 1000000;
+	unsigned int depth = argc > 2 ? atoi (argv[2]) : 16;
+	
+	Bench bench;
+	
+	
+	bench.count = count;
+	bench.sent  = malloc ((count + 1) * sizeof (uint64_t));
+	
+	printf ("%u items, depth %u\n", count, depth);
+	printf ("%-12s%10s%10s%10s%10s\n", "", "Mops/s", "p50 ns", "p99 ns", "p99.9 ns");
+	
+	
+	bench.ring  = NULL;
+	bench.queue = v_async_queue_new (depth);
+	
+	run ("VAsyncQueue", &bench);
+	v_async_queue_free (bench.queue);
+	
+	
+	bench.ring  = v_ring_new (depth);
+	bench.queue = NULL;
+	
+	run ("VRing", &bench);
+	v_ring_free (bench.ring);
+	
+	
+	free (bench.sent);
+	
+	return 0;
+}
@@ -0,0 +1,274 @@
+/***************************************************************************
+ *            ring-test.c
+ *
+ *  Mon Oct 19 17:31:08 2026
+ *  Copyright  2026  Goran Sterjov
+ *  <goran.sterjov@gmail.com>
+ ****************************************************************************/
+
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with main.c; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor Boston, MA 02110-1301,  USA
+ */
+
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <villanova-engine/ring.h>
+
+
+
+/* the entries streamed through each ring */
+#define STREAM_COUNT 200000
+
+/* the round trips between two threads each parking on an empty ring */
+#define PING_COUNT 20000
+
+/* a lost wake up leaves a side asleep, so give up after this many seconds */
+#define WATCHDOG 60
+
+
+
+/* entries are counted from 1 since an empty ring returns NULL */
+#define ENTRY(i) ((void *) (uintptr_t) ((i) + 1))
+#define INDEX(p) ((unsigned int) (uintptr_t) (p) - 1)
+
+
+
+typedef struct _Ping Ping;
+
+
+
+/*
+ * Ping:
+ * @there: the ring carrying entries to the other thread.
+ * @back: the ring carrying them back.
+ *
+ * Two rings bouncing an entry between two threads.
+ */
+struct _Ping
+{
+	VRing *there;
+	VRing *back;
+};
+
+
+
+static int failures = 0;
+
+
+
+#define CHECK(cond, ...) \
+	do { \
+		if (!(cond)) \
+		{ \
+			printf ("FAIL - " __VA_ARGS__); \
+			printf ("\n"); \
+			failures++; \
+		} \
+	} while (0)
+
+
+
+
+/*
+ * test_single:
+ *
+ * Checks the ring fills up, keeps its order and honours a reduced size
+ * on a single thread.
+ */
+static void
+test_single (void)
+{
+	VRing *ring = v_ring_new (4);
+	unsigned int i;
+	
+	
+	for (i = 0; i < 4; i++)
+		CHECK (v_ring_push (ring, ENTRY (i)), "push %u into a ring of 4 failed", i);
+	
+	CHECK (!v_ring_push (ring, ENTRY (4)), "pushed into a full ring");
+	CHECK (v_ring_length (ring) == 4, "length %u, expected 4", v_ring_length (ring));
+	
+	for (i = 0; i < 2; i++)
+		CHECK (v_ring_pop (ring) == ENTRY (i), "pop %u out of order", i);
+	
+	
+	/* entries past a reduced size stay until they are taken */
+	v_ring_set_size (ring, 1);
+	
+	CHECK (v_ring_length (ring) == 2, "resizing dropped entries");
+	CHECK (!v_ring_push (ring, ENTRY (4)), "pushed past the reduced size");
+	
+	CHECK (v_ring_pop (ring) == ENTRY (2), "pop 2 out of order");
+	CHECK (v_ring_pop (ring) == ENTRY (3), "pop 3 out of order");
+	CHECK (v_ring_pop (ring) == NULL, "popped from an empty ring");
+	
+	CHECK (v_ring_push (ring, ENTRY (4)), "push into the reduced ring failed");
+	CHECK (!v_ring_push (ring, ENTRY (5)), "pushed past the reduced size");
+	CHECK (v_ring_pop (ring) == ENTRY (4), "pop 4 out of order");
+	
+	v_ring_free (ring);
+}
+
+
+
+
+/*
+ * produce:
+ * @data: a #VRing.
+ *
+ * Streams entries, sleeping whenever the ring is full.
+ */
+static void *
+produce (void *data)
+{
+	VRing *ring = (VRing *) data;
+	unsigned int i;
+	
+	for (i = 0; i < STREAM_COUNT; i++)
+		v_ring_push_wait (ring, ENTRY (i));
+	
+	return NULL;
+}
+
+
+
+
+/*
+ * test_stream:
+ * @size: the size of the ring.
+ *
+ * Checks entries get through in order while both sides keep parking on a
+ * ring that is full or empty most of the time.
+ */
+static void
+test_stream (unsigned int size)
+{
+	VRing *ring = v_ring_new (size);
+	pthread_t thread;
+	void *out[3];
+	unsigned int next = 0, count, i;
+	bool ordered = true;
+	
+	
+	pthread_create (&thread, NULL, produce, ring);
+	
+	while (next < STREAM_COUNT)
+	{
+		/* alternate between single and batched pops */
+		if (next % 2 == 0)
+		{
+			out[0] = v_ring_pop_wait (ring);
+			count = 1;
+		}
+		
+		else
+			count = v_ring_pop_many_wait (ring, out, 3);
+		
+		for (i = 0; i < count; i++)
+			if (INDEX (out[i]) != next++)
+				ordered = false;
+	}
+	
+	pthread_join (thread, NULL);
+	
+	CHECK (ordered, "entries out of order through a ring of %u", size);
+	CHECK (v_ring_pop (ring) == NULL, "entries left in a ring of %u", size);
+	
+	v_ring_free (ring);
+}
+
+
+
+
+/*
+ * pong:
+ * @data: a #Ping.
+ *
+ * Sends every entry straight back.
+ */
+static void *
+pong (void *data)
+{
+	Ping *ping = (Ping *) data;
+	unsigned int i;
+	
+	for (i = 0; i < PING_COUNT; i++)
+		v_ring_push_wait (ping->back, v_ring_pop_wait (ping->there));
+	
+	return NULL;
+}
+
+
+
+
+/*
+ * test_ping:
+ *
+ * Bounces an entry between two threads, so each side sleeps on an empty
+ * ring every round and has to be woken by the other.
+ */
+static void
+test_ping (void)
+{
+	Ping ping = { v_ring_new (1), v_ring_new (1) };
+	pthread_t thread;
+	unsigned int i;
+	bool ordered = true;
+	
+	
+	pthread_create (&thread, NULL, pong, &ping);
+	
+	for (i = 0; i < PING_COUNT; i++)
+	{
+		v_ring_push_wait (ping.there, ENTRY (i));
+		
+		if (v_ring_pop_wait (ping.back) != ENTRY (i))
+			ordered = false;
+	}
+	
+	pthread_join (thread, NULL);
+	
+	CHECK (ordered, "entries came back out of order");
+	
+	v_ring_free (ping.there);
+	v_ring_free (ping.back);
+}
+
+
+
+
+int
+main (int argc, char **argv)
+{
+	/* a side left asleep would hang the test instead of failing it */
+	alarm (WATCHDOG);
+	
+	test_single ();
+	
+	test_stream (1);
+	test_stream (2);
+	test_stream (64);
+	
+	test_ping ();
+	
+	printf ("%d failures\n", failures);
+	
+	return failures > 0;
+}